@@ -1,4 +1,4 @@
-// dstr.h - v0.2 - kevreco - CC0 1.0 Licence (public domain)
+// dstr.h - v0.3 - kevreco - CC0 1.0 Licence (public domain)
 // Close C89 implementation of std::string
 // https://github.com/kevreco/re_lib
 
@@ -7,14 +7,74 @@
 NOTES:
 =====
 
-- Allocators are not implemented.
-   - Only '_dstr_reserve' and 'dstr_clear' contains 'malloc' and 'free'.
+- Allocators:
+   - Memory is allocated with a dstr_allocator, the default one uses 'malloc' and 'free'.
+   - Each thread has a default allocator, see dstr_set_thread_allocator.
+   - An allocator can be attached to a dstr, see dstr_init_with_allocator. Without one, allocations use
+     the thread allocator of the moment, even if the previous buffer came from another allocator.
+   - An owned buffer remembers its allocator, it can be released from any thread.
+   - Strings with an attached allocator have a smaller inline buffer (the allocator is stored inline).
+   - Owned buffers which are not shared are resized with the 'realloc' of their allocator.
+   - dstr_huge_allocator maps large buffers (anonymous mmap), they grow with mremap instead of being copied,
+     transparent huge pages can be requested (see dstr_huge_options). Define DSTR_NO_MMAP to use malloc only.
+     mremap is only available on Linux when _GNU_SOURCE is defined (always with g++), otherwise buffers are copied.
+- Growth:
+   - When a string grows, its capacity is increased by 50% (see dstr_growth_policy and dstr_set_thread_growth_policy).
+   - Each thread has a growth policy, the default one can be changed with DSTR_GROWTH_FACTOR_PERCENT and DSTR_GROWTH_MIN_CAPACITY.
+- Statistics:
+   - Define DSTR_STATS to count allocations, frees, copies made by dstr_reserve, ... per thread (see dstr_get_stats).
+   - Without DSTR_STATS nothing is counted and statistics are always 0.
 - npos (std::string::npos) is NOT taken into account yet.
 - Unit tests are made in ./testsuite/
+- SIMD:
+   - SSE2 is used when available (always on x86-64), AVX2 when compiled with AVX2 enabled (-mavx2, /arch:AVX2).
+   - Define DSTR_NO_SIMD to only use the scalar implementations.
+- ASCII:
+   - Whitespaces are ' ', '\t', '\n', '\v', '\f' and '\r' (like 'isspace' in the "C" locale), whatever the locale.
+   - Case conversions only change 'A'-'Z' and 'a'-'z', other bytes (UTF-8 included) are kept.
+- Small String Optimization (SSO):
+   - sizeof(dstr) is 3 words (24 bytes on 64-bit platforms).
+   - Strings up to DSTR_SSO_CAPACITY - 1 chars are stored inline, without any allocation.
+   - Fields must not be accessed directly, use dstr_data, dstr_size and dstr_capacity.
+   - Inline data lives inside the struct: dstr_data is invalidated when the dstr is moved.
+- Views (dstr_view):
+   - Pointer and size of chars owned by someone else, passed by value, nothing to release.
+   - A view is invalidated when the viewed dstr is modified or moved (inline data), it's not '\0' terminated.
+   - Read-only functions have a view version (dstr_compare_view, dstr_find_view, dstr_starts_with, ...).
+- Shared buffers (copy-on-write):
+   - dstr_make_shared and dstr_assign_shared share an owned buffer instead of copying it, a reference count is incremented.
+   - Define DSTR_SHARED_COPIES to make dstr_copy, dstr_make_from_dstr and dstr_assign_dstr share owned buffers too.
+   - Mutating functions copy a shared buffer first, other strings are never modified.
+   - Reference counts are atomic, strings sharing a buffer can be used and released from different threads.
+   - Writing through dstr_data is only allowed after dstr_unshare.
 
 CHANGES (DD/MM/YYYY):
 ====================
 
+- 16/10/2026 (0.3):
+  - Add Small String Optimization, dstr is now 24 bytes on 64-bit platforms.
+  - Fix non-owned buffers being freed by 'dstr_clear'.
+  - Fix out of bound read in 'dstr_find_dstr' when 'pos' is not 0.
+  - Add dstr_allocator, per thread and per dstr allocators.
+  - 'dstr_assign_*' functions reuse the existing buffer instead of releasing it.
+  - Substring search uses SSE2/AVX2 (filtering on the first and last char of the pattern).
+  - Add dstr_searcher, a pattern preprocessed once to be searched in many strings.
+  - 'dstr_find_and_replace' is linear and returns the number of replacements.
+  - Add dstr_find_and_replace_dstr.
+  - Add integer appends (dstr_append_i64, dstr_append_u64, dstr_append_hex and zero-padded variants).
+  - 'dstr_append_fmt' formats directly in the remaining capacity, vsnprintf is called again only if it does not fit.
+  - Add dstr_assign_fmt, bounded dstr_append_fmtb/dstr_assign_fmtb and va_list variants.
+  - Trim functions use SSE2/AVX2 and ASCII whitespace instead of 'isspace'.
+  - Add dstr_to_lower, dstr_to_upper and dstr_collapse_whitespace.
+  - Add dstr_view, a non-owning (pointer, size) slice, and dstr_substr returning a view.
+  - 'dstr_make_ref' sets the size of the string (it was 0 with the length stored as capacity).
+  - Add copy-on-write shared buffers with atomic reference counts (dstr_make_shared, dstr_assign_shared, DSTR_SHARED_COPIES).
+  - Add dstr_append_many and dstr_join, pieces are appended with a single growth.
+  - Add dstr_growth_policy (factor, minimum capacity, rounding to size classes), per thread.
+  - Add optional statistics (DSTR_STATS): allocations, frees, reserve calls, copied bytes and peak capacity.
+  - 'dstr_reserve' resizes owned buffers with the 'realloc' of their allocator instead of copying them.
+  - Add dstr_huge_allocator, large buffers are mapped and grow with mremap.
+
 - 28/11/2016 (0.2):
   - Make dstr lib C89 compliant.
   - Split dstr_make(size_t capacity) into two other constructor 'dstr_make' and 'dstr_make_reserve'.
@@ -29,23 +89,11 @@ CHANGES (DD/MM/YYYY):
 TODO:
 ====
 
-- Implement STD function:
-  - dstr_substr.
-
-- Implement Extend function:
-  - dstr_assign_fmt
-
-- Find a name for non growing fmt functions (don't realloc if capacity is reached)
-  - dstr_append_fmtb ? format_bounded
-  - dstr_assign_fmtb ? format_bounded
-
 - testsuite:
   - dstr_find
   - dstr_copy
   - dstr_swap
-  - dstr_make_ref
   - dstr_with_buffer
-  - dstr_append_fmt
 
 - Add more "dstr_find_and_replace" functions
 - Add more "dstr_compare" functions
@@ -59,16 +107,88 @@ TODO:
 #ifndef RE_DSTR_H
 #define RE_DSTR_H
 
+// Default growth policy, see dstr_growth_policy
+#ifndef DSTR_GROWTH_FACTOR_PERCENT
+#define DSTR_GROWTH_FACTOR_PERCENT 50
+#endif
+
+#ifndef DSTR_GROWTH_MIN_CAPACITY
+#define DSTR_GROWTH_MIN_CAPACITY 8
+#endif
+
+// Default size from which dstr_huge_allocator maps blocks
+#ifndef DSTR_HUGE_THRESHOLD
+#define DSTR_HUGE_THRESHOLD (32 * 1024 * 1024)
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #include "stdlib.h" // size_t malloc free
 #include "string.h" // strlen, memcpy, memmove, memset
-#include "ctype.h"  // isspace
 #include "assert.h" // assert
 #include <stddef.h> // ptrdiff_t
 #include <stdarg.h> // ..., va_list
+#include <stdio.h>  // vsnprintf
+#include <stdint.h> // int64_t, uint64_t
+
+#ifndef DSTR_NO_SIMD
+#if defined(__AVX2__)
+#define DSTR_AVX2
+#define DSTR_SSE2
+#include <immintrin.h> // AVX2 and SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DSTR_SSE2
+#include <emmintrin.h> // SSE2
+#endif
+#endif
+
+#if defined(_MSC_VER) && defined(DSTR_SSE2)
+#include <intrin.h> // _BitScanForward, _BitScanReverse
+#endif
+
+#if !defined(DSTR_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#include <sys/mman.h> // mmap, mremap, munmap, madvise
+// MAP_ANONYMOUS is missing in strict modes (-std=c99 without _DEFAULT_SOURCE), the malloc path is used instead.
+#ifdef MAP_ANONYMOUS
+#define DSTR_MMAP
+#include <unistd.h>   // sysconf
+#endif
+#endif
+
+// Define it if your compiler does not support thread local storage or to use another keyword.
+#ifndef DSTR_THREAD_LOCAL
+#if defined(_MSC_VER)
+#define DSTR_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__) || defined(__clang__)
+#define DSTR_THREAD_LOCAL __thread
+#else
+#define DSTR_THREAD_LOCAL
+#endif
+#endif
+
+// Atomic operations on the reference count of shared buffers.
+// Define them if your compiler is not supported, otherwise shared buffers are not thread safe.
+#ifndef DSTR_ATOMIC_INCREMENT
+#if defined(__GNUC__) || defined(__clang__)
+typedef size_t dstr_refcount_t;
+#define DSTR_ATOMIC_LOAD(ptr)      __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define DSTR_ATOMIC_INCREMENT(ptr) __atomic_add_fetch(ptr, 1, __ATOMIC_RELAXED)
+#define DSTR_ATOMIC_DECREMENT(ptr) __atomic_sub_fetch(ptr, 1, __ATOMIC_ACQ_REL)
+#elif defined(_MSC_VER)
+#include <intrin.h> // _InterlockedIncrement, _InterlockedDecrement, _InterlockedOr
+typedef long dstr_refcount_t;
+#define DSTR_ATOMIC_LOAD(ptr)      _InterlockedOr(ptr, 0)
+#define DSTR_ATOMIC_INCREMENT(ptr) _InterlockedIncrement(ptr)
+#define DSTR_ATOMIC_DECREMENT(ptr) _InterlockedDecrement(ptr)
+#else
+typedef size_t dstr_refcount_t;
+#define DSTR_ATOMIC_LOAD(ptr)      (*(ptr))
+#define DSTR_ATOMIC_INCREMENT(ptr) (++*(ptr))
+#define DSTR_ATOMIC_DECREMENT(ptr) (--*(ptr))
+#endif
+#endif
 
 //-------------------------------------------------------------------------
 // dstr - STD API - BEGIN
@@ -78,15 +198,49 @@ typedef size_t dstr_size_t; // Not used yet
 typedef char dstr_char_t;
 typedef dstr_char_t* dstr_it;
 
+// Sizes are always given back to the allocator, blocks don't need to be tagged by the allocator.
+typedef struct dstr_allocator {
+    // Returns a block of 'size' bytes, or 0 on failure.
+    void* (*alloc)(void* user_data, size_t size);
+    // Resizes a block, content is kept up to the smallest size. Returns 0 on failure.
+    void* (*realloc)(void* user_data, void* ptr, size_t old_size, size_t new_size);
+    // Releases a block of 'size' bytes.
+    void  (*free)(void* user_data, void* ptr, size_t size);
+    void* user_data;
+} dstr_allocator;
+
+// Layout:
+// - Small: chars are stored inline in 'small', the last byte contains
+//          the remaining capacity (it becomes the '\0' when the string is full).
+//          With an attached allocator, the allocator pointer is stored before the last byte.
+// - Large: 'data' points to a heap buffer or to a non-owned buffer.
+//          Two bits of 'capacity' (the ones sharing the last byte) contain the category.
+//          Heap buffers are preceded by a header containing their allocator and reference count.
+// Use the accessors (dstr_data, dstr_size, dstr_capacity) instead of the fields.
 typedef struct dstr {
-    size_t size;
-    size_t capacity;
-    dstr_char_t* data;
-    dstr_char_t* non_owned_buffer;
+    union {
+        struct {
+            dstr_char_t* data;
+            size_t size;
+            size_t capacity;
+        } large;
+        dstr_char_t small[sizeof(dstr_char_t*) + sizeof(size_t) * 2];
+    } u;
 } dstr;
 
+enum {
+    // Number of bytes (including '\0') stored inline
+    DSTR_SSO_CAPACITY = sizeof(dstr)
+};
+
+// Non-owning slice of chars (see NOTES)
+typedef struct dstr_view {
+    const dstr_char_t* data;
+    size_t size;
+} dstr_view;
 
 void dstr_init(dstr* s);
+// Releases memory, an attached allocator is kept.
 void dstr_clear(dstr* s);
 
 /// Constructor
@@ -111,15 +265,16 @@ dstr_char_t dstr_at(const dstr* s, size_t index);
 // Access specified character
 dstr_char_t dstr_get(const dstr* s, size_t index);
 // Returns a pointer to the first character of a string
-inline dstr_char_t* dstr_data(dstr* s) { return s->data; }
+dstr_char_t* dstr_data(const dstr* s);
 // Returns a non-modifiable standard C character array version of the string
-inline dstr_char_t* dstr_c_str(dstr* s) { return s->data; }
+dstr_char_t* dstr_c_str(const dstr* s);
 
 //If new_cap is greater than the current capacity(), new storage is allocated, and capacity() is made equal or greater than new_cap.
 //If new_cap is less than the current capacity(), this is a non-binding shrink request.
 //If new_cap is less than the current size(), this is a non-binding shrink-to-fit request equivalent to shrink_to_fit() (since C++11). // @TODO Implement this
+//Capacity is never less than DSTR_SSO_CAPACITY, the inline buffer is used instead.
 // @TODO testsuite
-inline void dstr_reserve(dstr* s, size_t capacity);
+void dstr_reserve(dstr* s, size_t capacity);
 
 // Appends dstr
 void dstr_append_dstr(dstr* s, const dstr* dstr);
@@ -160,14 +315,14 @@ int dstr_compare_str(const dstr* s, const dstr_char_t* str);
 
 // Reduces memory usage by freeing unused memory
 void   dstr_shrink_to_fit(dstr* s);
-inline int    dstr_empty(const dstr* s) { return !s->size; }
-inline size_t dstr_size(const dstr* s) { return s->size; }
-inline size_t dstr_length(const dstr* s) { return s->size; }
-inline size_t dstr_capacity(const dstr* s) { return s->capacity; }
+int    dstr_empty(const dstr* s);
+size_t dstr_size(const dstr* s);
+size_t dstr_length(const dstr* s);
+size_t dstr_capacity(const dstr* s);
 
 // Iterators
-inline dstr_it dstr_begin(const dstr* s) { return s->data; }
-inline dstr_it dstr_end(const dstr* s)   { return s->data + s->size; }
+dstr_it dstr_begin(const dstr* s);
+dstr_it dstr_end(const dstr* s);
 
 // @TODO use size_t index
 dstr_it dstr_insert(dstr* s, const dstr_it index, const dstr_char_t value);
@@ -186,17 +341,15 @@ void dstr_replace_with_dstr(dstr* s, size_t index, size_t count, const dstr* rep
 void dstr_replace_with_str(dstr* s, size_t index, size_t count, const dstr_char_t* replacing);
 void dstr_replace_with_nchar(dstr* s, size_t index, size_t count, dstr_char_t ch, size_t ch_count);
 
-// @TODO implement this
-// @TODO suitetest
 // Returns position of the first character of the found substring or npos if no such substring is found.
 size_t dstr_find_dstr(const dstr* s, size_t index, const dstr* sub);
 //void dstr_find_str(const );
 //void dstr_find_char();
 //void dstr_find_nchar();
 
-// @TODO implement this
-// @TODO suitetest
-//void dstr_substr();
+// Returns a view of [pos, pos + count), nothing is copied.
+// 'count' is reduced to the end of the string (DSTR_NPOS for the rest of the string).
+dstr_view dstr_substr(const dstr* s, size_t pos, size_t count);
 
 void dstr_copy(const dstr* s, dstr* other);
 void dstr_swap(dstr* s, dstr* other);
@@ -209,24 +362,237 @@ void dstr_swap(dstr* s, dstr* other);
 // dstr - Extended API - BEGIN
 //-------------------------------------------------------------------------
 
+/// Allocator
+
+// Allocator based on malloc, realloc and free
+extern const dstr_allocator dstr_malloc_allocator;
+
+// Allocator used by strings without attached allocator on the current thread.
+// Never returns 0.
+const dstr_allocator* dstr_get_thread_allocator();
+// Set 0 to restore the malloc allocator.
+// Strings allocated with the previous allocator keep using it.
+void dstr_set_thread_allocator(const dstr_allocator* allocator);
+
+// Empty string with an attached allocator, it's kept by dstr_clear and dstr_shrink_to_fit.
+// The allocator stays attached even if it's also the thread allocator, 0 is the same as dstr_init.
+void dstr_init_with_allocator(dstr* s, const dstr_allocator* allocator);
+// Empty string with an attached allocator and 'capacity' capacity
+dstr dstr_make_with_allocator(size_t capacity, const dstr_allocator* allocator);
+// Returns the allocator used by the next allocation of 's'
+const dstr_allocator* dstr_get_allocator(const dstr* s);
+// Returns the attached allocator, 0 if 's' uses the thread allocator
+const dstr_allocator* dstr_get_attached_allocator(const dstr* s);
+
+/// Huge strings
+
+typedef struct dstr_huge_options {
+    size_t threshold;  // Blocks of at least 'threshold' bytes are mapped, smaller ones use malloc
+    int huge_pages;    // Requests transparent huge pages for mapped blocks (madvise MADV_HUGEPAGE)
+} dstr_huge_options;
+
+// DSTR_HUGE_THRESHOLD, huge pages requested
+extern const dstr_huge_options dstr_default_huge_options;
+// Allocator using dstr_default_huge_options.
+// Use dstr_make_huge_allocator for other options.
+extern const dstr_allocator dstr_huge_allocator;
+
+// 'options' is not copied, it must outlive the strings using the allocator.
+dstr_allocator dstr_make_huge_allocator(const dstr_huge_options* options);
+
+/// Growth policy
+
+// Capacity given to a string when it needs to grow:
+// the greatest of the needed capacity, the increased capacity and 'min_capacity'.
+typedef struct dstr_growth_policy {
+    size_t factor_percent;    // Capacity increase, in percent of the current capacity
+    size_t min_capacity;      // Smallest allocated capacity
+    int round_to_size_class;  // Rounds allocated blocks (header included) up to a power of two, like malloc bins and dstr_cache
+} dstr_growth_policy;
+
+// DSTR_GROWTH_FACTOR_PERCENT, DSTR_GROWTH_MIN_CAPACITY, no rounding
+extern const dstr_growth_policy dstr_default_growth_policy;
+
+// Policy used on the current thread, never returns 0.
+const dstr_growth_policy* dstr_get_thread_growth_policy();
+// Set 0 to restore the default policy. The policy is not copied.
+void dstr_set_thread_growth_policy(const dstr_growth_policy* policy);
+
+/// Statistics
+
+// Counters of the current thread, only incremented if DSTR_STATS is defined.
+typedef struct dstr_stats {
+    size_t allocations;    // Owned buffers allocated
+    size_t frees;          // Owned buffers freed
+    size_t reallocations;  // Owned buffers resized by the allocator (realloc), they are not counted as copies
+    size_t reserve_calls;  // Calls to dstr_reserve, growths included
+    size_t copied_bytes;   // Bytes copied to a new buffer (growth, shrink, copy of a shared buffer)
+    size_t peak_capacity;  // Largest capacity allocated
+} dstr_stats;
+
+void dstr_get_stats(dstr_stats* stats);
+void dstr_reset_stats();
+// Prints the statistics of the current thread.
+void dstr_dump_stats(FILE* out);
+
+/// Shared buffers
+
+// Shares the owned buffer of 'other' (see NOTES), inline and non-owned buffers are copied.
+dstr dstr_make_shared(const dstr* other);
+// Replaces the contents with the buffer of 'other', shared like dstr_make_shared.
+// 's' then uses the allocator of the shared buffer.
+void dstr_assign_shared(dstr* s, const dstr* other);
+// Returns 1 if the owned buffer is shared with other strings.
+int  dstr_is_shared(const dstr* s);
+// Copies the buffer if it's shared, mutating functions already do it.
+void dstr_unshare(dstr* s);
+
+/// View
+
+dstr_view dstr_view_make(const dstr_char_t* data, size_t size);
+dstr_view dstr_view_make_from_str(const dstr_char_t* str);
+dstr_view dstr_view_make_from_dstr(const dstr* s);
+
+// Sub-views, 'pos' and 'count' are reduced to the size of the view.
+dstr_view dstr_view_substr(dstr_view v, size_t pos, size_t count);
+dstr_view dstr_view_prefix(dstr_view v, size_t count);
+dstr_view dstr_view_suffix(dstr_view v, size_t count);
+
+// Same order as dstr_compare_dstr
+int    dstr_view_compare(dstr_view v, dstr_view other);
+int    dstr_view_equals(dstr_view v, dstr_view other);
+int    dstr_view_starts_with(dstr_view v, dstr_view prefix);
+int    dstr_view_ends_with(dstr_view v, dstr_view suffix);
+// Returns position of the first occurrence starting at or after 'pos' or DSTR_NPOS.
+size_t dstr_view_find(dstr_view v, size_t pos, dstr_view sub);
+size_t dstr_view_find_char(dstr_view v, size_t pos, dstr_char_t ch);
+
+// Views without leading and/or trailing ASCII whitespaces
+dstr_view dstr_view_trim(dstr_view v);
+dstr_view dstr_view_ltrim(dstr_view v);
+dstr_view dstr_view_rtrim(dstr_view v);
+
+// dstr functions taking a view, the view can point inside 's'.
+dstr   dstr_make_from_view(dstr_view v);
+void   dstr_append_view(dstr* s, dstr_view v);
+void   dstr_assign_view(dstr* s, dstr_view v);
+int    dstr_compare_view(const dstr* s, dstr_view v);
+size_t dstr_find_view(const dstr* s, size_t pos, dstr_view sub);
+int    dstr_starts_with(const dstr* s, dstr_view prefix);
+int    dstr_ends_with(const dstr* s, dstr_view suffix);
+// Trimmed view of 's', 's' is not modified.
+dstr_view dstr_trim_view(const dstr* s);
+
+/// Batch append
+
+// Appends all pieces: sizes are summed first, the buffer grows once and each piece is copied once.
+// Pieces can point inside 's'.
+void dstr_append_many(dstr* s, const dstr_view* pieces, size_t count);
+void dstr_append_many_dstr(dstr* s, const dstr* pieces, size_t count);
+// Same as above with 'separator' between pieces, 's' is not cleared first.
+void dstr_join(dstr* s, dstr_view separator, const dstr_view* pieces, size_t count);
+void dstr_join_dstr(dstr* s, dstr_view separator, const dstr* pieces, size_t count);
+
+/// Searcher
+
+// Preprocessed factorization and skip table of a pattern (see _dstr_two_way_init)
+typedef struct _dstr_two_way {
+    size_t critical; // Start of the right part of the pattern
+    size_t period;   // Shift applied after a full match
+    size_t memory;   // Size of the prefix known to match after a shift of 'period', 0 if not periodic
+    size_t skip[256];
+} _dstr_two_way;
+
+// Pattern preprocessed once, to be searched in many strings.
+// - Two-Way algorithm: linear time in the worst case, no allocation while searching.
+// - Horspool skip table on the last char of the window.
+// - Patterns shorter than DSTR_SEARCHER_LONG_PATTERN are searched forward with _dstr_memory_find.
+// An empty pattern is never found.
+typedef struct dstr_searcher {
+    dstr pattern;
+    _dstr_two_way forward;
+    _dstr_two_way backward;
+} dstr_searcher;
+
+enum {
+    DSTR_SEARCHER_LONG_PATTERN = 32
+};
+
+// Copies the pattern
+void   dstr_searcher_init(dstr_searcher* searcher, const dstr_char_t* pattern, size_t pattern_size);
+void   dstr_searcher_clear(dstr_searcher* searcher);
+
+// Returns position of the first occurrence starting at or after 'pos' or DSTR_NPOS.
+size_t dstr_searcher_find(const dstr_searcher* searcher, const dstr* s, size_t pos);
+// Returns position of the last occurrence starting at or before 'pos' (DSTR_NPOS to search the whole string) or DSTR_NPOS.
+size_t dstr_searcher_rfind(const dstr_searcher* searcher, const dstr* s, size_t pos);
+// Writes the positions of non-overlapping occurrences, starting at or after 'pos', in 'positions'.
+// Stops when 'max_count' positions are written. Returns the number of positions written.
+size_t dstr_searcher_find_all(const dstr_searcher* searcher, const dstr* s, size_t pos, size_t* positions, size_t max_count);
+
+// Same as above on the range [first, last), positions are relative to 'first'.
+size_t dstr_searcher_find_range(const dstr_searcher* searcher, const dstr_it first, const dstr_it last);
+size_t dstr_searcher_rfind_range(const dstr_searcher* searcher, const dstr_it first, const dstr_it last);
+size_t dstr_searcher_find_all_range(const dstr_searcher* searcher, const dstr_it first, const dstr_it last, size_t* positions, size_t max_count);
+
+/// ASCII transforms
+
+// Removes leading and/or trailing ASCII whitespaces.
 void dstr_trim(dstr *s);
 void dstr_ltrim(dstr* s);
 void dstr_rtrim(dstr* s);
+// Trims, then replaces each remaining run of whitespaces with a single ' '.
+void dstr_collapse_whitespace(dstr* s);
 
-// @TODO more testsuite
-void dstr_find_and_replace(dstr* s, const dstr_char_t* to_replaced, const dstr_char_t* with);
-//@TODO Implement this
-//@TODO testsuite
-//int dstr_assign_fmt(dstr* s, const char* fmt, ...);
+// ASCII case conversion, in place.
+void dstr_to_lower(dstr* s);
+void dstr_to_upper(dstr* s);
+
+// Replaces all non-overlapping occurrences, returns the number of replacements.
+// Linear time: if 'with' is not longer than 'to_replaced' it's done in place,
+// otherwise occurrences are counted first and the result is allocated once.
+size_t dstr_find_and_replace(dstr* s, const dstr_char_t* to_replaced, const dstr_char_t* with);
+size_t dstr_find_and_replace_dstr(dstr* s, const dstr* to_replaced, const dstr* with);
+
+/// Format
 
-// @TODO suitetest
+// Formats with vsnprintf, returns the size of the formatted string or a negative value on error.
+// Formatting is done directly in the remaining capacity, it's done a second time only if it does not fit.
+// Arguments must not point inside 's'.
 int dstr_append_fmt(dstr* s, const char* fmt, ...);
+int dstr_assign_fmt(dstr* s, const char* fmt, ...);
+int dstr_append_vfmt(dstr* s, const char* fmt, va_list args);
+int dstr_assign_vfmt(dstr* s, const char* fmt, va_list args);
+
+// Bounded versions: never allocate, the result is truncated to the current capacity.
+// Nothing is written into a shared buffer (it would have to be copied first), the size is still returned.
+// Returns the size of the complete formatted string (like snprintf) or a negative value on error,
+// the result is truncated if it's greater than the number of chars written.
+int dstr_append_fmtb(dstr* s, const char* fmt, ...);
+int dstr_assign_fmtb(dstr* s, const char* fmt, ...);
+int dstr_append_vfmtb(dstr* s, const char* fmt, va_list args);
+int dstr_assign_vfmtb(dstr* s, const char* fmt, va_list args);
+
+/// Integer append
+
+// Appends the decimal representation of 'value', without going through printf.
+// One capacity check per call, digits are written two at a time from a table.
+void dstr_append_i64(dstr* s, int64_t value);
+void dstr_append_u64(dstr* s, uint64_t value);
+// Appends the lowercase hexadecimal representation of 'value', without prefix.
+void dstr_append_hex(dstr* s, uint64_t value);
+
+// Same as above, digits are padded with '0' to 'width' chars (the sign is included in 'width').
+// Nothing is truncated if the value needs more than 'width' chars.
+void dstr_append_i64_padded(dstr* s, int64_t value, size_t width);
+void dstr_append_u64_padded(dstr* s, uint64_t value, size_t width);
+void dstr_append_hex_padded(dstr* s, uint64_t value, size_t width);
 
 typedef const dstr dstr_ref;
 // Ref
 // Non-owning reference to a string, the result is a const dstr
 // No need to call dstr_clear
-//@TODO testsuite
+// Prefer dstr_view when a dstr is not needed.
 dstr_ref dstr_make_ref(const dstr_char_t* str);
 
 // Non-owning reference with buffer.
@@ -243,11 +609,111 @@ dstr dstr_make_with_buffer(const dstr_char_t* buffer, size_t capacity);
 // dstr - Private - BEGIN
 //-------------------------------------------------------------------------
 
-int    _dstr_allocated_data(dstr* s);
+// Storage category, stored in two bits of the last byte of the dstr
+enum {
+    _DSTR_SMALL           = 0, // inline buffer
+    _DSTR_SMALL_ALLOCATOR = 1, // inline buffer followed by an allocator pointer
+    _DSTR_EXTERNAL        = 2, // non-owned buffer (dstr_make_ref, dstr_make_with_buffer)
+    _DSTR_HEAP            = 3  // owned buffer
+};
+
+// Header of owned buffers
+typedef struct _dstr_block {
+    const dstr_allocator* allocator;
+    dstr_refcount_t refcount; // Number of strings using the buffer
+} _dstr_block;
+
+int    _dstr_category(const dstr* s);
+int    _dstr_is_small(const dstr* s);
+int    _dstr_allocated_data(const dstr* s);
+// Allocator of the owned buffer
+const dstr_allocator* _dstr_block_allocator(const dstr_char_t* data);
+// Sets the size and writes the '\0'
+void   _dstr_set_size(dstr* s, size_t size);
+void   _dstr_set_small(dstr* s, size_t size);
+// 'attached' is stored inline if it's not 0.
+void   _dstr_set_small_with_allocator(dstr* s, size_t size, const dstr_allocator* attached);
+void   _dstr_set_large(dstr* s, dstr_char_t* data, size_t size, size_t capacity, int category);
+// Owned buffer, 'attached' (0 if none) must be the allocator of the buffer.
+void   _dstr_set_heap(dstr* s, dstr_char_t* data, size_t size, size_t capacity, const dstr_allocator* attached);
+// Inline capacity available for a string with the 'attached' allocator (0 if none)
+size_t _dstr_small_capacity(const dstr_allocator* attached);
+
+// Allocates an owned buffer of 'capacity' chars
+dstr_char_t* _dstr_allocate(const dstr_allocator* allocator, size_t capacity);
+// Functions of dstr_huge_allocator, 'user_data' points to dstr_huge_options (0 for the default options).
+void*  _dstr_huge_alloc(void* user_data, size_t size);
+void*  _dstr_huge_realloc(void* user_data, void* ptr, size_t old_size, size_t new_size);
+void   _dstr_huge_free(void* user_data, void* ptr, size_t size);
+#ifdef DSTR_MMAP
+// Size of the mapping of a block
+size_t _dstr_huge_mapped_size(size_t size);
+// Anonymous read-write mapping, 0 on failure.
+void*  _dstr_huge_map(const dstr_huge_options* options, size_t mapped_size);
+#endif
+
+// Resizes an owned buffer which is not shared, returns its new location.
+dstr_char_t* _dstr_reallocate(dstr_char_t* data, size_t old_capacity, size_t new_capacity);
+// Releases a reference to an owned buffer of 'capacity' chars, the last one frees it.
+void   _dstr_deallocate(dstr_char_t* data, size_t capacity);
+// Gives 's' its own copy of a shared buffer, the capacity is kept.
+void   _dstr_unshare(dstr* s);
+// Sets the size to 0, a shared buffer is released instead of being copied.
+void   _dstr_discard(dstr* s);
 
 size_t _dstr_growing_policy(dstr* s, size_t capacity);
 // Find a memory block
 void*  _dstr_memory_find(const void *memory_ptr, size_t mem_len, const void *pattern_ptr, size_t pattern_len);
+// Implementations of _dstr_memory_find, they expect 1 < pattern_len <= mem_len.
+void*  _dstr_memory_find_scalar(const char* mem_ptr, size_t mem_len, const char* patt_ptr, size_t pattern_len);
+#ifdef DSTR_SSE2
+void*  _dstr_memory_find_sse2(const char* mem_ptr, size_t mem_len, const char* patt_ptr, size_t pattern_len);
+#endif
+#ifdef DSTR_AVX2
+void*  _dstr_memory_find_avx2(const char* mem_ptr, size_t mem_len, const char* patt_ptr, size_t pattern_len);
+#endif
+#ifdef DSTR_SSE2
+// Index of the lowest bit set, 'mask' can't be 0
+unsigned int _dstr_bit_scan_forward(unsigned int mask);
+#endif
+
+// Critical factorization of the pattern, read backward if 'reverse' is not 0.
+void   _dstr_two_way_init(_dstr_two_way* tw, const unsigned char* pattern, size_t pattern_size, int reverse);
+// Maximal suffix of the pattern for the order (or the inverted order), returns its start and writes its period.
+size_t _dstr_maximal_suffix(const unsigned char* pattern, size_t pattern_size, int reverse, int inverted, size_t* period);
+// Returns the first (or last) occurrence of the pattern in [first, last) or 0.
+const dstr_char_t* _dstr_two_way_find(const _dstr_two_way* tw, const unsigned char* pattern, size_t pattern_size, const unsigned char* first, const unsigned char* last);
+const dstr_char_t* _dstr_two_way_rfind(const _dstr_two_way* tw, const unsigned char* pattern, size_t pattern_size, const unsigned char* first, const unsigned char* last);
+
+// ASCII whitespace (see NOTES)
+int    _dstr_is_space(dstr_char_t ch);
+// Index of the first whitespace (or the first non-whitespace if 'not_space' is not 0), 'size' if there is none.
+size_t _dstr_find_space(const dstr_char_t* data, size_t size, int not_space);
+// Size of the data once trailing whitespaces are removed.
+size_t _dstr_rtrimmed_size(const dstr_char_t* data, size_t size);
+// Flips the case of chars in ['first', 'first' + 25], 'first' is 'A' or 'a'.
+void   _dstr_flip_ascii_case(dstr_char_t* data, size_t size, dstr_char_t first);
+#ifdef DSTR_SSE2
+// Bit 'i' is set if the char 'i' is a whitespace.
+unsigned int _dstr_space_mask_sse2(const dstr_char_t* data);
+// Index of the highest bit set, 'mask' can't be 0
+unsigned int _dstr_bit_scan_reverse(unsigned int mask);
+#endif
+#ifdef DSTR_AVX2
+unsigned int _dstr_space_mask_avx2(const dstr_char_t* data);
+#endif
+
+// Number of decimal (or hexadecimal) digits of 'value', at least 1.
+size_t _dstr_digit_count(uint64_t value);
+size_t _dstr_hex_digit_count(uint64_t value);
+// Writes the digits of 'value' backward, 'end' is one past the last digit.
+void   _dstr_write_digits(dstr_char_t* end, uint64_t value);
+void   _dstr_write_hex_digits(dstr_char_t* end, uint64_t value);
+// Appends 'sign' (if not 0), then the digits of 'value' padded with '0' to 'width' chars.
+void   _dstr_append_integer(dstr* s, uint64_t value, dstr_char_t sign, size_t width, int hex);
+
+// Appends 'views' (or 'dstrs' if 'views' is 0) separated by 'separator'.
+void   _dstr_append_pieces(dstr* s, dstr_view separator, const dstr_view* views, const dstr* dstrs, size_t count);
 
 //-------------------------------------------------------------------------
 // dstr - Private - END
@@ -260,35 +726,82 @@ enum {
     DSTR_NPOS = (size_t)-1
 };
 
-#define _DSTR_MIN_ALLOC 8
+#ifdef DSTR_STATS
+#define _DSTR_STATS_ADD(field, count) (_dstr_thread_stats.field += (count))
+#define _DSTR_STATS_MAX(field, value) \
+    if ((value) > _dstr_thread_stats.field) { _dstr_thread_stats.field = (value); }
+#else
+#define _DSTR_STATS_ADD(field, count)
+#define _DSTR_STATS_MAX(field, value)
+#endif
+
+// The last byte of a dstr is the most significant byte of 'capacity' on little-endian platforms
+// and the least significant one on big-endian platforms.
+// Define DSTR_BIG_ENDIAN if your compiler does not provide __BYTE_ORDER__.
+#if !defined(DSTR_BIG_ENDIAN) && defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__)
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define DSTR_BIG_ENDIAN
+#endif
+#endif
+
+// Large strings also use a bit of 'capacity' next to the category: the allocator of the owned buffer is attached.
+#ifdef DSTR_BIG_ENDIAN
+#define _DSTR_TAG_TO_CATEGORY(tag)           ((tag) & 0x3)
+#define _DSTR_TAG_TO_SMALL_REMAINING(tag)    ((tag) >> 2)
+#define _DSTR_SMALL_TAG(cat, rem)            ((dstr_char_t)(((rem) << 2) | (cat)))
+#define _DSTR_ATTACHED_BIT                   ((size_t)1 << 2)
+#define _DSTR_CAPACITY_DECODE(cap)           ((cap) >> 3)
+#define _DSTR_CAPACITY_ENCODE(cap, cat)      (((cap) << 3) | (size_t)(cat))
+#else
+#define _DSTR_CATEGORY_SHIFT                 (sizeof(size_t) * 8 - 2)
+#define _DSTR_TAG_TO_CATEGORY(tag)           ((tag) >> 6)
+#define _DSTR_TAG_TO_SMALL_REMAINING(tag)    ((tag) & 0x3F)
+#define _DSTR_SMALL_TAG(cat, rem)            ((dstr_char_t)(((cat) << 6) | (rem)))
+#define _DSTR_ATTACHED_BIT                   ((size_t)1 << (_DSTR_CATEGORY_SHIFT - 1))
+#define _DSTR_CAPACITY_DECODE(cap)           ((cap) & (_DSTR_ATTACHED_BIT - 1))
+#define _DSTR_CAPACITY_ENCODE(cap, cat)      ((cap) | ((size_t)(cat) << _DSTR_CATEGORY_SHIFT))
+#endif
 
-// Shared default value to ensure that s->data is always valid with a '\0' char at initialization
-char _DSTR_DEFAULT_DATA[1] = {'\0'};
+#define _DSTR_TAG(s) (((const unsigned char*)(s))[DSTR_SSO_CAPACITY - 1])
+
+// Inline capacity when an allocator pointer is stored before the tag
+#define _DSTR_SSO_ALLOCATOR_CAPACITY (DSTR_SSO_CAPACITY - 1 - sizeof(const dstr_allocator*))
+#define _DSTR_SSO_ALLOCATOR_OFFSET   _DSTR_SSO_ALLOCATOR_CAPACITY
+
+static DSTR_THREAD_LOCAL const dstr_allocator* _dstr_thread_allocator = 0;
+static DSTR_THREAD_LOCAL const dstr_growth_policy* _dstr_thread_growth_policy = 0;
+static DSTR_THREAD_LOCAL dstr_stats _dstr_thread_stats;
 
 #define _DSTR_GROW(s, needed) \
     dstr_reserve(s, _dstr_growing_policy(s, needed));
 
+// A shared buffer is replaced by the growth, otherwise it's copied.
 #define _DSTR_GROW_IF_NEEDED(s, needed) \
-    if (needed > s->capacity) {         \
+    if (needed > dstr_capacity(s)) {    \
     _DSTR_GROW(s, needed)               \
+} else if (dstr_is_shared(s)) {         \
+    _dstr_unshare(s);                   \
+}
+
+#define _DSTR_UNSHARE_IF_NEEDED(s) \
+    if (dstr_is_shared(s)) {       \
+    _dstr_unshare(s);              \
 }
 
 inline void dstr_init(dstr* s) {
 
-    s->size = 0;
-    s->capacity = 0;
-    s->data = _DSTR_DEFAULT_DATA;
-    s->non_owned_buffer = _DSTR_DEFAULT_DATA;
+    _dstr_set_small(s, 0);
 
 } // dstr_init
 
 inline void dstr_clear(dstr* s) {
 
-    // dstr is initialized
+    const dstr_allocator* attached = dstr_get_attached_allocator(s);
+
     if (_dstr_allocated_data(s)) {
-        free(s->data);
+        _dstr_deallocate(s->u.large.data, dstr_capacity(s));
     }
-    dstr_init(s);
+    _dstr_set_small_with_allocator(s, 0, attached);
 
 } // dstr_clear
 
@@ -342,179 +855,231 @@ inline dstr dstr_make_from_nchar(size_t count, dstr_char_t ch) {
 
 inline dstr dstr_make_from_range(const dstr_it first, const dstr_it last) {
     dstr result;
-    
+
     dstr_init(&result);
     dstr_assign_range(&result, first, last);
 
     return result;
 } // dstr_make_from_range
 
+inline dstr_char_t dstr_at(const dstr* s, size_t index) {
+    assert(index < dstr_size(s));
+
+    return dstr_data(s)[index];
+} // dstr_at
+
+inline dstr_char_t dstr_get(const dstr* s, size_t index) {
+    return dstr_data(s)[index];
+} // dstr_get
+
+inline dstr_char_t* dstr_data(const dstr* s) {
+    return _dstr_is_small(s)
+        ? (dstr_char_t*)s->u.small
+        : s->u.large.data;
+} // dstr_data
+
+inline dstr_char_t* dstr_c_str(const dstr* s) {
+    return dstr_data(s);
+} // dstr_c_str
+
 void dstr_reserve(dstr* s, size_t new_capacity) {
 
-    if (!s->size && new_capacity == 0) {
+    size_t size = dstr_size(s);
+
+    _DSTR_STATS_ADD(reserve_calls, 1);
+
+    if (!size && new_capacity == 0) {
         dstr_clear(s);
-    } else if (new_capacity != s->capacity) {
-
-        size_t str_capacity_needed = s->size + 1;// +1 for '\0';
-        size_t capacity_needed;
-        if (new_capacity > s->capacity) {
-            // + 1 for '\0'
-            capacity_needed = new_capacity;
-        } else if (new_capacity < str_capacity_needed) {
-            capacity_needed = str_capacity_needed;
+    } else if (new_capacity != dstr_capacity(s)) {
+
+        size_t str_capacity_needed = size + 1;// +1 for '\0';
+        size_t capacity_needed = new_capacity < str_capacity_needed
+            ? str_capacity_needed
+            : new_capacity;
+
+        const dstr_allocator* attached = dstr_get_attached_allocator(s);
+        const dstr_allocator* allocator = attached ? attached : dstr_get_thread_allocator();
+        dstr_char_t* old_data = dstr_data(s);
+        size_t old_capacity = dstr_capacity(s);
+        int old_allocated = _dstr_allocated_data(s);
+
+        if (capacity_needed <= _dstr_small_capacity(attached)) {
+
+            // If already inline, only the category can change.
+            if (!_dstr_is_small(s)) {
+                // 'old_data' is not inside 's', it can't be overwritten.
+                memcpy(s->u.small, old_data, size * sizeof(dstr_char_t));
+                _DSTR_STATS_ADD(copied_bytes, size * sizeof(dstr_char_t));
+            }
+            _dstr_set_small_with_allocator(s, size, attached);
+
+        } else if (old_allocated && !dstr_is_shared(s) && _dstr_block_allocator(old_data) == allocator) {
+
+            // The allocator may resize the block in place (or remap it), the content is kept.
+            dstr_char_t* new_data = _dstr_reallocate(old_data, old_capacity, capacity_needed);
+
+            _dstr_set_heap(s, new_data, size, capacity_needed, attached);
+            old_allocated = 0;
+
         } else {
-            capacity_needed = new_capacity;
-        }
 
-        dstr_char_t* new_data = (dstr_char_t*)malloc(capacity_needed * sizeof(dstr_char_t));
+            dstr_char_t* new_data = _dstr_allocate(allocator, capacity_needed);
 
-        memcpy(new_data, s->data, str_capacity_needed * sizeof(dstr_char_t));
+            memcpy(new_data, old_data, str_capacity_needed * sizeof(dstr_char_t));
+            _DSTR_STATS_ADD(copied_bytes, str_capacity_needed * sizeof(dstr_char_t));
 
-        // dstr is initialized
-        if (_dstr_allocated_data(s)) {
-            free(s->data);
+            _dstr_set_heap(s, new_data, size, capacity_needed, attached);
         }
 
-        s->data = new_data;
-        s->capacity = capacity_needed;
+        if (old_allocated) {
+            _dstr_deallocate(old_data, old_capacity);
+        }
     }
 } // dstr_reserve
 
 void dstr_append_dstr(dstr* s, const dstr* other) {
 
-    size_t capacity_needed = s->size + other->size + 1; // +1 for '\0'
+    size_t size = dstr_size(s);
+    size_t other_size = dstr_size(other);
+    size_t capacity_needed = size + other_size + 1; // +1 for '\0'
 
     _DSTR_GROW_IF_NEEDED(s, capacity_needed);
 
-    memcpy(s->data + s->size, other->data, ((other->size + 1) * sizeof(dstr_char_t))); // +1 for '\0'
+    memcpy(dstr_data(s) + size, dstr_data(other), other_size * sizeof(dstr_char_t));
 
-    s->size += other->size;
+    _dstr_set_size(s, size + other_size);
 } // dstr_append_dstr
 
 void dstr_append_str(dstr* s, const dstr_char_t* str) {
 
+    size_t size = dstr_size(s);
     size_t str_len = strlen(str);
-    size_t capacity_needed = s->size + str_len + 1; // +1 for '\0'
+    size_t capacity_needed = size + str_len + 1; // +1 for '\0'
 
     _DSTR_GROW_IF_NEEDED(s, capacity_needed);
 
-    memcpy(s->data + s->size, str, str_len + 1); // for the '\0'
+    memcpy(dstr_data(s) + size, str, str_len * sizeof(dstr_char_t));
 
-    s->size += str_len;
+    _dstr_set_size(s, size + str_len);
 } // dstr_append_str
 
 void dstr_append_char(dstr* s, const dstr_char_t ch) {
 
+    size_t size = dstr_size(s);
     // +1 for char, another +1 for '\0'
-    size_t capacity_needed = s->size  + 1 + 1;
+    size_t capacity_needed = size + 1 + 1;
 
     _DSTR_GROW_IF_NEEDED(s, capacity_needed);
 
-    s->data[s->size] = ch;
-    ++s->size;
-    s->data[s->size] = '\0';
+    dstr_data(s)[size] = ch;
+    _dstr_set_size(s, size + 1);
 } // dstr_append_char
 
 void dstr_append_nchar(dstr* s, size_t count, const dstr_char_t ch) {
 
-    size_t capacity_needed = s->size + count + 1; // +1 for '\0'
+    size_t size = dstr_size(s);
+    size_t capacity_needed = size + count + 1; // +1 for '\0'
 
     _DSTR_GROW_IF_NEEDED(s, capacity_needed);
 
-    dstr_char_t* first = s->data + s->size;
+    dstr_char_t* first = dstr_data(s) + size;
     dstr_char_t* last = first + count;
     for (; first != last; ++first) {
         *first = ch;
     }
 
-    s->size += count;
-    s->data[s->size] = '\0';
+    _dstr_set_size(s, size + count);
 } // dstr_append_nchar
 
 void dstr_append_range(dstr* s, const dstr_it first, const dstr_it last) {
 
+    size_t size = dstr_size(s);
     size_t count = (last - first);
 
-    size_t capacity_needed = s->size + count + 1; // +1 for '\0'
+    size_t capacity_needed = size + count + 1; // +1 for '\0'
 
     _DSTR_GROW_IF_NEEDED(s, capacity_needed);
 
-    memcpy(s->data + s->size, first, (count + 1) * sizeof(dstr_char_t));
+    memcpy(dstr_data(s) + size, first, count * sizeof(dstr_char_t));
 
-    s->size += count;
-    s->data[s->size] = '\0';
+    _dstr_set_size(s, size + count);
 } // dstr_append_range
 
 void dstr_pop_back(dstr* s) {
-    assert(s->size);
+    assert(dstr_size(s));
 
-    --s->size;
-    s->data[s->size] = '\0';
+    _DSTR_UNSHARE_IF_NEEDED(s);
+    _dstr_set_size(s, dstr_size(s) - 1);
 } // dstr_pop_back
 
 void dstr_assign_dstr(dstr* s, const dstr* other) {
 
-    dstr_clear(s);
+#ifdef DSTR_SHARED_COPIES
+    if (_dstr_allocated_data(other)) {
+        dstr_assign_shared(s, other);
+        return;
+    }
+#endif
 
-    size_t other_size = other->size;
+    _dstr_discard(s);
+
+    size_t other_size = dstr_size(other);
 
     size_t capacity_needed = other_size + 1; // +1 for '\0'
 
     _DSTR_GROW_IF_NEEDED(s, capacity_needed);
 
-    memcpy(s->data, other->data, capacity_needed * sizeof(dstr_char_t));
-    s->size = other_size;
+    memcpy(dstr_data(s), dstr_data(other), other_size * sizeof(dstr_char_t));
+    _dstr_set_size(s, other_size);
 
 } // dstr_assign_dstr
 
 void dstr_assign_str(dstr* s, const dstr_char_t* str) {
 
-    dstr_clear(s);
+    _dstr_discard(s);
 
     size_t str_len = strlen(str);
     size_t capacity_needed = str_len + 1; // +1 for '\0'
 
     _DSTR_GROW_IF_NEEDED(s, capacity_needed);
 
-    memcpy(s->data, str, capacity_needed * sizeof(dstr_char_t));
+    memcpy(dstr_data(s), str, str_len * sizeof(dstr_char_t));
 
-    s->size = str_len;
+    _dstr_set_size(s, str_len);
 } // dstr_assign_str
 
 void dstr_assign_char(dstr* s, dstr_char_t ch) {
 
-    dstr_clear(s);
+    _dstr_discard(s);
 
     size_t capacity_needed = 1 + 1; // +1 for char, +1 for '\0'
 
     _DSTR_GROW_IF_NEEDED(s, capacity_needed);
 
-    s->data[0] = ch;
-    s->data[1] = '\0';
-    s->size = 1;
+    dstr_data(s)[0] = ch;
+    _dstr_set_size(s, 1);
 } // dstr_assign_char
 
 void dstr_assign_nchar(dstr* s, size_t count, dstr_char_t ch) {
 
-    dstr_clear(s);
+    _dstr_discard(s);
 
     size_t capacity_needed = count + 1; // +1 for '\0'
 
     _DSTR_GROW_IF_NEEDED(s, capacity_needed);
 
-    dstr_it first = s->data;
-    dstr_it last = s->data + count;
+    dstr_it first = dstr_data(s);
+    dstr_it last = first + count;
     for (; first != last; ++first) {
         *first = ch;
     }
 
-    s->size = count;
-    s->data[s->size] = '\0';
+    _dstr_set_size(s, count);
 } // dstr_assign_nchar
 
 void dstr_assign_range(dstr* s, const dstr_it first, const dstr_it last) {
 
-    dstr_clear(s);
+    _dstr_discard(s);
 
     size_t count = ((size_t)last - (size_t)first);
 
@@ -522,115 +1087,159 @@ void dstr_assign_range(dstr* s, const dstr_it first, const dstr_it last) {
 
     _DSTR_GROW_IF_NEEDED(s, capacity_needed);
 
-    s->size = count;
-
-    memcpy(s->data, first, count * sizeof(dstr_char_t));
+    memcpy(dstr_data(s), first, count * sizeof(dstr_char_t));
 
-    s->data[s->size] = '\0';
+    _dstr_set_size(s, count);
 } // dstr_assign_range
 
 
 int dstr_compare_dstr(const dstr* s, const dstr* other) {
 
-    int result;
-    int min = s->size < other->size ? s->size: other->size;
-    // memcmp is used because strncmp terminates on '\0'
-    // a dstr can be "aaa\0bbb" with a size of 7
-    int cmp = memcmp(s->data, other->data, min);
-
-    if (cmp) {
-        result = cmp;
-    } else { // strings are equal until 'min' chars count
-        result = s->size < other->size ? -1: s->size != other->size;
-    }
-
-    return result;
+    return dstr_view_compare(dstr_view_make_from_dstr(s), dstr_view_make_from_dstr(other));
 } // dstr_compare_dstr
 
 int dstr_compare_str(const dstr* s, const dstr_char_t* str) {
-    return strcmp(s->data, str);
+    return strcmp(dstr_data(s), str);
 } // dstr_compare_str
 
 void dstr_shrink_to_fit(dstr* s) {
     dstr_reserve(s, 0);
 } // dstr_shrink_to_fit
 
+inline int dstr_empty(const dstr* s) {
+    return !dstr_size(s);
+} // dstr_empty
+
+inline size_t dstr_size(const dstr* s) {
+    unsigned char tag = _DSTR_TAG(s);
+    switch (_DSTR_TAG_TO_CATEGORY(tag)) {
+    case _DSTR_SMALL:
+        return (DSTR_SSO_CAPACITY - 1) - _DSTR_TAG_TO_SMALL_REMAINING(tag);
+    case _DSTR_SMALL_ALLOCATOR:
+        return (_DSTR_SSO_ALLOCATOR_CAPACITY - 1) - _DSTR_TAG_TO_SMALL_REMAINING(tag);
+    default:
+        return s->u.large.size;
+    }
+} // dstr_size
+
+inline size_t dstr_length(const dstr* s) {
+    return dstr_size(s);
+} // dstr_length
+
+inline size_t dstr_capacity(const dstr* s) {
+    switch (_dstr_category(s)) {
+    case _DSTR_SMALL:
+        return DSTR_SSO_CAPACITY;
+    case _DSTR_SMALL_ALLOCATOR:
+        return _DSTR_SSO_ALLOCATOR_CAPACITY;
+    default:
+        return _DSTR_CAPACITY_DECODE(s->u.large.capacity);
+    }
+} // dstr_capacity
+
+inline dstr_it dstr_begin(const dstr* s) {
+    return dstr_data(s);
+} // dstr_begin
+
+inline dstr_it dstr_end(const dstr* s) {
+    return dstr_data(s) + dstr_size(s);
+} // dstr_end
+
 dstr_it dstr_insert(dstr* s, const dstr_it index, const dstr_char_t ch) {
 
-    assert(index >= s->data && index <= s->data + s->size);
-    const ptrdiff_t offset = index - s->data;
+    size_t size = dstr_size(s);
+
+    assert(index >= dstr_data(s) && index <= dstr_data(s) + size);
+    const ptrdiff_t offset = index - dstr_data(s);
 
     // + 1 for ch, +1 for '\0'
-    size_t capacity_needed = s->size + 1 + 1;
+    size_t capacity_needed = size + 1 + 1;
 
     _DSTR_GROW_IF_NEEDED(s, capacity_needed);
 
-    if (offset < (ptrdiff_t)s->size) {
-        memmove(s->data + offset + 1, s->data + offset, ((size_t)s->size - (size_t)offset) * sizeof(dstr_char_t));
+    dstr_char_t* data = dstr_data(s);
+
+    if (offset < (ptrdiff_t)size) {
+        memmove(data + offset + 1, data + offset, (size - (size_t)offset) * sizeof(dstr_char_t));
     }
 
-    s->data[offset] = ch;
-    ++s->size;
+    data[offset] = ch;
 
-    s->data[s->size] = '\0';
+    _dstr_set_size(s, size + 1);
 
-    return s->data + offset;
+    return data + offset;
 } // dstr_insert
 
 dstr_it dstr_insert_range(dstr* s, const dstr_it index, const dstr_it first, const dstr_it last) {
 
-    assert(index >= s->data && index <= s->data + s->size);
+    size_t size = dstr_size(s);
+
+    assert(index >= dstr_data(s) && index <= dstr_data(s) + size);
 
     const size_t count = last - first;
-    const ptrdiff_t offset = index - s->data;
+    const ptrdiff_t offset = index - dstr_data(s);
 
     // +1 for '\0'
-    size_t capacity_needed = s->size + count + 1;
+    size_t capacity_needed = size + count + 1;
 
     _DSTR_GROW_IF_NEEDED(s, capacity_needed);
 
-    if (offset < (ptrdiff_t)s->size) {
-        memmove(s->data + offset + count, s->data + offset, ((size_t)s->size - (size_t)offset) * sizeof(dstr_char_t));
-    }
+    dstr_char_t* data = dstr_data(s);
 
-    memcpy(s->data + offset, first, count * sizeof(dstr_char_t));
+    if (offset < (ptrdiff_t)size) {
+        memmove(data + offset + count, data + offset, (size - (size_t)offset) * sizeof(dstr_char_t));
+    }
 
-    s->size += count;
+    memcpy(data + offset, first, count * sizeof(dstr_char_t));
 
-    s->data[s->size] = '\0';
+    _dstr_set_size(s, size + count);
 
-    return s->data + offset;
+    return data + offset;
 } // dstr_insert_range
 
 dstr_it dstr_erase(dstr* s, const dstr_it index) {
-    assert(index >= s->data && index < (s->data + s->size));
 
-    const ptrdiff_t off = index - s->data;
+    size_t size = dstr_size(s);
+    dstr_char_t* data = dstr_data(s);
 
-    size_t count_to_move = ((size_t)s->size - (size_t)off - 1) + 1; // +1 for '\0'
-    memmove(s->data + off, s->data + off + 1, count_to_move * sizeof(dstr_char_t));
+    assert(index >= data && index < (data + size));
 
-    --s->size;
+    const ptrdiff_t off = index - data;
 
-    return s->data + off;
+    // 'index' may point to a shared buffer, only its offset is used below.
+    _DSTR_UNSHARE_IF_NEEDED(s);
+    data = dstr_data(s);
+
+    size_t count_to_move = (size - (size_t)off - 1);
+    memmove(data + off, data + off + 1, count_to_move * sizeof(dstr_char_t));
+
+    _dstr_set_size(s, size - 1);
+
+    return data + off;
 
 } // dstr_erase
 
 dstr_it dstr_erase_range(dstr* s, const dstr_it first, const dstr_it last) {
 
-    assert(first >= s->data && first <= (s->data + s->size));
-    assert(last >= s->data && last <= (s->data + s->size));
+    size_t size = dstr_size(s);
+    dstr_char_t* data = dstr_data(s);
+
+    assert(first >= data && first <= (data + size));
+    assert(last >= data && last <= (data + size));
 
-    const size_t first_index  = (size_t)(first - s->data);
-    const size_t last_index   = (size_t)(last - s->data);
+    const size_t first_index  = (size_t)(first - data);
+    const size_t last_index   = (size_t)(last - data);
     const size_t count_removed = last_index - first_index;
-    const size_t count_to_move = (s->size - last_index) + 1; // +1 for '\0'
+    const size_t count_to_move = (size - last_index);
 
-    memmove(s->data + first_index, s->data + last_index, count_to_move * sizeof(dstr_char_t));
+    _DSTR_UNSHARE_IF_NEEDED(s);
+    data = dstr_data(s);
 
-    s->size -= count_removed;
+    memmove(data + first_index, data + last_index, count_to_move * sizeof(dstr_char_t));
 
-    return s->data + first_index;
+    _dstr_set_size(s, size - count_removed);
+
+    return data + first_index;
 } // dstr_erase_range
 
 void dstr_resize(dstr* s, size_t size) {
@@ -639,24 +1248,27 @@ void dstr_resize(dstr* s, size_t size) {
         dstr_clear(s);
     }  else {
 
+        size_t old_size = dstr_size(s);
         size_t extra_count = 0;
 
         // +1 for extra char
-        if (size + 1 > s->capacity){
+        if (size + 1 > dstr_capacity(s)){
 
             _DSTR_GROW(s, size + 1);
-            extra_count = s->capacity - s->size;
+            extra_count = size - old_size;
 
-        } else if (size > s->size){
-            extra_count = size - s->size;
+        } else {
+            _DSTR_UNSHARE_IF_NEEDED(s);
+            if (size > old_size) {
+                extra_count = size - old_size;
+            }
         }
 
         if (extra_count) {
-            memset(s->data + s->size, 0, extra_count * sizeof(dstr_char_t));
+            memset(dstr_data(s) + old_size, 0, extra_count * sizeof(dstr_char_t));
         }
 
-        s->size = size;
-        s->data[s->size] = '\0';
+        _dstr_set_size(s, size);
     }
 } // dstr_resize
 
@@ -666,21 +1278,25 @@ void dstr_resize_fill(dstr* s, size_t size, dstr_char_t ch) {
         dstr_clear(s);
     }  else {
 
+        size_t old_size = dstr_size(s);
         size_t extra_count = 0;
 
         // +1 for extra char
-        if (size + 1 > s->capacity){
+        if (size + 1 > dstr_capacity(s)){
 
             _DSTR_GROW(s, size + 1);
-            extra_count = s->capacity - s->size;
+            extra_count = size - old_size;
 
-        } else if (size > s->size){
-            extra_count = size - s->size;
+        } else {
+            _DSTR_UNSHARE_IF_NEEDED(s);
+            if (size > old_size) {
+                extra_count = size - old_size;
+            }
         }
 
         if (extra_count) {
 
-            dstr_char_t* begin = s->data + s->size;
+            dstr_char_t* begin = dstr_data(s) + old_size;
             dstr_char_t* end   = begin + extra_count;
             while (begin != end) {
                 *begin = ch;
@@ -688,73 +1304,76 @@ void dstr_resize_fill(dstr* s, size_t size, dstr_char_t ch) {
             }
         }
 
-        s->size = size;
-        s->data[s->size] = '\0';
+        _dstr_set_size(s, size);
     }
 } // dstr_resize_fill
 
 void dstr_replace_with_dstr(dstr* s, size_t index, size_t count, const dstr* replacing) {
 
-    assert(index <= s->size);
-    assert(count <= s->size);
-    assert(index + count <= s->size);
+    size_t size = dstr_size(s);
+
+    assert(index <= size);
+    assert(count <= size);
+    assert(index + count <= size);
 
     // Juste an alias to make it shorter
-    const dstr* r = replacing;
+    const dstr_char_t* r_data = dstr_data(replacing);
+    size_t r_size = dstr_size(replacing);
 
-    if (r->size < count) { // mem replacing <  mem to replace
+    if (r_size < count) { // mem replacing <  mem to replace
 
-        char* first = s->data + index;
-        char* last = (s->data + index + count);
+        _DSTR_UNSHARE_IF_NEEDED(s);
 
-        size_t count_to_move = s->size - (index + count);
-        size_t count_removed = count - r->size;
+        dstr_char_t* data = dstr_data(s);
+        dstr_char_t* first = data + index;
+        dstr_char_t* last = (data + index + count);
+
+        size_t count_to_move = size - (index + count);
+        size_t count_removed = count - r_size;
 
         if (count_to_move) {
             memmove(last - count_removed, last, count_to_move * sizeof(dstr_char_t));
         }
-        if (s->size) {
-            memcpy(first, r->data, r->size * sizeof(dstr_char_t));
+        if (size) {
+            memcpy(first, r_data, r_size * sizeof(dstr_char_t));
         }
 
-        s->size -= count_removed;
-        s->data[s->size] = '\0';
+        _dstr_set_size(s, size - count_removed);
+
+    } else if (r_size > count) { // mem replacing >  mem to replace
 
-    } else if (r->size > count) { // mem replacing >  mem to replace
-        
-        size_t extra_count = r->size - count;
-        size_t needed_capacity = s->size + extra_count + 1; // +1 for '\0'
-        size_t count_to_move = s->size - index - count;
+        size_t extra_count = r_size - count;
+        size_t needed_capacity = size + extra_count + 1; // +1 for '\0'
+        size_t count_to_move = size - index - count;
 
         _DSTR_GROW_IF_NEEDED(s, needed_capacity);
 
         // Need to set this after "grow" because of potential allocation
-        char* first = s->data + index;
-        char* last = s->data + index + count;
+        dstr_char_t* data = dstr_data(s);
+        dstr_char_t* first = data + index;
+        dstr_char_t* last = data + index + count;
 
         if (count_to_move) {
             memmove(last + extra_count, last, count_to_move * sizeof(dstr_char_t));
         }
 
-        memcpy(first, r->data, r->size * sizeof(dstr_char_t));
+        memcpy(first, r_data, r_size * sizeof(dstr_char_t));
 
-        s->size += extra_count;
-        s->data[s->size] = '\0';
+        _dstr_set_size(s, size + extra_count);
 
     } else { // mem replacing == mem to replace
-        char* first = s->data + index;
-        memcpy(first, r->data, r->size * sizeof(dstr_char_t));
+        _DSTR_UNSHARE_IF_NEEDED(s);
+
+        dstr_char_t* first = dstr_data(s) + index;
+        memcpy(first, r_data, r_size * sizeof(dstr_char_t));
     }
 
 } // dstr_replace_with_dstr
 
 inline void dstr_replace_with_str(dstr* s, size_t index, size_t count, const dstr_char_t* replacing) {
-    const dstr tmp = {
-        strlen(replacing),
-        0,
-        (dstr_char_t*)replacing,
-        (dstr_char_t*)replacing
-    };
+    dstr tmp;
+    size_t len = strlen(replacing);
+    _dstr_set_large(&tmp, (dstr_char_t*)replacing, len, len + 1, _DSTR_EXTERNAL);
 
     dstr_replace_with_dstr(s, index, count, &tmp);
 } // dstr_replace_with_str
@@ -765,34 +1384,35 @@ inline void dstr_replace_with_nchar(dstr* s, size_t index, size_t count, dstr_ch
     dstr tmp = dstr_make_from_nchar(ch_count, ch);
 
     dstr_replace_with_dstr(s, index, count, &tmp);
+
+    dstr_clear(&tmp);
 } // dstr_replace_with_nchar
 
 
 size_t dstr_find_dstr(const dstr* s, size_t pos, const dstr* sub) {
 
-    size_t result = DSTR_NPOS;
+    return dstr_view_find(dstr_view_make_from_dstr(s), pos, dstr_view_make_from_dstr(sub));
+} // dstr_find_dstr
 
-    int worth_a_try = sub->size
-            && (pos <= s->size)
-            && (pos <= (s->size - sub->size));
+inline dstr_view dstr_substr(const dstr* s, size_t pos, size_t count) {
 
-    if (worth_a_try) {
+    return dstr_view_substr(dstr_view_make_from_dstr(s), pos, count);
+} // dstr_substr
 
-        void* found = _dstr_memory_find(s->data + pos, s->size, sub->data, sub->size);
+inline void dstr_copy(const dstr* s, dstr* other) {
 
-        if (found) {
-            result = (dstr_char_t*)found - s->data;
-        }
+#ifdef DSTR_SHARED_COPIES
+    if (_dstr_allocated_data(s)) {
+        dstr_assign_shared(other, s);
+        return;
     }
+#endif
 
-    return result;
-} // dstr_find_dstr
-
-inline void dstr_copy(const dstr* s, dstr* other) {
+    size_t size = dstr_size(s);
 
     dstr_clear(other);
-    dstr_resize(other, s->size);
-    memcpy(other->data, s->data, s->size * sizeof(dstr_char_t) );
+    dstr_resize(other, size);
+    memcpy(dstr_data(other), dstr_data(s), size * sizeof(dstr_char_t) );
 } // dstr_copy
 
 inline void dstr_swap(dstr* s, dstr* other) {
@@ -814,168 +1434,1711 @@ inline void dstr_swap(dstr* s, dstr* other) {
 
 void dstr_trim(dstr* s)
 {
-    dstr_char_t* cursor_left  = s->data;
-    dstr_char_t* cursor_right = s->data + (s->size - 1);
-
-    // Trim right
-    while (cursor_right >= cursor_left && isspace(*cursor_right)) {
-        --cursor_right;
-    }
-
-    // Trim left
-    while (cursor_right > cursor_left && isspace(*cursor_left)) {
-        ++cursor_left;
-    }
-
-    s->size = (cursor_right - cursor_left) + 1;
-    memmove(s->data, cursor_left, s->size * sizeof(dstr_char_t));
-
-    s->data[s->size] = '\0';
+    dstr_rtrim(s);
+    dstr_ltrim(s);
 } // dstr_trim
 
 void dstr_ltrim(dstr* s) {
-    char *cursor = s->data;
+    dstr_char_t* data = dstr_data(s);
+    size_t size = dstr_size(s);
+    size_t first = _dstr_find_space(data, size, 1);
 
-    while (s->size > 0 && isspace(*cursor)) {
-        ++cursor;
-        --s->size;
-    }
+    if (first) {
+        _DSTR_UNSHARE_IF_NEEDED(s);
+        data = dstr_data(s);
 
-    memmove(s->data, cursor, s->size * sizeof(dstr_char_t));
-    s->data[s->size] = '\0';
+        memmove(data, data + first, (size - first) * sizeof(dstr_char_t));
+        _dstr_set_size(s, size - first);
+    }
 } // dstr_ltrim
 
 void dstr_rtrim(dstr* s)
 {
-    while (s->size > 0 && isspace(s->data[s->size - 1])) {
-        --s->size;
+    size_t size = _dstr_rtrimmed_size(dstr_data(s), dstr_size(s));
+
+    if (size != dstr_size(s)) {
+        _DSTR_UNSHARE_IF_NEEDED(s);
+        _dstr_set_size(s, size);
     }
-    s->data[s->size] = '\0';
 } // dstr_rtrim
 
-void dstr_find_and_replace(dstr* s, const dstr_char_t* to_replaced, const dstr_char_t* with) {
-
-    const void* found;
-    
-    size_t t_size = strlen(to_replaced);
-    size_t with_size = strlen(with);
+void dstr_collapse_whitespace(dstr* s) {
 
-    const dstr_char_t* s_begin = s->data;
-    const dstr_char_t* s_end = s->data + s->size;
+    _DSTR_UNSHARE_IF_NEEDED(s);
 
-    const dstr_char_t* t_begin = to_replaced;
+    dstr_char_t* data = dstr_data(s);
+    size_t size = dstr_size(s);
+    size_t read = _dstr_find_space(data, size, 1);
+    size_t write = 0;
 
+    // Each word is moved once, 'write' never goes beyond 'read'.
+    while (read < size) {
 
-    while((found = _dstr_memory_find((const void*)s_begin, (size_t)s_end - (size_t)s_begin, (void*)t_begin, t_size))) {
-        size_t index = (dstr_char_t*)found - s->data;
+        size_t word_end = read + _dstr_find_space(data + read, size - read, 0);
 
-        dstr_replace_with_str(s, index, t_size, with);
+        if (write) {
+            data[write++] = ' ';
+        }
+        memmove(data + write, data + read, (word_end - read) * sizeof(dstr_char_t));
+        write += word_end - read;
 
-        // reset begin and end, could be invalidated (realloc)
-        // put the next position to index + found word lenght
-        s_begin = s->data + index + with_size;
-        s_end = s->data + s->size;
+        read = word_end + _dstr_find_space(data + word_end, size - word_end, 1);
     }
+
+    _dstr_set_size(s, write);
+} // dstr_collapse_whitespace
+
+void dstr_to_lower(dstr* s) {
+    _DSTR_UNSHARE_IF_NEEDED(s);
+    _dstr_flip_ascii_case(dstr_data(s), dstr_size(s), 'A');
+} // dstr_to_lower
+
+void dstr_to_upper(dstr* s) {
+    _DSTR_UNSHARE_IF_NEEDED(s);
+    _dstr_flip_ascii_case(dstr_data(s), dstr_size(s), 'a');
+} // dstr_to_upper
+
+size_t dstr_find_and_replace(dstr* s, const dstr_char_t* to_replaced, const dstr_char_t* with) {
+
+    dstr t;
+    dstr w;
+    size_t t_size = strlen(to_replaced);
+    size_t w_size = strlen(with);
+
+    _dstr_set_large(&t, (dstr_char_t*)to_replaced, t_size, t_size + 1, _DSTR_EXTERNAL);
+    _dstr_set_large(&w, (dstr_char_t*)with, w_size, w_size + 1, _DSTR_EXTERNAL);
+
+    return dstr_find_and_replace_dstr(s, &t, &w);
 } // dstr_find_and_replace
 
-int dstr_append_fmt(dstr* s, const char* fmt, ...)
-{
+size_t dstr_find_and_replace_dstr(dstr* s, const dstr* to_replaced, const dstr* with) {
 
-    va_list args1;
-    va_start(args1, fmt);
-    va_list args2;
-    va_copy(args2, args1);
+    const dstr_char_t* t_data = dstr_data(to_replaced);
+    const dstr_char_t* w_data = dstr_data(with);
+    size_t t_size = dstr_size(to_replaced);
+    size_t w_size = dstr_size(with);
 
-    // +1 for '\0', needed by vsnprintf
-    int formated_string_size = vsnprintf(NULL, 0, fmt, args1) + 1;
-    assert(formated_string_size >= 0);
+    dstr_char_t* data = dstr_data(s);
+    const dstr_char_t* end = data + dstr_size(s);
+    const dstr_char_t* read = data;
+    const dstr_char_t* found;
+    size_t count = 0;
 
-    size_t capacity_needed = s->size + formated_string_size;
+    // A shared buffer is not modified, the result is built in a new buffer like below.
+    if (w_size <= t_size && !dstr_is_shared(s)) {
 
-    _DSTR_GROW_IF_NEEDED(s, capacity_needed);
+        // In place, the result never goes beyond what has been read.
+        dstr_char_t* write = data;
+
+        while ((found = (const dstr_char_t*)_dstr_memory_find(read, (size_t)(end - read), t_data, t_size))) {
+            size_t segment = (size_t)(found - read);
+
+            memmove(write, read, segment * sizeof(dstr_char_t));
+            write += segment;
+            memcpy(write, w_data, w_size * sizeof(dstr_char_t));
+            write += w_size;
+
+            read = found + t_size;
+            ++count;
+        }
+
+        if (count) {
+            size_t tail = (size_t)(end - read);
+            memmove(write, read, tail * sizeof(dstr_char_t));
+            _dstr_set_size(s, (size_t)(write - data) + tail);
+        }
+
+    } else {
+
+        // Count occurrences to allocate the result once.
+        while ((found = (const dstr_char_t*)_dstr_memory_find(read, (size_t)(end - read), t_data, t_size))) {
+            read = found + t_size;
+            ++count;
+        }
+
+        if (count) {
+            size_t new_size = (size_t)(end - data) + count * (w_size - t_size);
+            dstr result = dstr_make_with_allocator(new_size + 1, dstr_get_attached_allocator(s)); // +1 for '\0'
+            dstr_char_t* write = dstr_data(&result);
+
+            read = data;
+            while ((found = (const dstr_char_t*)_dstr_memory_find(read, (size_t)(end - read), t_data, t_size))) {
+                size_t segment = (size_t)(found - read);
+
+                memcpy(write, read, segment * sizeof(dstr_char_t));
+                write += segment;
+                memcpy(write, w_data, w_size * sizeof(dstr_char_t));
+                write += w_size;
+
+                read = found + t_size;
+            }
+            memcpy(write, read, (size_t)(end - read) * sizeof(dstr_char_t));
+
+            _dstr_set_size(&result, new_size);
+            dstr_swap(s, &result);
+            dstr_clear(&result);
+        }
+    }
+
+    return count;
+} // dstr_find_and_replace_dstr
 
-    va_end(args1);
-    int result = vsnprintf(s->data + s->size, formated_string_size, fmt, args2);
-    va_end(args2);
+int dstr_append_fmt(dstr* s, const char* fmt, ...) {
+
+    va_list args;
+    va_start(args, fmt);
+    int result = dstr_append_vfmt(s, fmt, args);
+    va_end(args);
 
-    s->size = capacity_needed - 1;
     return result;
-}
+} // dstr_append_fmt
+
+int dstr_assign_fmt(dstr* s, const char* fmt, ...) {
+
+    va_list args;
+    va_start(args, fmt);
+    int result = dstr_assign_vfmt(s, fmt, args);
+    va_end(args);
 
-dstr_ref dstr_make_ref(const dstr_char_t* str) {
-    dstr_ref result = {
-        0,
-        strlen(str),
-        (dstr_char_t*)str,
-        (dstr_char_t*)str
-    };
     return result;
-}
+} // dstr_assign_fmt
+
+int dstr_append_vfmt(dstr* s, const char* fmt, va_list args) {
+
+    _DSTR_UNSHARE_IF_NEEDED(s);
+
+    size_t size = dstr_size(s);
+
+    va_list args_copy;
+    va_copy(args_copy, args);
+
+    // Remaining capacity includes the '\0'
+    int result = vsnprintf(dstr_data(s) + size, dstr_capacity(s) - size, fmt, args_copy);
+    va_end(args_copy);
+
+    if (result < 0) {
+        _dstr_set_size(s, size);
+    } else if ((size_t)result < dstr_capacity(s) - size) {
+        _dstr_set_size(s, size + (size_t)result);
+    } else {
+        // The truncated '\0' may have overwritten the tag of an inline string, restore the size first.
+        _dstr_set_size(s, size);
+
+        size_t capacity_needed = size + (size_t)result + 1; // +1 for '\0'
+
+        _DSTR_GROW_IF_NEEDED(s, capacity_needed);
+
+        va_copy(args_copy, args);
+        vsnprintf(dstr_data(s) + size, (size_t)result + 1, fmt, args_copy);
+        va_end(args_copy);
+
+        _dstr_set_size(s, size + (size_t)result);
+    }
 
-dstr dstr_make_with_buffer(const dstr_char_t* buffer, size_t capacity) {
-    dstr_ref result = {
-        0,
-        capacity,
-        (dstr_char_t*)buffer,
-        (dstr_char_t*)buffer
-    };
     return result;
-}
+} // dstr_append_vfmt
 
-//-------------------------------------------------------------------------
-// dstr - Extended Implementation - END
-//-------------------------------------------------------------------------
+int dstr_assign_vfmt(dstr* s, const char* fmt, va_list args) {
 
-//-------------------------------------------------------------------------
-// dstr - Private Implementation - BEGIN
-//-------------------------------------------------------------------------
+    _dstr_discard(s);
 
-int    _dstr_allocated_data(dstr* s) {
+    return dstr_append_vfmt(s, fmt, args);
+} // dstr_assign_vfmt
 
-    return s->data != s->non_owned_buffer || s->data != _DSTR_DEFAULT_DATA;
-} // _dstr_allocated_data
+int dstr_append_fmtb(dstr* s, const char* fmt, ...) {
 
-size_t _dstr_growing_policy(dstr* s, size_t needed_size) {
+    va_list args;
+    va_start(args, fmt);
+    int result = dstr_append_vfmtb(s, fmt, args);
+    va_end(args);
 
-    // If the array is not initialize, set the minimal size.
-    // Otherwise increase the size by 50%
-    size_t new_capacity = !s->capacity ? _DSTR_MIN_ALLOC : (s->capacity + (s->capacity / 2));
+    return result;
+} // dstr_append_fmtb
 
-    // Use the greatest of both needed_size and new_capacity
-    return new_capacity > needed_size ? new_capacity : needed_size;
+int dstr_assign_fmtb(dstr* s, const char* fmt, ...) {
 
-} // _dstr_growing_policy
+    va_list args;
+    va_start(args, fmt);
+    int result = dstr_assign_vfmtb(s, fmt, args);
+    va_end(args);
 
-void* _dstr_memory_find(const void* memory_ptr, size_t mem_len, const void* pattern_ptr, size_t pattern_len)
-{
+    return result;
+} // dstr_assign_fmtb
 
-    const char *mem_ptr = (const char *)memory_ptr;
-    const char *patt_ptr = (const char *)pattern_ptr;
+int dstr_append_vfmtb(dstr* s, const char* fmt, va_list args) {
 
-    // pattern_len can't be greater than mem_len
-    if ((mem_len == 0) || (pattern_len == 0) || pattern_len > mem_len) {
-        return 0;
+    size_t size = dstr_size(s);
+    size_t remaining = dstr_capacity(s) - size; // includes the '\0'
+
+    va_list args_copy;
+    va_copy(args_copy, args);
+
+    int result;
+    if (dstr_is_shared(s)) {
+        // Only the size is computed.
+        result = vsnprintf(0, 0, fmt, args_copy);
+        va_end(args_copy);
+        return result;
     }
 
-    // pattern is a char
-    if (pattern_len == 1) {
-        return memchr((void*)mem_ptr, *patt_ptr, mem_len);
+    result = vsnprintf(dstr_data(s) + size, remaining, fmt, args_copy);
+    va_end(args_copy);
+
+    if (result < 0) {
+        _dstr_set_size(s, size);
+    } else {
+        _dstr_set_size(s, (size_t)result < remaining ? size + (size_t)result : size + remaining - 1);
     }
 
-    // Last possible position
-    const char* cur = mem_ptr;
-    const char* last = mem_ptr + mem_len - pattern_len;
+    return result;
+} // dstr_append_vfmtb
 
-    while(cur <= last) {
-        // Test the first char before calling a function
-        if (*cur == *patt_ptr && memcmp(cur, pattern_ptr, pattern_len) == 0) {
-            return (void*)cur;
-        }
-        ++cur;
+int dstr_assign_vfmtb(dstr* s, const char* fmt, va_list args) {
+
+    _dstr_discard(s);
+
+    return dstr_append_vfmtb(s, fmt, args);
+} // dstr_assign_vfmtb
+
+void dstr_append_i64(dstr* s, int64_t value) {
+    dstr_append_i64_padded(s, value, 0);
+} // dstr_append_i64
+
+void dstr_append_u64(dstr* s, uint64_t value) {
+    _dstr_append_integer(s, value, 0, 0, 0);
+} // dstr_append_u64
+
+void dstr_append_hex(dstr* s, uint64_t value) {
+    _dstr_append_integer(s, value, 0, 0, 1);
+} // dstr_append_hex
+
+void dstr_append_i64_padded(dstr* s, int64_t value, size_t width) {
+
+    // Negated as unsigned, INT64_MIN has no positive counterpart in int64_t.
+    if (value < 0) {
+        _dstr_append_integer(s, (uint64_t)0 - (uint64_t)value, '-', width, 0);
+    } else {
+        _dstr_append_integer(s, (uint64_t)value, 0, width, 0);
     }
+} // dstr_append_i64_padded
 
-    return 0;
-} // _dstr_memory_find
+void dstr_append_u64_padded(dstr* s, uint64_t value, size_t width) {
+    _dstr_append_integer(s, value, 0, width, 0);
+} // dstr_append_u64_padded
+
+void dstr_append_hex_padded(dstr* s, uint64_t value, size_t width) {
+    _dstr_append_integer(s, value, 0, width, 1);
+} // dstr_append_hex_padded
+
+dstr_ref dstr_make_ref(const dstr_char_t* str) {
+    dstr result;
+    size_t len = strlen(str);
+    _dstr_set_large(&result, (dstr_char_t*)str, len, len + 1, _DSTR_EXTERNAL); // +1 for '\0'
+    return result;
+}
+
+dstr dstr_make_with_buffer(const dstr_char_t* buffer, size_t capacity) {
+    dstr result;
+    _dstr_set_large(&result, (dstr_char_t*)buffer, 0, capacity, _DSTR_EXTERNAL);
+    return result;
+}
+
+void* _dstr_malloc_alloc(void* user_data, size_t size) {
+    (void)user_data;
+    return malloc(size);
+}
+
+void* _dstr_malloc_realloc(void* user_data, void* ptr, size_t old_size, size_t new_size) {
+    (void)user_data;
+    (void)old_size;
+    return realloc(ptr, new_size);
+}
+
+void _dstr_malloc_free(void* user_data, void* ptr, size_t size) {
+    (void)user_data;
+    (void)size;
+    free(ptr);
+}
+
+const dstr_allocator dstr_malloc_allocator = {
+    _dstr_malloc_alloc,
+    _dstr_malloc_realloc,
+    _dstr_malloc_free,
+    0
+};
+
+const dstr_allocator* dstr_get_thread_allocator() {
+    return _dstr_thread_allocator ? _dstr_thread_allocator : &dstr_malloc_allocator;
+}
+
+void dstr_set_thread_allocator(const dstr_allocator* allocator) {
+    _dstr_thread_allocator = allocator;
+}
+
+void dstr_init_with_allocator(dstr* s, const dstr_allocator* allocator) {
+    _dstr_set_small_with_allocator(s, 0, allocator);
+}
+
+dstr dstr_make_with_allocator(size_t capacity, const dstr_allocator* allocator) {
+    dstr result;
+
+    dstr_init_with_allocator(&result, allocator);
+
+    if (capacity) {
+        dstr_reserve(&result, capacity);
+    }
+
+    return result;
+}
+
+const dstr_allocator* dstr_get_allocator(const dstr* s) {
+    const dstr_allocator* allocator = dstr_get_attached_allocator(s);
+    return allocator ? allocator : dstr_get_thread_allocator();
+}
+
+const dstr_allocator* dstr_get_attached_allocator(const dstr* s) {
+
+    const dstr_allocator* allocator = 0;
+
+    switch (_dstr_category(s)) {
+    case _DSTR_SMALL_ALLOCATOR:
+        // Not aligned, memcpy is used instead of a cast.
+        memcpy((void*)&allocator, s->u.small + _DSTR_SSO_ALLOCATOR_OFFSET, sizeof(allocator));
+        break;
+    case _DSTR_HEAP:
+        if (s->u.large.capacity & _DSTR_ATTACHED_BIT) {
+            allocator = _dstr_block_allocator(s->u.large.data);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return allocator;
+}
+
+const dstr_huge_options dstr_default_huge_options = {
+    DSTR_HUGE_THRESHOLD,
+    1
+};
+
+const dstr_allocator dstr_huge_allocator = {
+    _dstr_huge_alloc,
+    _dstr_huge_realloc,
+    _dstr_huge_free,
+    0
+};
+
+dstr_allocator dstr_make_huge_allocator(const dstr_huge_options* options) {
+
+    dstr_allocator result = dstr_huge_allocator;
+    result.user_data = (void*)options;
+
+    return result;
+} // dstr_make_huge_allocator
+
+const dstr_growth_policy dstr_default_growth_policy = {
+    DSTR_GROWTH_FACTOR_PERCENT,
+    DSTR_GROWTH_MIN_CAPACITY,
+    0
+};
+
+const dstr_growth_policy* dstr_get_thread_growth_policy() {
+    return _dstr_thread_growth_policy ? _dstr_thread_growth_policy : &dstr_default_growth_policy;
+}
+
+void dstr_set_thread_growth_policy(const dstr_growth_policy* policy) {
+    _dstr_thread_growth_policy = policy;
+}
+
+void dstr_get_stats(dstr_stats* stats) {
+    *stats = _dstr_thread_stats;
+} // dstr_get_stats
+
+void dstr_reset_stats() {
+    memset(&_dstr_thread_stats, 0, sizeof(_dstr_thread_stats));
+} // dstr_reset_stats
+
+void dstr_dump_stats(FILE* out) {
+
+#ifdef DSTR_STATS
+    const dstr_stats* stats = &_dstr_thread_stats;
+
+    fprintf(out, "dstr stats:\n");
+    fprintf(out, "  allocations:   %lu\n", (unsigned long)stats->allocations);
+    fprintf(out, "  frees:         %lu\n", (unsigned long)stats->frees);
+    fprintf(out, "  reallocations: %lu\n", (unsigned long)stats->reallocations);
+    fprintf(out, "  reserve calls: %lu\n", (unsigned long)stats->reserve_calls);
+    fprintf(out, "  copied bytes:  %lu\n", (unsigned long)stats->copied_bytes);
+    fprintf(out, "  peak capacity: %lu\n", (unsigned long)stats->peak_capacity);
+#else
+    fprintf(out, "dstr stats: disabled, define DSTR_STATS to enable them\n");
+#endif
+} // dstr_dump_stats
+
+inline dstr dstr_make_shared(const dstr* other) {
+    dstr result;
+
+    dstr_init(&result);
+    dstr_assign_shared(&result, other);
+
+    return result;
+} // dstr_make_shared
+
+void dstr_assign_shared(dstr* s, const dstr* other) {
+
+    if (s == other) {
+        return;
+    }
+
+    if (_dstr_allocated_data(other)) {
+        _dstr_block* block = (_dstr_block*)other->u.large.data - 1;
+
+        // Incremented first, 's' may already share this buffer.
+        DSTR_ATOMIC_INCREMENT(&block->refcount);
+        dstr_clear(s);
+        *s = *other;
+    } else {
+        dstr_assign_dstr(s, other);
+    }
+} // dstr_assign_shared
+
+inline int dstr_is_shared(const dstr* s) {
+
+    return _dstr_allocated_data(s)
+        && DSTR_ATOMIC_LOAD(&((_dstr_block*)s->u.large.data - 1)->refcount) != 1;
+} // dstr_is_shared
+
+inline void dstr_unshare(dstr* s) {
+    _DSTR_UNSHARE_IF_NEEDED(s);
+} // dstr_unshare
+
+inline dstr_view dstr_view_make(const dstr_char_t* data, size_t size) {
+    dstr_view result;
+
+    result.data = data;
+    result.size = size;
+
+    return result;
+} // dstr_view_make
+
+inline dstr_view dstr_view_make_from_str(const dstr_char_t* str) {
+    return dstr_view_make(str, strlen(str));
+} // dstr_view_make_from_str
+
+inline dstr_view dstr_view_make_from_dstr(const dstr* s) {
+    return dstr_view_make(dstr_data(s), dstr_size(s));
+} // dstr_view_make_from_dstr
+
+inline dstr_view dstr_view_substr(dstr_view v, size_t pos, size_t count) {
+
+    if (pos > v.size) {
+        pos = v.size;
+    }
+    if (count > v.size - pos) {
+        count = v.size - pos;
+    }
+
+    return dstr_view_make(v.data + pos, count);
+} // dstr_view_substr
+
+inline dstr_view dstr_view_prefix(dstr_view v, size_t count) {
+    return dstr_view_make(v.data, count < v.size ? count : v.size);
+} // dstr_view_prefix
+
+inline dstr_view dstr_view_suffix(dstr_view v, size_t count) {
+    return count < v.size ? dstr_view_make(v.data + v.size - count, count) : v;
+} // dstr_view_suffix
+
+int dstr_view_compare(dstr_view v, dstr_view other) {
+
+    int result;
+    size_t min = v.size < other.size ? v.size : other.size;
+    // memcmp is used because strncmp terminates on '\0'
+    // a dstr can be "aaa\0bbb" with a size of 7
+    int cmp = min ? memcmp(v.data, other.data, min) : 0;
+
+    if (cmp) {
+        result = cmp;
+    } else { // strings are equal until 'min' chars count
+        result = v.size < other.size ? -1 : v.size != other.size;
+    }
+
+    return result;
+} // dstr_view_compare
+
+inline int dstr_view_equals(dstr_view v, dstr_view other) {
+    return v.size == other.size && (!v.size || memcmp(v.data, other.data, v.size) == 0);
+} // dstr_view_equals
+
+inline int dstr_view_starts_with(dstr_view v, dstr_view prefix) {
+    return dstr_view_equals(dstr_view_prefix(v, prefix.size), prefix);
+} // dstr_view_starts_with
+
+inline int dstr_view_ends_with(dstr_view v, dstr_view suffix) {
+    return dstr_view_equals(dstr_view_suffix(v, suffix.size), suffix);
+} // dstr_view_ends_with
+
+size_t dstr_view_find(dstr_view v, size_t pos, dstr_view sub) {
+
+    size_t result = DSTR_NPOS;
+
+    int worth_a_try = sub.size
+            && (sub.size <= v.size)
+            && (pos <= (v.size - sub.size));
+
+    if (worth_a_try) {
+
+        void* found = _dstr_memory_find(v.data + pos, v.size - pos, sub.data, sub.size);
+
+        if (found) {
+            result = (const dstr_char_t*)found - v.data;
+        }
+    }
+
+    return result;
+} // dstr_view_find
+
+size_t dstr_view_find_char(dstr_view v, size_t pos, dstr_char_t ch) {
+
+    const void* found = pos < v.size ? memchr(v.data + pos, ch, v.size - pos) : 0;
+
+    return found ? (size_t)((const dstr_char_t*)found - v.data) : DSTR_NPOS;
+} // dstr_view_find_char
+
+inline dstr_view dstr_view_trim(dstr_view v) {
+    return dstr_view_ltrim(dstr_view_rtrim(v));
+} // dstr_view_trim
+
+inline dstr_view dstr_view_ltrim(dstr_view v) {
+    size_t first = _dstr_find_space(v.data, v.size, 1);
+    return dstr_view_make(v.data + first, v.size - first);
+} // dstr_view_ltrim
+
+inline dstr_view dstr_view_rtrim(dstr_view v) {
+    return dstr_view_make(v.data, _dstr_rtrimmed_size(v.data, v.size));
+} // dstr_view_rtrim
+
+inline dstr dstr_make_from_view(dstr_view v) {
+    dstr result;
+
+    dstr_init(&result);
+    dstr_append_view(&result, v);
+
+    return result;
+} // dstr_make_from_view
+
+void dstr_append_view(dstr* s, dstr_view v) {
+
+    size_t size = dstr_size(s);
+    size_t capacity_needed = size + v.size + 1; // +1 for '\0'
+    const dstr_char_t* data = dstr_data(s);
+
+    // The view can be invalidated by the growth, keep its offset.
+    if (v.size && v.data >= data && v.data < data + size) {
+        size_t offset = (size_t)(v.data - data);
+
+        _DSTR_GROW_IF_NEEDED(s, capacity_needed);
+        v.data = dstr_data(s) + offset;
+    } else {
+        _DSTR_GROW_IF_NEEDED(s, capacity_needed);
+    }
+
+    memmove(dstr_data(s) + size, v.data, v.size * sizeof(dstr_char_t));
+
+    _dstr_set_size(s, size + v.size);
+} // dstr_append_view
+
+void dstr_assign_view(dstr* s, dstr_view v) {
+
+    dstr_char_t* data = dstr_data(s);
+
+    if (v.size && v.data >= data && v.data < data + dstr_size(s)) {
+        // Inside 's', it's never larger than 's'.
+        if (dstr_is_shared(s)) {
+            size_t offset = (size_t)(v.data - data);
+
+            _dstr_unshare(s);
+            data = dstr_data(s);
+            v.data = data + offset;
+        }
+        memmove(data, v.data, v.size * sizeof(dstr_char_t));
+        _dstr_set_size(s, v.size);
+    } else {
+        _dstr_discard(s);
+        dstr_append_view(s, v);
+    }
+} // dstr_assign_view
+
+inline int dstr_compare_view(const dstr* s, dstr_view v) {
+    return dstr_view_compare(dstr_view_make_from_dstr(s), v);
+} // dstr_compare_view
+
+inline size_t dstr_find_view(const dstr* s, size_t pos, dstr_view sub) {
+    return dstr_view_find(dstr_view_make_from_dstr(s), pos, sub);
+} // dstr_find_view
+
+inline int dstr_starts_with(const dstr* s, dstr_view prefix) {
+    return dstr_view_starts_with(dstr_view_make_from_dstr(s), prefix);
+} // dstr_starts_with
+
+inline int dstr_ends_with(const dstr* s, dstr_view suffix) {
+    return dstr_view_ends_with(dstr_view_make_from_dstr(s), suffix);
+} // dstr_ends_with
+
+inline dstr_view dstr_trim_view(const dstr* s) {
+    return dstr_view_trim(dstr_view_make_from_dstr(s));
+} // dstr_trim_view
+
+inline void dstr_append_many(dstr* s, const dstr_view* pieces, size_t count) {
+    _dstr_append_pieces(s, dstr_view_make(0, 0), pieces, 0, count);
+} // dstr_append_many
+
+inline void dstr_append_many_dstr(dstr* s, const dstr* pieces, size_t count) {
+    _dstr_append_pieces(s, dstr_view_make(0, 0), 0, pieces, count);
+} // dstr_append_many_dstr
+
+inline void dstr_join(dstr* s, dstr_view separator, const dstr_view* pieces, size_t count) {
+    _dstr_append_pieces(s, separator, pieces, 0, count);
+} // dstr_join
+
+inline void dstr_join_dstr(dstr* s, dstr_view separator, const dstr* pieces, size_t count) {
+    _dstr_append_pieces(s, separator, 0, pieces, count);
+} // dstr_join_dstr
+
+void dstr_searcher_init(dstr_searcher* searcher, const dstr_char_t* pattern, size_t pattern_size) {
+
+    dstr_init(&searcher->pattern);
+    dstr_append_range(&searcher->pattern, (dstr_it)pattern, (dstr_it)pattern + pattern_size);
+
+    const unsigned char* p = (const unsigned char*)dstr_data(&searcher->pattern);
+
+    _dstr_two_way_init(&searcher->forward, p, pattern_size, 0);
+    _dstr_two_way_init(&searcher->backward, p, pattern_size, 1);
+} // dstr_searcher_init
+
+void dstr_searcher_clear(dstr_searcher* searcher) {
+    dstr_clear(&searcher->pattern);
+} // dstr_searcher_clear
+
+size_t dstr_searcher_find(const dstr_searcher* searcher, const dstr* s, size_t pos) {
+
+    size_t size = dstr_size(s);
+    size_t found;
+
+    if (pos > size) {
+        return DSTR_NPOS;
+    }
+
+    found = dstr_searcher_find_range(searcher, dstr_data(s) + pos, dstr_data(s) + size);
+
+    return found == DSTR_NPOS ? DSTR_NPOS : pos + found;
+} // dstr_searcher_find
+
+size_t dstr_searcher_rfind(const dstr_searcher* searcher, const dstr* s, size_t pos) {
+
+    size_t size = dstr_size(s);
+    size_t pattern_size = dstr_size(&searcher->pattern);
+
+    // Occurrence can end at pos + pattern_size
+    size_t end = (pos >= size || size - pos < pattern_size) ? size : pos + pattern_size;
+
+    return dstr_searcher_rfind_range(searcher, dstr_data(s), dstr_data(s) + end);
+} // dstr_searcher_rfind
+
+size_t dstr_searcher_find_all(const dstr_searcher* searcher, const dstr* s, size_t pos, size_t* positions, size_t max_count) {
+
+    size_t size = dstr_size(s);
+    size_t count;
+    size_t i;
+
+    if (pos > size) {
+        return 0;
+    }
+
+    count = dstr_searcher_find_all_range(searcher, dstr_data(s) + pos, dstr_data(s) + size, positions, max_count);
+
+    for (i = 0; i < count; ++i) {
+        positions[i] += pos;
+    }
+
+    return count;
+} // dstr_searcher_find_all
+
+size_t dstr_searcher_find_range(const dstr_searcher* searcher, const dstr_it first, const dstr_it last) {
+
+    const dstr_char_t* pattern = dstr_data(&searcher->pattern);
+    size_t pattern_size = dstr_size(&searcher->pattern);
+    const dstr_char_t* found;
+
+    if (pattern_size < DSTR_SEARCHER_LONG_PATTERN) {
+        found = (const dstr_char_t*)_dstr_memory_find(first, (size_t)(last - first), pattern, pattern_size);
+    } else {
+        found = _dstr_two_way_find(&searcher->forward, (const unsigned char*)pattern, pattern_size, (const unsigned char*)first, (const unsigned char*)last);
+    }
+
+    return found ? (size_t)(found - first) : DSTR_NPOS;
+} // dstr_searcher_find_range
+
+size_t dstr_searcher_rfind_range(const dstr_searcher* searcher, const dstr_it first, const dstr_it last) {
+
+    const dstr_char_t* found = _dstr_two_way_rfind(&searcher->backward,
+        (const unsigned char*)dstr_data(&searcher->pattern),
+        dstr_size(&searcher->pattern),
+        (const unsigned char*)first,
+        (const unsigned char*)last);
+
+    return found ? (size_t)(found - first) : DSTR_NPOS;
+} // dstr_searcher_rfind_range
+
+size_t dstr_searcher_find_all_range(const dstr_searcher* searcher, const dstr_it first, const dstr_it last, size_t* positions, size_t max_count) {
+
+    size_t pattern_size = dstr_size(&searcher->pattern);
+    size_t count = 0;
+    dstr_it cur = first;
+
+    // Each search starts after the previous occurrence, the text is read once.
+    while (count < max_count) {
+        size_t found = dstr_searcher_find_range(searcher, cur, last);
+        if (found == DSTR_NPOS) {
+            break;
+        }
+        positions[count++] = (size_t)(cur - first) + found;
+        cur += found + pattern_size;
+    }
+
+    return count;
+} // dstr_searcher_find_all_range
+
+//-------------------------------------------------------------------------
+// dstr - Extended Implementation - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr - Private Implementation - BEGIN
+//-------------------------------------------------------------------------
+
+inline int _dstr_category(const dstr* s) {
+
+    return _DSTR_TAG_TO_CATEGORY(_DSTR_TAG(s));
+} // _dstr_category
+
+inline int _dstr_is_small(const dstr* s) {
+
+    int category = _dstr_category(s);
+    return category == _DSTR_SMALL || category == _DSTR_SMALL_ALLOCATOR;
+} // _dstr_is_small
+
+inline int _dstr_allocated_data(const dstr* s) {
+
+    return _dstr_category(s) == _DSTR_HEAP;
+} // _dstr_allocated_data
+
+inline const dstr_allocator* _dstr_block_allocator(const dstr_char_t* data) {
+
+    return ((const _dstr_block*)data - 1)->allocator;
+} // _dstr_block_allocator
+
+inline void _dstr_set_size(dstr* s, size_t size) {
+
+    switch (_dstr_category(s)) {
+    case _DSTR_SMALL:
+        _dstr_set_small(s, size);
+        break;
+    case _DSTR_SMALL_ALLOCATOR:
+        assert(size < _DSTR_SSO_ALLOCATOR_CAPACITY);
+        s->u.small[DSTR_SSO_CAPACITY - 1] = _DSTR_SMALL_TAG(_DSTR_SMALL_ALLOCATOR, (_DSTR_SSO_ALLOCATOR_CAPACITY - 1) - size);
+        s->u.small[size] = '\0';
+        break;
+    default:
+        s->u.large.size = size;
+        s->u.large.data[size] = '\0';
+        break;
+    }
+} // _dstr_set_size
+
+inline void _dstr_set_small(dstr* s, size_t size) {
+
+    assert(size < DSTR_SSO_CAPACITY);
+
+    // When the string is full the tag is 0 and is also the '\0'
+    s->u.small[DSTR_SSO_CAPACITY - 1] = _DSTR_SMALL_TAG(_DSTR_SMALL, (DSTR_SSO_CAPACITY - 1) - size);
+    s->u.small[size] = '\0';
+} // _dstr_set_small
+
+inline void _dstr_set_small_with_allocator(dstr* s, size_t size, const dstr_allocator* attached) {
+
+    if (!attached) {
+        _dstr_set_small(s, size);
+    } else {
+        memcpy(s->u.small + _DSTR_SSO_ALLOCATOR_OFFSET, (const void*)&attached, sizeof(attached));
+        s->u.small[DSTR_SSO_CAPACITY - 1] = _DSTR_SMALL_TAG(_DSTR_SMALL_ALLOCATOR, 0);
+        _dstr_set_size(s, size);
+    }
+} // _dstr_set_small_with_allocator
+
+inline void _dstr_set_large(dstr* s, dstr_char_t* data, size_t size, size_t capacity, int category) {
+
+    assert(category != _DSTR_SMALL);
+    assert(_DSTR_CAPACITY_DECODE(_DSTR_CAPACITY_ENCODE(capacity, category)) == capacity);
+
+    s->u.large.data = data;
+    s->u.large.size = size;
+    s->u.large.capacity = _DSTR_CAPACITY_ENCODE(capacity, category);
+} // _dstr_set_large
+
+inline void _dstr_set_heap(dstr* s, dstr_char_t* data, size_t size, size_t capacity, const dstr_allocator* attached) {
+
+    assert(!attached || attached == _dstr_block_allocator(data));
+
+    _dstr_set_large(s, data, size, capacity, _DSTR_HEAP);
+    if (attached) {
+        s->u.large.capacity |= _DSTR_ATTACHED_BIT;
+    }
+} // _dstr_set_heap
+
+inline size_t _dstr_small_capacity(const dstr_allocator* attached) {
+
+    return attached
+        ? _DSTR_SSO_ALLOCATOR_CAPACITY
+        : (size_t)DSTR_SSO_CAPACITY;
+} // _dstr_small_capacity
+
+dstr_char_t* _dstr_allocate(const dstr_allocator* allocator, size_t capacity) {
+
+    _dstr_block* block = (_dstr_block*)allocator->alloc(allocator->user_data, sizeof(_dstr_block) + capacity * sizeof(dstr_char_t));
+    assert(block);
+
+    block->allocator = allocator;
+    block->refcount = 1;
+
+    _DSTR_STATS_ADD(allocations, 1);
+    _DSTR_STATS_MAX(peak_capacity, capacity);
+
+    return (dstr_char_t*)(block + 1);
+} // _dstr_allocate
+
+void* _dstr_huge_alloc(void* user_data, size_t size) {
+
+#ifdef DSTR_MMAP
+    const dstr_huge_options* options = user_data ? (const dstr_huge_options*)user_data : &dstr_default_huge_options;
+
+    if (size >= options->threshold) {
+        return _dstr_huge_map(options, _dstr_huge_mapped_size(size));
+    }
+#else
+    (void)user_data;
+#endif
+
+    return malloc(size);
+} // _dstr_huge_alloc
+
+void* _dstr_huge_realloc(void* user_data, void* ptr, size_t old_size, size_t new_size) {
+
+#ifdef DSTR_MMAP
+    const dstr_huge_options* options = user_data ? (const dstr_huge_options*)user_data : &dstr_default_huge_options;
+    int old_mapped = old_size >= options->threshold;
+    int new_mapped = new_size >= options->threshold;
+
+    if (old_mapped && new_mapped) {
+
+        size_t old_mapped_size = _dstr_huge_mapped_size(old_size);
+        size_t new_mapped_size = _dstr_huge_mapped_size(new_size);
+        void* result;
+
+        if (old_mapped_size == new_mapped_size) {
+            return ptr;
+        }
+#if defined(__linux__) && defined(MREMAP_MAYMOVE)
+        // Pages are moved, not copied.
+        result = mremap(ptr, old_mapped_size, new_mapped_size, MREMAP_MAYMOVE);
+        if (result == MAP_FAILED) {
+            return 0;
+        }
+#ifdef MADV_HUGEPAGE
+        if (options->huge_pages) {
+            madvise(result, new_mapped_size, MADV_HUGEPAGE);
+        }
+#endif
+#else
+        result = _dstr_huge_map(options, new_mapped_size);
+        if (result) {
+            memcpy(result, ptr, old_size < new_size ? old_size : new_size);
+            munmap(ptr, old_mapped_size);
+        }
+#endif
+        return result;
+    }
+
+    if (old_mapped || new_mapped) {
+
+        void* result = _dstr_huge_alloc(user_data, new_size);
+
+        if (result) {
+            memcpy(result, ptr, old_size < new_size ? old_size : new_size);
+            _dstr_huge_free(user_data, ptr, old_size);
+        }
+        return result;
+    }
+#else
+    (void)user_data;
+    (void)old_size;
+#endif
+
+    return realloc(ptr, new_size);
+} // _dstr_huge_realloc
+
+void _dstr_huge_free(void* user_data, void* ptr, size_t size) {
+
+#ifdef DSTR_MMAP
+    const dstr_huge_options* options = user_data ? (const dstr_huge_options*)user_data : &dstr_default_huge_options;
+
+    if (size >= options->threshold) {
+        munmap(ptr, _dstr_huge_mapped_size(size));
+        return;
+    }
+#else
+    (void)user_data;
+    (void)size;
+#endif
+
+    free(ptr);
+} // _dstr_huge_free
+
+#ifdef DSTR_MMAP
+
+inline size_t _dstr_huge_mapped_size(size_t size) {
+
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    return (size + page_size - 1) & ~(page_size - 1);
+} // _dstr_huge_mapped_size
+
+void* _dstr_huge_map(const dstr_huge_options* options, size_t mapped_size) {
+
+    void* result = mmap(0, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (result == MAP_FAILED) {
+        return 0;
+    }
+#ifdef MADV_HUGEPAGE
+    if (options->huge_pages) {
+        madvise(result, mapped_size, MADV_HUGEPAGE);
+    }
+#else
+    (void)options;
+#endif
+
+    return result;
+} // _dstr_huge_map
+
+#endif
+
+dstr_char_t* _dstr_reallocate(dstr_char_t* data, size_t old_capacity, size_t new_capacity) {
+
+    _dstr_block* block = (_dstr_block*)data - 1;
+    const dstr_allocator* allocator = block->allocator;
+
+    block = (_dstr_block*)allocator->realloc(allocator->user_data, block,
+                                             sizeof(_dstr_block) + old_capacity * sizeof(dstr_char_t),
+                                             sizeof(_dstr_block) + new_capacity * sizeof(dstr_char_t));
+    assert(block);
+
+    _DSTR_STATS_ADD(reallocations, 1);
+    _DSTR_STATS_MAX(peak_capacity, new_capacity);
+
+    return (dstr_char_t*)(block + 1);
+} // _dstr_reallocate
+
+void _dstr_deallocate(dstr_char_t* data, size_t capacity) {
+
+    _dstr_block* block = (_dstr_block*)data - 1;
+    const dstr_allocator* allocator = block->allocator;
+
+    // A single owner can't be shared concurrently, the atomic decrement is skipped.
+    if (DSTR_ATOMIC_LOAD(&block->refcount) == 1 || DSTR_ATOMIC_DECREMENT(&block->refcount) == 0) {
+        allocator->free(allocator->user_data, block, sizeof(_dstr_block) + capacity * sizeof(dstr_char_t));
+        _DSTR_STATS_ADD(frees, 1);
+    }
+} // _dstr_deallocate
+
+void _dstr_unshare(dstr* s) {
+
+    size_t size = dstr_size(s);
+    size_t capacity = dstr_capacity(s);
+    dstr_char_t* old_data = s->u.large.data;
+    const dstr_allocator* attached = dstr_get_attached_allocator(s);
+    dstr_char_t* new_data = _dstr_allocate(attached ? attached : dstr_get_thread_allocator(), capacity);
+
+    memcpy(new_data, old_data, (size + 1) * sizeof(dstr_char_t)); // +1 for '\0'
+    _DSTR_STATS_ADD(copied_bytes, (size + 1) * sizeof(dstr_char_t));
+
+    _dstr_set_heap(s, new_data, size, capacity, attached);
+    _dstr_deallocate(old_data, capacity);
+} // _dstr_unshare
+
+inline void _dstr_discard(dstr* s) {
+
+    if (dstr_is_shared(s)) {
+        dstr_clear(s);
+    } else {
+        _dstr_set_size(s, 0);
+    }
+} // _dstr_discard
+
+size_t _dstr_growing_policy(dstr* s, size_t needed_size) {
+
+    const dstr_growth_policy* policy = dstr_get_thread_growth_policy();
+    size_t capacity = dstr_capacity(s);
+    // Split to not overflow with large capacities
+    size_t increase = capacity / 100 * policy->factor_percent + capacity % 100 * policy->factor_percent / 100;
+    size_t new_capacity = capacity + increase;
+
+    // Use the greatest of needed_size, new_capacity and min_capacity
+    if (new_capacity < needed_size) {
+        new_capacity = needed_size;
+    }
+    if (new_capacity < policy->min_capacity) {
+        new_capacity = policy->min_capacity;
+    }
+
+    if (policy->round_to_size_class) {
+        size_t block_size = 1;
+        while (block_size < sizeof(_dstr_block) + new_capacity * sizeof(dstr_char_t) && block_size * 2 > block_size) {
+            block_size *= 2;
+        }
+        if (block_size >= sizeof(_dstr_block) + new_capacity * sizeof(dstr_char_t)) {
+            new_capacity = (block_size - sizeof(_dstr_block)) / sizeof(dstr_char_t);
+        }
+    }
+
+    return new_capacity;
+
+} // _dstr_growing_policy
+
+void* _dstr_memory_find(const void* memory_ptr, size_t mem_len, const void* pattern_ptr, size_t pattern_len)
+{
+
+    const char *mem_ptr = (const char *)memory_ptr;
+    const char *patt_ptr = (const char *)pattern_ptr;
+
+    // pattern_len can't be greater than mem_len
+    if ((mem_len == 0) || (pattern_len == 0) || pattern_len > mem_len) {
+        return 0;
+    }
+
+    // pattern is a char
+    if (pattern_len == 1) {
+        return memchr((void*)mem_ptr, *patt_ptr, mem_len);
+    }
+
+#if defined(DSTR_AVX2)
+    return _dstr_memory_find_avx2(mem_ptr, mem_len, patt_ptr, pattern_len);
+#elif defined(DSTR_SSE2)
+    return _dstr_memory_find_sse2(mem_ptr, mem_len, patt_ptr, pattern_len);
+#else
+    return _dstr_memory_find_scalar(mem_ptr, mem_len, patt_ptr, pattern_len);
+#endif
+} // _dstr_memory_find
+
+void* _dstr_memory_find_scalar(const char* mem_ptr, size_t mem_len, const char* patt_ptr, size_t pattern_len)
+{
+    const char first = patt_ptr[0];
+    const char last_char = patt_ptr[pattern_len - 1];
+
+    // Last possible position
+    const char* cur = mem_ptr;
+    const char* last = mem_ptr + mem_len - pattern_len;
+
+    while (cur <= last) {
+        // Jump to the next candidate, memchr is usually vectorized by the libc
+        cur = (const char*)memchr(cur, first, (size_t)(last - cur) + 1);
+        if (!cur) {
+            return 0;
+        }
+        // Test the last char before calling a function
+        if (cur[pattern_len - 1] == last_char && memcmp(cur + 1, patt_ptr + 1, pattern_len - 2) == 0) {
+            return (void*)cur;
+        }
+        ++cur;
+    }
+
+    return 0;
+} // _dstr_memory_find_scalar
+
+#ifdef DSTR_SSE2
+
+// Compares 16 candidates at once: a position is kept if both the first and the last char
+// of the pattern match, only then the middle of the pattern is compared.
+void* _dstr_memory_find_sse2(const char* mem_ptr, size_t mem_len, const char* patt_ptr, size_t pattern_len)
+{
+    enum { BLOCK_SIZE = 16 };
+
+    const __m128i first = _mm_set1_epi8(patt_ptr[0]);
+    const __m128i last  = _mm_set1_epi8(patt_ptr[pattern_len - 1]);
+
+    const char* cur = mem_ptr;
+    // Number of positions to test, the last chars of the block must be readable.
+    size_t positions = mem_len - pattern_len + 1;
+    size_t i = 0;
+
+    for (; i + BLOCK_SIZE <= positions; i += BLOCK_SIZE) {
+
+        const __m128i block_first = _mm_loadu_si128((const __m128i*)(cur + i));
+        const __m128i block_last  = _mm_loadu_si128((const __m128i*)(cur + i + pattern_len - 1));
+
+        const __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last));
+
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(eq);
+
+        while (mask) {
+            unsigned int bit = _dstr_bit_scan_forward(mask);
+
+            if (memcmp(cur + i + bit + 1, patt_ptr + 1, pattern_len - 2) == 0) {
+                return (void*)(cur + i + bit);
+            }
+            mask &= mask - 1; // clear the lowest bit
+        }
+    }
+
+    return _dstr_memory_find_scalar(cur + i, mem_len - i, patt_ptr, pattern_len);
+} // _dstr_memory_find_sse2
+
+inline unsigned int _dstr_bit_scan_forward(unsigned int mask)
+{
+    assert(mask);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (unsigned int)index;
+#elif defined(__GNUC__) || defined(__clang__)
+    return (unsigned int)__builtin_ctz(mask);
+#else
+    unsigned int index = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+} // _dstr_bit_scan_forward
+
+#endif // DSTR_SSE2
+
+#ifdef DSTR_AVX2
+
+// Same as _dstr_memory_find_sse2 with 32 candidates at once.
+void* _dstr_memory_find_avx2(const char* mem_ptr, size_t mem_len, const char* patt_ptr, size_t pattern_len)
+{
+    enum { BLOCK_SIZE = 32 };
+
+    const __m256i first = _mm256_set1_epi8(patt_ptr[0]);
+    const __m256i last  = _mm256_set1_epi8(patt_ptr[pattern_len - 1]);
+
+    const char* cur = mem_ptr;
+    size_t positions = mem_len - pattern_len + 1;
+    size_t i = 0;
+
+    for (; i + BLOCK_SIZE <= positions; i += BLOCK_SIZE) {
+
+        const __m256i block_first = _mm256_loadu_si256((const __m256i*)(cur + i));
+        const __m256i block_last  = _mm256_loadu_si256((const __m256i*)(cur + i + pattern_len - 1));
+
+        const __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last));
+
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(eq);
+
+        while (mask) {
+            unsigned int bit = _dstr_bit_scan_forward(mask);
+
+            if (memcmp(cur + i + bit + 1, patt_ptr + 1, pattern_len - 2) == 0) {
+                return (void*)(cur + i + bit);
+            }
+            mask &= mask - 1; // clear the lowest bit
+        }
+    }
+
+    // Less than 32 positions left
+    return _dstr_memory_find_sse2(cur + i, mem_len - i, patt_ptr, pattern_len);
+} // _dstr_memory_find_avx2
+
+#endif // DSTR_AVX2
+
+// Two-Way string matching (Crochemore-Perrin 1991).
+// The pattern is split in two parts at a critical position, the right part is compared
+// from left to right, then the left part from right to left.
+// The backward version is the same algorithm applied on the mirrored pattern and text.
+
+inline size_t _dstr_maximal_suffix(const unsigned char* pattern, size_t pattern_size, int reverse, int inverted, size_t* period)
+{
+    // Indexes are shifted by one to represent -1 as 0
+    size_t suffix = 0;    // start of the maximal suffix + 1
+    size_t candidate = 1; // start of the candidate suffix + 1
+    size_t k = 1;
+    size_t p = 1;
+
+    while (candidate + k <= pattern_size) {
+
+        unsigned char a = reverse ? pattern[pattern_size - (suffix + k)] : pattern[suffix + k - 1];
+        unsigned char b = reverse ? pattern[pattern_size - (candidate + k)] : pattern[candidate + k - 1];
+
+        if (a == b) {
+            if (k == p) {
+                candidate += p;
+                k = 1;
+            } else {
+                ++k;
+            }
+        } else if (inverted ? (a < b) : (a > b)) {
+            candidate += k;
+            k = 1;
+            p = candidate - suffix;
+        } else {
+            suffix = candidate;
+            ++candidate;
+            k = p = 1;
+        }
+    }
+
+    *period = p;
+    return suffix;
+} // _dstr_maximal_suffix
+
+void _dstr_two_way_init(_dstr_two_way* tw, const unsigned char* pattern, size_t pattern_size, int reverse)
+{
+    size_t period;
+    size_t inverted_period;
+    size_t critical = _dstr_maximal_suffix(pattern, pattern_size, reverse, 0, &period);
+    size_t inverted_critical = _dstr_maximal_suffix(pattern, pattern_size, reverse, 1, &inverted_period);
+    size_t i;
+
+    // Use the latest of both maximal suffixes
+    if (inverted_critical > critical) {
+        critical = inverted_critical;
+        period = inverted_period;
+    }
+
+    tw->critical = critical;
+
+    // Periodic pattern if the left part is repeated at 'period'
+    int periodic = critical + period <= pattern_size;
+    for (i = 0; periodic && i < critical; ++i) {
+        unsigned char a = reverse ? pattern[pattern_size - 1 - i] : pattern[i];
+        unsigned char b = reverse ? pattern[pattern_size - 1 - (i + period)] : pattern[i + period];
+        periodic = a == b;
+    }
+
+    if (periodic) {
+        tw->period = period;
+        tw->memory = pattern_size - period;
+    } else {
+        size_t left = critical - 1;
+        size_t right = pattern_size - critical;
+        tw->period = (left > right ? left : right) + 1;
+        tw->memory = 0;
+    }
+
+    // Horspool: distance between the last occurrence of a char and the end of the pattern.
+    for (i = 0; i < 256; ++i) {
+        tw->skip[i] = pattern_size;
+    }
+    for (i = 0; i < pattern_size; ++i) {
+        unsigned char c = reverse ? pattern[pattern_size - 1 - i] : pattern[i];
+        tw->skip[c] = pattern_size - 1 - i;
+    }
+} // _dstr_two_way_init
+
+const dstr_char_t* _dstr_two_way_find(const _dstr_two_way* tw, const unsigned char* pattern, size_t pattern_size, const unsigned char* first, const unsigned char* last)
+{
+    const unsigned char* window = first;
+    size_t memory = 0;
+    size_t k;
+
+    if (!pattern_size) {
+        return 0;
+    }
+
+    while ((size_t)(last - window) >= pattern_size) {
+
+        // Horspool skip on the last char of the window
+        k = tw->skip[window[pattern_size - 1]];
+        if (k) {
+            if (k < memory) {
+                k = memory;
+            }
+            window += k;
+            memory = 0;
+            continue;
+        }
+
+        // Right part
+        for (k = tw->critical > memory ? tw->critical : memory; k < pattern_size && pattern[k] == window[k]; ++k) {
+        }
+        if (k < pattern_size) {
+            window += k - tw->critical + 1;
+            memory = 0;
+            continue;
+        }
+
+        // Left part
+        for (k = tw->critical; k > memory && pattern[k - 1] == window[k - 1]; --k) {
+        }
+        if (k <= memory) {
+            return (const dstr_char_t*)window;
+        }
+
+        window += tw->period;
+        memory = tw->memory;
+    }
+
+    return 0;
+} // _dstr_two_way_find
+
+const dstr_char_t* _dstr_two_way_rfind(const _dstr_two_way* tw, const unsigned char* pattern, size_t pattern_size, const unsigned char* first, const unsigned char* last)
+{
+    // 'window_end' is the end of the window, chars are read backward from it.
+    // The mirrored pattern char 'k' is pattern[pattern_size - 1 - k].
+    const unsigned char* window_end = last;
+    const unsigned char* end = pattern + pattern_size;
+    size_t memory = 0;
+    size_t k;
+
+    if (!pattern_size) {
+        return 0;
+    }
+
+    while ((size_t)(window_end - first) >= pattern_size) {
+
+        k = tw->skip[*(window_end - pattern_size)];
+        if (k) {
+            if (k < memory) {
+                k = memory;
+            }
+            window_end -= k;
+            memory = 0;
+            continue;
+        }
+
+        for (k = tw->critical > memory ? tw->critical : memory; k < pattern_size && end[-1 - (ptrdiff_t)k] == window_end[-1 - (ptrdiff_t)k]; ++k) {
+        }
+        if (k < pattern_size) {
+            window_end -= k - tw->critical + 1;
+            memory = 0;
+            continue;
+        }
+
+        for (k = tw->critical; k > memory && end[-(ptrdiff_t)k] == window_end[-(ptrdiff_t)k]; --k) {
+        }
+        if (k <= memory) {
+            return (const dstr_char_t*)(window_end - pattern_size);
+        }
+
+        window_end -= tw->period;
+        memory = tw->memory;
+    }
+
+    return 0;
+} // _dstr_two_way_rfind
+
+inline int _dstr_is_space(dstr_char_t ch)
+{
+    // '\t', '\n', '\v', '\f' and '\r' are contiguous
+    return ch == ' ' || (unsigned char)(ch - '\t') <= '\r' - '\t';
+} // _dstr_is_space
+
+size_t _dstr_find_space(const dstr_char_t* data, size_t size, int not_space)
+{
+    // Flips the mask when looking for non-whitespaces
+    unsigned int flip;
+    size_t i = 0;
+
+#ifdef DSTR_AVX2
+    flip = not_space ? 0xFFFFFFFFu : 0;
+    for (; i + 32 <= size; i += 32) {
+        unsigned int mask = _dstr_space_mask_avx2(data + i) ^ flip;
+        if (mask) {
+            return i + _dstr_bit_scan_forward(mask);
+        }
+    }
+#endif
+#ifdef DSTR_SSE2
+    flip = not_space ? 0xFFFFu : 0;
+    for (; i + 16 <= size; i += 16) {
+        unsigned int mask = _dstr_space_mask_sse2(data + i) ^ flip;
+        if (mask) {
+            return i + _dstr_bit_scan_forward(mask);
+        }
+    }
+#endif
+
+    flip = not_space ? 1 : 0;
+    for (; i < size; ++i) {
+        if ((unsigned int)_dstr_is_space(data[i]) ^ flip) {
+            return i;
+        }
+    }
+
+    return size;
+} // _dstr_find_space
+
+size_t _dstr_rtrimmed_size(const dstr_char_t* data, size_t size)
+{
+    // Blocks are read backward from the end
+#ifdef DSTR_AVX2
+    for (; size >= 32; size -= 32) {
+        unsigned int mask = _dstr_space_mask_avx2(data + size - 32) ^ 0xFFFFFFFFu;
+        if (mask) {
+            return size - 32 + _dstr_bit_scan_reverse(mask) + 1;
+        }
+    }
+#endif
+#ifdef DSTR_SSE2
+    for (; size >= 16; size -= 16) {
+        unsigned int mask = _dstr_space_mask_sse2(data + size - 16) ^ 0xFFFFu;
+        if (mask) {
+            return size - 16 + _dstr_bit_scan_reverse(mask) + 1;
+        }
+    }
+#endif
+
+    while (size > 0 && _dstr_is_space(data[size - 1])) {
+        --size;
+    }
+
+    return size;
+} // _dstr_rtrimmed_size
+
+void _dstr_flip_ascii_case(dstr_char_t* data, size_t size, dstr_char_t first)
+{
+    size_t i = 0;
+
+    // A char is in range if (ch - first) <= 25 as unsigned, 0x20 is the case bit.
+#ifdef DSTR_AVX2
+    {
+        const __m256i first_256 = _mm256_set1_epi8(first);
+        const __m256i range_256 = _mm256_set1_epi8(25);
+        const __m256i bit_256   = _mm256_set1_epi8(0x20);
+
+        for (; i + 32 <= size; i += 32) {
+            __m256i block = _mm256_loadu_si256((const __m256i*)(data + i));
+            __m256i offset = _mm256_sub_epi8(block, first_256);
+            __m256i in_range = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, range_256), offset);
+            block = _mm256_xor_si256(block, _mm256_and_si256(in_range, bit_256));
+            _mm256_storeu_si256((__m256i*)(data + i), block);
+        }
+    }
+#endif
+#ifdef DSTR_SSE2
+    {
+        const __m128i first_128 = _mm_set1_epi8(first);
+        const __m128i range_128 = _mm_set1_epi8(25);
+        const __m128i bit_128   = _mm_set1_epi8(0x20);
+
+        for (; i + 16 <= size; i += 16) {
+            __m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+            __m128i offset = _mm_sub_epi8(block, first_128);
+            __m128i in_range = _mm_cmpeq_epi8(_mm_min_epu8(offset, range_128), offset);
+            block = _mm_xor_si128(block, _mm_and_si128(in_range, bit_128));
+            _mm_storeu_si128((__m128i*)(data + i), block);
+        }
+    }
+#endif
+
+    for (; i < size; ++i) {
+        if ((unsigned char)(data[i] - first) <= 25) {
+            data[i] ^= 0x20;
+        }
+    }
+} // _dstr_flip_ascii_case
+
+#ifdef DSTR_SSE2
+
+inline unsigned int _dstr_space_mask_sse2(const dstr_char_t* data)
+{
+    const __m128i block = _mm_loadu_si128((const __m128i*)data);
+    const __m128i space = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+    // '\t' to '\r': (ch - '\t') <= 4 as unsigned
+    const __m128i offset = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+    const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8('\r' - '\t')), offset);
+
+    return (unsigned int)_mm_movemask_epi8(_mm_or_si128(space, control));
+} // _dstr_space_mask_sse2
+
+inline unsigned int _dstr_bit_scan_reverse(unsigned int mask)
+{
+    assert(mask);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return (unsigned int)index;
+#elif defined(__GNUC__) || defined(__clang__)
+    return (unsigned int)(31 - __builtin_clz(mask));
+#else
+    unsigned int index = 31;
+    while (!(mask & 0x80000000u)) {
+        mask <<= 1;
+        --index;
+    }
+    return index;
+#endif
+} // _dstr_bit_scan_reverse
+
+#endif // DSTR_SSE2
+
+#ifdef DSTR_AVX2
+
+inline unsigned int _dstr_space_mask_avx2(const dstr_char_t* data)
+{
+    const __m256i block = _mm256_loadu_si256((const __m256i*)data);
+    const __m256i space = _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' '));
+    const __m256i offset = _mm256_sub_epi8(block, _mm256_set1_epi8('\t'));
+    const __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8('\r' - '\t')), offset);
+
+    return (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(space, control));
+} // _dstr_space_mask_avx2
+
+#endif // DSTR_AVX2
+
+static const dstr_char_t _dstr_digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const dstr_char_t _dstr_hex_digits[] = "0123456789abcdef";
+
+inline size_t _dstr_digit_count(uint64_t value)
+{
+    // Four digits per division
+    size_t count = 1;
+    for (;;) {
+        if (value < 10) return count;
+        if (value < 100) return count + 1;
+        if (value < 1000) return count + 2;
+        if (value < 10000) return count + 3;
+        value /= 10000;
+        count += 4;
+    }
+} // _dstr_digit_count
+
+inline size_t _dstr_hex_digit_count(uint64_t value)
+{
+    size_t count = 1;
+    while (value >>= 4) {
+        ++count;
+    }
+    return count;
+} // _dstr_hex_digit_count
+
+inline void _dstr_write_digits(dstr_char_t* end, uint64_t value)
+{
+    // Two digits per division
+    while (value >= 100) {
+        size_t pair = (size_t)(value % 100) * 2;
+        value /= 100;
+        *--end = _dstr_digit_pairs[pair + 1];
+        *--end = _dstr_digit_pairs[pair];
+    }
+
+    if (value >= 10) {
+        size_t pair = (size_t)value * 2;
+        *--end = _dstr_digit_pairs[pair + 1];
+        *--end = _dstr_digit_pairs[pair];
+    } else {
+        *--end = (dstr_char_t)('0' + value);
+    }
+} // _dstr_write_digits
+
+inline void _dstr_write_hex_digits(dstr_char_t* end, uint64_t value)
+{
+    do {
+        *--end = _dstr_hex_digits[value & 0xF];
+        value >>= 4;
+    } while (value);
+} // _dstr_write_hex_digits
+
+void _dstr_append_integer(dstr* s, uint64_t value, dstr_char_t sign, size_t width, int hex)
+{
+    size_t size = dstr_size(s);
+    size_t sign_count = sign ? 1 : 0;
+    size_t digit_count = hex ? _dstr_hex_digit_count(value) : _dstr_digit_count(value);
+    size_t count = sign_count + digit_count;
+    size_t padding = width > count ? width - count : 0;
+    size_t capacity_needed = size + count + padding + 1; // +1 for '\0'
+
+    _DSTR_GROW_IF_NEEDED(s, capacity_needed);
+
+    dstr_char_t* first = dstr_data(s) + size;
+    dstr_char_t* last = first + count + padding;
+
+    if (sign) {
+        *first++ = sign;
+    }
+    memset(first, '0', padding * sizeof(dstr_char_t));
+
+    if (hex) {
+        _dstr_write_hex_digits(last, value);
+    } else {
+        _dstr_write_digits(last, value);
+    }
+
+    _dstr_set_size(s, size + count + padding);
+} // _dstr_append_integer
+
+void _dstr_append_pieces(dstr* s, dstr_view separator, const dstr_view* views, const dstr* dstrs, size_t count)
+{
+    size_t size = dstr_size(s);
+    size_t total = count ? separator.size * (count - 1) : 0;
+    const dstr_char_t* old_data = dstr_data(s);
+    dstr_char_t* data;
+    dstr_char_t* write;
+    size_t i;
+
+    if (!count) {
+        return;
+    }
+
+    for (i = 0; i < count; ++i) {
+        total += views ? views[i].size : dstr_size(&dstrs[i]);
+    }
+
+    // Exact size, the buffer is not expected to grow again.
+    if (size + total + 1 > dstr_capacity(s)) { // +1 for '\0'
+        dstr_reserve(s, size + total + 1);
+    } else {
+        _DSTR_UNSHARE_IF_NEEDED(s);
+    }
+
+    data = dstr_data(s);
+    write = data + size;
+
+    // Views of 's' follow the buffer. The size of 's' is only set at the end, a dstr piece can be 's'.
+    if (separator.data >= old_data && separator.data < old_data + size) {
+        separator.data = data + (separator.data - old_data);
+    }
+
+    for (i = 0; i < count; ++i) {
+        dstr_view piece = views ? views[i] : dstr_view_make_from_dstr(&dstrs[i]);
+
+        if (piece.data >= old_data && piece.data < old_data + size) {
+            piece.data = data + (piece.data - old_data);
+        }
+        if (i && separator.size) {
+            memcpy(write, separator.data, separator.size * sizeof(dstr_char_t));
+            write += separator.size;
+        }
+        memcpy(write, piece.data, piece.size * sizeof(dstr_char_t));
+        write += piece.size;
+    }
+
+    _dstr_set_size(s, size + total);
+} // _dstr_append_pieces
 
 //-------------------------------------------------------------------------
 // dstr - Private Implementation - END
@@ -0,0 +1,377 @@
+// dstr.hpp - v0.1 - kevreco - CC0 1.0 Licence (public domain)
+// C++ wrapper of dstr (RAII, move semantics, std::string_view)
+// https://github.com/kevreco/re_lib
+
+/*
+
+NOTES:
+=====
+
+- Depends on dstr.h, C++17 (std::string_view).
+- re::basic_dstr<Allocator, InlineCapacity> owns a dstr, it's released by the destructor.
+- Copies are deep copies (like std::string), use share() to share the buffer (see "Shared buffers" in dstr.h).
+- Moves steal the heap buffer: moving a string (std::vector growth, std::swap, ...) never touches its heap buffer,
+  inline chars are copied.
+- Allocator is a policy type with a static 'get' function returning the dstr_allocator to attach
+  (re::thread_allocator, re::malloc_allocator, re::huge_allocator or your own). re::thread_allocator
+  returns 0: nothing is attached, the thread allocator of the moment is used.
+- InlineCapacity: number of chars (including '\0') stored in the object without allocation.
+  Values up to DSTR_SSO_CAPACITY use the inline buffer of dstr, larger values add a buffer to the object.
+- Iterators are pointers. Non-const access (data, begin, operator[], ...) copies a shared buffer first.
+- The underlying dstr can be passed to C functions with c(). C functions growing the string
+  use the thread allocator while the extra inline buffer is used.
+- Unit tests are made in ./testsuite/
+
+CHANGES (DD/MM/YYYY):
+====================
+
+- 16/10/2026 (0.1) - First implementation
+
+EXAMPLE:
+=======
+
+    std::vector<re::dstr> lines;
+
+    re::dstr line = "first";
+    line += ", second";
+    lines.push_back(std::move(line)); // No copy of the chars
+
+    typedef re::basic_dstr<re::malloc_allocator, 64> path; // 63 chars without allocation
+
+    path p = "/usr";
+    p += "/local";
+
+    std::string_view v = p;
+
+*/
+
+#ifndef RE_DSTR_HPP
+#define RE_DSTR_HPP
+
+#include "dstr.h"
+
+#include <cstddef>     // std::size_t
+#include <cstring>     // memcpy, memset
+#include <iterator>    // std::reverse_iterator
+#include <string_view> // std::string_view
+#include <utility>     // std::move
+
+namespace re {
+
+//-------------------------------------------------------------------------
+// dstr.hpp - API - BEGIN
+//-------------------------------------------------------------------------
+
+// Allocator policies
+
+struct thread_allocator {
+    static const dstr_allocator* get() { return 0; }
+};
+
+struct malloc_allocator {
+    static const dstr_allocator* get() { return &dstr_malloc_allocator; }
+};
+
+struct huge_allocator {
+    static const dstr_allocator* get() { return &dstr_huge_allocator; }
+};
+
+namespace detail {
+
+// Extra inline buffer, only when it's larger than the one of dstr.
+template <std::size_t Capacity, bool Extra = (Capacity > DSTR_SSO_CAPACITY)>
+struct inline_buffer {
+    static const std::size_t inline_capacity = 0;
+    char* inline_data() { return 0; }
+};
+
+template <std::size_t Capacity>
+struct inline_buffer<Capacity, true> {
+    static const std::size_t inline_capacity = Capacity;
+    char* inline_data() { return chars; }
+    char chars[Capacity];
+};
+
+} // namespace detail
+
+// inline_buffer is a base class: without extra buffer it takes no space (empty base).
+template <class Allocator = thread_allocator, std::size_t InlineCapacity = DSTR_SSO_CAPACITY>
+class basic_dstr : private detail::inline_buffer<InlineCapacity> {
+public:
+
+    typedef char value_type;
+    typedef std::size_t size_type;
+    typedef char* iterator;
+    typedef const char* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    static const size_type npos = DSTR_NPOS;
+
+    /// Constructors
+
+    basic_dstr() noexcept { init(); }
+    basic_dstr(const char* str) { init(); append(std::string_view(str)); }
+    basic_dstr(const char* str, size_type size) { init(); append(std::string_view(str, size)); }
+    basic_dstr(size_type count, char ch) { init(); append(count, ch); }
+    explicit basic_dstr(std::string_view v) { init(); append(v); }
+    explicit basic_dstr(dstr_view v) { init(); append(std::string_view(v.data, v.size)); }
+
+    basic_dstr(const basic_dstr& other) { init(); append(std::string_view(other)); }
+    basic_dstr(basic_dstr&& other) noexcept { init(); steal(other); }
+
+    ~basic_dstr() { dstr_clear(&s); }
+
+    basic_dstr& operator=(const basic_dstr& other) { if (this != &other) { assign(std::string_view(other)); } return *this; }
+    basic_dstr& operator=(basic_dstr&& other) noexcept { if (this != &other) { dstr_clear(&s); init(); steal(other); } return *this; }
+    basic_dstr& operator=(std::string_view v) { return assign(v); }
+    basic_dstr& operator=(const char* str) { return assign(std::string_view(str)); }
+
+    /// Element access
+
+    const char* data() const noexcept { return dstr_data(&s); }
+    char*       data() { dstr_unshare(&s); return dstr_data(&s); }
+    const char* c_str() const noexcept { return dstr_c_str(&s); }
+
+    const char& operator[](size_type index) const noexcept { return data()[index]; }
+    char&       operator[](size_type index) { return data()[index]; }
+    const char& front() const noexcept { return data()[0]; }
+    const char& back() const noexcept { return data()[size() - 1]; }
+
+    /// Iterators
+
+    iterator       begin() { return data(); }
+    iterator       end() { return data() + size(); }
+    const_iterator begin() const noexcept { return data(); }
+    const_iterator end() const noexcept { return data() + size(); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    reverse_iterator       rbegin() { return reverse_iterator(end()); }
+    reverse_iterator       rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+    /// Capacity
+
+    size_type size() const noexcept { return dstr_size(&s); }
+    size_type length() const noexcept { return dstr_size(&s); }
+    size_type capacity() const noexcept { return dstr_capacity(&s); }
+    bool      empty() const noexcept { return dstr_empty(&s) != 0; }
+
+    void reserve(size_type capacity) { prepare(capacity); dstr_reserve(&s, capacity); }
+    void shrink_to_fit();
+    void clear() noexcept { dstr_clear(&s); init(); }
+
+    /// Modifiers
+
+    basic_dstr& append(std::string_view v) { prepare_growth(size() + v.size() + 1); dstr_append_view(&s, to_view(v)); return *this; }
+    basic_dstr& append(size_type count, char ch) { prepare_growth(size() + count + 1); dstr_append_nchar(&s, count, ch); return *this; }
+    basic_dstr& assign(std::string_view v) { prepare_growth(v.size() + 1); dstr_assign_view(&s, to_view(v)); return *this; }
+
+    basic_dstr& operator+=(std::string_view v) { return append(v); }
+    basic_dstr& operator+=(const char* str) { return append(std::string_view(str)); }
+    basic_dstr& operator+=(char ch) { push_back(ch); return *this; }
+
+    void push_back(char ch) { prepare_growth(size() + 2); dstr_append_char(&s, ch); }
+    void pop_back() { dstr_pop_back(&s); }
+
+    basic_dstr& insert(size_type pos, std::string_view v);
+    basic_dstr& erase(size_type pos = 0, size_type count = npos);
+    basic_dstr& replace(size_type pos, size_type count, std::string_view v);
+
+    void resize(size_type size, char ch = '\0');
+    void swap(basic_dstr& other) noexcept { basic_dstr tmp(std::move(other)); other = std::move(*this); *this = std::move(tmp); }
+
+    /// Operations
+
+    size_type find(std::string_view v, size_type pos = 0) const noexcept { return dstr_find_view(&s, pos, to_view(v)); }
+    size_type find(char ch, size_type pos = 0) const noexcept { return dstr_view_find_char(view(), pos, ch); }
+    bool starts_with(std::string_view v) const noexcept { return dstr_starts_with(&s, to_view(v)) != 0; }
+    bool ends_with(std::string_view v) const noexcept { return dstr_ends_with(&s, to_view(v)) != 0; }
+    int  compare(std::string_view v) const noexcept { return dstr_compare_view(&s, to_view(v)); }
+
+    // Copy of [pos, pos + count), see view() for a zero-copy slice.
+    basic_dstr substr(size_type pos = 0, size_type count = npos) const { return basic_dstr(dstr_substr(&s, pos, count)); }
+
+    /// Interop
+
+    operator std::string_view() const noexcept { return std::string_view(data(), size()); }
+    dstr_view view() const noexcept { return dstr_view_make_from_dstr(&s); }
+    dstr_view view(size_type pos, size_type count = npos) const noexcept { return dstr_substr(&s, pos, count); }
+
+    // Underlying dstr for C functions, it must not be cleared or moved.
+    ::dstr*       c() noexcept { return &s; }
+    const ::dstr* c() const noexcept { return &s; }
+
+    // Shares the heap buffer instead of copying it (see dstr_make_shared).
+    basic_dstr share() const { basic_dstr result; result.prepare(0); dstr_assign_shared(&result.s, &s); return result; }
+
+    friend bool operator==(const basic_dstr& a, std::string_view b) noexcept { return a.compare(b) == 0; }
+    friend bool operator!=(const basic_dstr& a, std::string_view b) noexcept { return a.compare(b) != 0; }
+    friend bool operator<(const basic_dstr& a, std::string_view b) noexcept { return a.compare(b) < 0; }
+    friend bool operator<=(const basic_dstr& a, std::string_view b) noexcept { return a.compare(b) <= 0; }
+    friend bool operator>(const basic_dstr& a, std::string_view b) noexcept { return a.compare(b) > 0; }
+    friend bool operator>=(const basic_dstr& a, std::string_view b) noexcept { return a.compare(b) >= 0; }
+
+private:
+
+    static dstr_view to_view(std::string_view v) noexcept { return dstr_view_make(v.data(), v.size()); }
+    // Returns true if 'v' points inside the chars of the string.
+    bool aliases(std::string_view v) const noexcept { return v.data() >= data() && v.data() <= data() + size(); }
+    // Read-only dstr over 'v', like dstr_make_ref.
+    static ::dstr to_ref(std::string_view v) noexcept { ::dstr r; _dstr_set_large(&r, (char*)v.data(), v.size(), v.size() + 1, _DSTR_EXTERNAL); return r; }
+
+    // Empty string using the extra inline buffer if there is one.
+    void init() noexcept;
+    // Takes the content of 'other' (empty), 'other' is left empty.
+    void steal(basic_dstr& other) noexcept;
+    bool uses_inline_buffer() const noexcept { return buffer::inline_capacity && dstr_data(&s) == const_cast<basic_dstr*>(this)->inline_data(); }
+    // Leaves the extra inline buffer if 'capacity' does not fit, the heap buffer comes from the allocator.
+    void prepare(size_type capacity);
+    // Same as above, with the growth policy.
+    void prepare_growth(size_type capacity);
+
+    typedef detail::inline_buffer<InlineCapacity> buffer;
+
+    mutable ::dstr s; // mutable: dstr_unshare on shared buffers
+};
+
+typedef basic_dstr<> dstr;
+
+static_assert(sizeof(re::dstr) == sizeof(::dstr), "re::dstr must not be larger than dstr");
+
+//-------------------------------------------------------------------------
+// dstr.hpp - API - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr.hpp - Implementation - BEGIN
+//-------------------------------------------------------------------------
+
+template <class Allocator, std::size_t InlineCapacity>
+void basic_dstr<Allocator, InlineCapacity>::shrink_to_fit() {
+
+    if (buffer::inline_capacity && !uses_inline_buffer() && size() < buffer::inline_capacity) {
+        basic_dstr tmp(view());
+        *this = std::move(tmp);
+    } else if (!uses_inline_buffer()) {
+        dstr_shrink_to_fit(&s);
+    }
+} // shrink_to_fit
+
+template <class Allocator, std::size_t InlineCapacity>
+basic_dstr<Allocator, InlineCapacity>& basic_dstr<Allocator, InlineCapacity>::insert(size_type pos, std::string_view v) {
+
+    assert(pos <= size());
+
+    // dstr_replace_with_dstr does not support chars inside 's'.
+    if (aliases(v)) {
+        basic_dstr copy(v);
+        return insert(pos, std::string_view(copy));
+    }
+
+    prepare_growth(size() + v.size() + 1);
+    ::dstr ref = to_ref(v);
+    dstr_replace_with_dstr(&s, pos, 0, &ref);
+    return *this;
+} // insert
+
+template <class Allocator, std::size_t InlineCapacity>
+basic_dstr<Allocator, InlineCapacity>& basic_dstr<Allocator, InlineCapacity>::erase(size_type pos, size_type count) {
+
+    dstr_view erased = dstr_substr(&s, pos, count);
+
+    if (erased.size) {
+        dstr_erase_range(&s, dstr_begin(&s) + pos, dstr_begin(&s) + pos + erased.size);
+    }
+    return *this;
+} // erase
+
+template <class Allocator, std::size_t InlineCapacity>
+basic_dstr<Allocator, InlineCapacity>& basic_dstr<Allocator, InlineCapacity>::replace(size_type pos, size_type count, std::string_view v) {
+
+    dstr_view replaced = dstr_substr(&s, pos, count);
+
+    // dstr_replace_with_dstr does not support chars inside 's'.
+    if (aliases(v)) {
+        basic_dstr copy(v);
+        return replace(pos, count, std::string_view(copy));
+    }
+
+    prepare_growth(size() - replaced.size + v.size() + 1);
+    ::dstr ref = to_ref(v);
+    dstr_replace_with_dstr(&s, pos, replaced.size, &ref);
+    return *this;
+} // replace
+
+template <class Allocator, std::size_t InlineCapacity>
+void basic_dstr<Allocator, InlineCapacity>::resize(size_type new_size, char ch) {
+
+    if (!new_size) {
+        clear();
+    } else {
+        prepare_growth(new_size + 1);
+        dstr_resize_fill(&s, new_size, ch);
+    }
+} // resize
+
+template <class Allocator, std::size_t InlineCapacity>
+void basic_dstr<Allocator, InlineCapacity>::init() noexcept {
+
+    if (buffer::inline_capacity) {
+        s = dstr_make_with_buffer(this->inline_data(), buffer::inline_capacity);
+        this->inline_data()[0] = '\0';
+    } else {
+        // Inline strings only set the tag: GCC warns about 'u.large.size' being read uninitialized (dstr_size).
+        std::memset(&s, 0, sizeof(s));
+        dstr_init_with_allocator(&s, Allocator::get());
+    }
+} // init
+
+template <class Allocator, std::size_t InlineCapacity>
+void basic_dstr<Allocator, InlineCapacity>::steal(basic_dstr& other) noexcept {
+
+    if (other.uses_inline_buffer()) {
+        // Inline chars can't be stolen, at most InlineCapacity chars are copied.
+        size_type size = other.size();
+        memcpy(this->inline_data(), other.inline_data(), size + 1); // +1 for '\0'
+        _dstr_set_large(&s, this->inline_data(), size, buffer::inline_capacity, _DSTR_EXTERNAL);
+    } else {
+        // Heap pointer, or chars inside the dstr (they are moved with it).
+        s = other.s;
+    }
+    other.init();
+} // steal
+
+template <class Allocator, std::size_t InlineCapacity>
+void basic_dstr<Allocator, InlineCapacity>::prepare(size_type capacity) {
+
+    if (buffer::inline_capacity && capacity > buffer::inline_capacity && uses_inline_buffer()) {
+        ::dstr grown;
+
+        dstr_init_with_allocator(&grown, Allocator::get());
+        dstr_reserve(&grown, capacity);
+        dstr_append_view(&grown, view());
+        s = grown;
+    } else if (buffer::inline_capacity && !capacity && uses_inline_buffer()) {
+        // Leaves the inline buffer for a string without chars.
+        dstr_init_with_allocator(&s, Allocator::get());
+    }
+} // prepare
+
+template <class Allocator, std::size_t InlineCapacity>
+void basic_dstr<Allocator, InlineCapacity>::prepare_growth(size_type capacity) {
+
+    if (buffer::inline_capacity && capacity > buffer::inline_capacity && uses_inline_buffer()) {
+        prepare(_dstr_growing_policy(&s, capacity));
+    }
+} // prepare_growth
+
+//-------------------------------------------------------------------------
+// dstr.hpp - Implementation - END
+//-------------------------------------------------------------------------
+
+} // namespace re
+
+#endif // RE_DSTR_HPP
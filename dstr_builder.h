@@ -0,0 +1,355 @@
+// dstr_builder.h - v0.1 - kevreco - CC0 1.0 Licence (public domain)
+// Scatter-gather string builder, emits iovecs for writev/sendmsg
+// https://github.com/kevreco/re_lib
+
+/*
+
+NOTES:
+=====
+
+- Depends on dstr.h
+- A builder is a list of fragments, nothing is concatenated until dstr_builder_flatten is called.
+- Fragments can be:
+   - borrowed (pointer + size), they must outlive the builder or the next dstr_builder_reset.
+   - owned dstr, moved into the builder without copying their content.
+   - copied, for small temporary fragments (numbers, separators), consecutive copies share one fragment.
+- dstr_builder_iovecs returns an array usable with writev/sendmsg.
+   - The array is built on demand and stays valid until the builder is modified.
+   - writev accepts at most IOV_MAX (usually 1024) iovecs per call.
+- On Windows dstr_iovec has the same fields as struct iovec (iov_base, iov_len).
+- Memory comes from the thread allocator at initialization time.
+- Unit tests are made in ./testsuite/
+
+CHANGES (DD/MM/YYYY):
+====================
+
+- 16/10/2026 (0.1) - First implementation
+
+EXAMPLE:
+=======
+
+    dstr_builder builder;
+    const dstr_iovec* iovecs;
+    size_t count;
+
+    dstr_builder_init(&builder);
+
+    dstr_builder_append_str_ref(&builder, "HTTP/1.1 200 OK\r\nContent-Length: ");
+    dstr_builder_append_copy(&builder, length_buffer, length_size);
+    dstr_builder_append_str_ref(&builder, "\r\n\r\n");
+    dstr_builder_append_dstr(&builder, &body); // 'body' is moved into the builder
+
+    iovecs = dstr_builder_iovecs(&builder, &count);
+    writev(fd, iovecs, (int)count);
+
+    dstr_builder_clear(&builder);
+
+*/
+
+#ifndef RE_DSTR_BUILDER_H
+#define RE_DSTR_BUILDER_H
+
+#include "dstr.h"
+
+#if defined(_WIN32)
+typedef struct dstr_iovec {
+    void* iov_base;
+    size_t iov_len;
+} dstr_iovec;
+#else
+#include <sys/uio.h> // struct iovec
+typedef struct iovec dstr_iovec;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//-------------------------------------------------------------------------
+// dstr_builder - API - BEGIN
+//-------------------------------------------------------------------------
+
+typedef enum _dstr_builder_kind {
+    _DSTR_BUILDER_BORROWED,
+    _DSTR_BUILDER_OWNED,
+    _DSTR_BUILDER_COPIED
+} _dstr_builder_kind;
+
+typedef struct _dstr_builder_fragment {
+    _dstr_builder_kind kind;
+    const dstr_char_t* data; // Borrowed data
+    size_t index;            // Index of the owned dstr, or offset in 'copies'
+    size_t size;
+} _dstr_builder_fragment;
+
+typedef struct dstr_builder {
+    const dstr_allocator* allocator;
+    _dstr_builder_fragment* fragments;
+    size_t fragment_count;
+    size_t fragment_capacity;
+    dstr* owned;
+    size_t owned_count;
+    size_t owned_capacity;
+    dstr copies;               // Content of all copied fragments
+    dstr_iovec* iovecs;
+    size_t iovec_capacity;
+    size_t size;               // Total size of the fragments
+} dstr_builder;
+
+void   dstr_builder_init(dstr_builder* builder);
+// Releases all memory and owned dstr.
+void   dstr_builder_clear(dstr_builder* builder);
+// Removes all fragments, memory is kept for the next use.
+void   dstr_builder_reset(dstr_builder* builder);
+
+void   dstr_builder_append_ref(dstr_builder* builder, const dstr_char_t* data, size_t size);
+void   dstr_builder_append_str_ref(dstr_builder* builder, const dstr_char_t* str);
+// Moves 's' into the builder, 's' is left empty.
+void   dstr_builder_append_dstr(dstr_builder* builder, dstr* s);
+void   dstr_builder_append_copy(dstr_builder* builder, const dstr_char_t* data, size_t size);
+
+size_t dstr_builder_size(const dstr_builder* builder);
+size_t dstr_builder_fragment_count(const dstr_builder* builder);
+
+const dstr_iovec* dstr_builder_iovecs(dstr_builder* builder, size_t* count);
+// Replaces the content of 's' with the content of the builder.
+void   dstr_builder_flatten(const dstr_builder* builder, dstr* s);
+
+//-------------------------------------------------------------------------
+// dstr_builder - API - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_builder - Private - BEGIN
+//-------------------------------------------------------------------------
+
+void*  _dstr_builder_grow(dstr_builder* builder, void* array, size_t* capacity, size_t count, size_t element_size);
+_dstr_builder_fragment* _dstr_builder_push(dstr_builder* builder, _dstr_builder_kind kind, size_t size);
+const dstr_char_t* _dstr_builder_fragment_data(const dstr_builder* builder, const _dstr_builder_fragment* fragment);
+
+//-------------------------------------------------------------------------
+// dstr_builder - Private - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_builder - Implementation - BEGIN
+//-------------------------------------------------------------------------
+
+void dstr_builder_init(dstr_builder* builder) {
+
+    builder->allocator = dstr_get_thread_allocator();
+    builder->fragments = 0;
+    builder->fragment_count = 0;
+    builder->fragment_capacity = 0;
+    builder->owned = 0;
+    builder->owned_count = 0;
+    builder->owned_capacity = 0;
+    dstr_init(&builder->copies);
+    builder->iovecs = 0;
+    builder->iovec_capacity = 0;
+    builder->size = 0;
+} // dstr_builder_init
+
+void dstr_builder_clear(dstr_builder* builder) {
+
+    const dstr_allocator* allocator = builder->allocator;
+
+    dstr_builder_reset(builder);
+
+    if (builder->fragments) {
+        allocator->free(allocator->user_data, builder->fragments, builder->fragment_capacity * sizeof(_dstr_builder_fragment));
+    }
+    if (builder->owned) {
+        allocator->free(allocator->user_data, builder->owned, builder->owned_capacity * sizeof(dstr));
+    }
+    if (builder->iovecs) {
+        allocator->free(allocator->user_data, builder->iovecs, builder->iovec_capacity * sizeof(dstr_iovec));
+    }
+    dstr_clear(&builder->copies);
+
+    dstr_builder_init(builder);
+    builder->allocator = allocator;
+} // dstr_builder_clear
+
+void dstr_builder_reset(dstr_builder* builder) {
+
+    size_t i;
+
+    for (i = 0; i < builder->owned_count; ++i) {
+        dstr_clear(&builder->owned[i]);
+    }
+
+    builder->owned_count = 0;
+    builder->fragment_count = 0;
+    builder->size = 0;
+    dstr_assign_str(&builder->copies, "");
+} // dstr_builder_reset
+
+void dstr_builder_append_ref(dstr_builder* builder, const dstr_char_t* data, size_t size) {
+
+    _dstr_builder_fragment* fragment;
+
+    if (!size) {
+        return;
+    }
+
+    fragment = _dstr_builder_push(builder, _DSTR_BUILDER_BORROWED, size);
+    fragment->data = data;
+} // dstr_builder_append_ref
+
+void dstr_builder_append_str_ref(dstr_builder* builder, const dstr_char_t* str) {
+    dstr_builder_append_ref(builder, str, strlen(str));
+} // dstr_builder_append_str_ref
+
+void dstr_builder_append_dstr(dstr_builder* builder, dstr* s) {
+
+    size_t size = dstr_size(s);
+    const dstr_allocator* allocator = dstr_get_attached_allocator(s);
+    _dstr_builder_fragment* fragment;
+
+    if (!size) {
+        return;
+    }
+
+    builder->owned = (dstr*)_dstr_builder_grow(builder, builder->owned, &builder->owned_capacity, builder->owned_count, sizeof(dstr));
+
+    // A dstr can be moved with a plain copy, inline data is moved with it.
+    builder->owned[builder->owned_count] = *s;
+    dstr_init_with_allocator(s, allocator);
+
+    fragment = _dstr_builder_push(builder, _DSTR_BUILDER_OWNED, size);
+    fragment->index = builder->owned_count++;
+} // dstr_builder_append_dstr
+
+void dstr_builder_append_copy(dstr_builder* builder, const dstr_char_t* data, size_t size) {
+
+    _dstr_builder_fragment* last = builder->fragment_count ? &builder->fragments[builder->fragment_count - 1] : 0;
+
+    if (!size) {
+        return;
+    }
+
+    // Consecutive copies are stored in the same fragment.
+    if (last && last->kind == _DSTR_BUILDER_COPIED) {
+        last->size += size;
+        builder->size += size;
+    } else {
+        _dstr_builder_fragment* fragment = _dstr_builder_push(builder, _DSTR_BUILDER_COPIED, size);
+        fragment->index = dstr_size(&builder->copies);
+    }
+
+    dstr_append_range(&builder->copies, (dstr_it)data, (dstr_it)data + size);
+} // dstr_builder_append_copy
+
+size_t dstr_builder_size(const dstr_builder* builder) {
+    return builder->size;
+} // dstr_builder_size
+
+size_t dstr_builder_fragment_count(const dstr_builder* builder) {
+    return builder->fragment_count;
+} // dstr_builder_fragment_count
+
+const dstr_iovec* dstr_builder_iovecs(dstr_builder* builder, size_t* count) {
+
+    size_t i;
+
+    // Pointers are resolved here since owned and copied data can move while appending.
+    if (builder->iovec_capacity < builder->fragment_count) {
+
+        const dstr_allocator* allocator = builder->allocator;
+
+        if (builder->iovecs) {
+            allocator->free(allocator->user_data, builder->iovecs, builder->iovec_capacity * sizeof(dstr_iovec));
+        }
+
+        builder->iovec_capacity = builder->fragment_capacity;
+        builder->iovecs = (dstr_iovec*)allocator->alloc(allocator->user_data, builder->iovec_capacity * sizeof(dstr_iovec));
+        assert(builder->iovecs);
+    }
+
+    for (i = 0; i < builder->fragment_count; ++i) {
+        const _dstr_builder_fragment* fragment = &builder->fragments[i];
+        builder->iovecs[i].iov_base = (void*)_dstr_builder_fragment_data(builder, fragment);
+        builder->iovecs[i].iov_len = fragment->size;
+    }
+
+    *count = builder->fragment_count;
+
+    return builder->iovecs;
+} // dstr_builder_iovecs
+
+void dstr_builder_flatten(const dstr_builder* builder, dstr* s) {
+
+    size_t i;
+
+    dstr_assign_str(s, "");
+    dstr_reserve(s, builder->size + 1);
+
+    for (i = 0; i < builder->fragment_count; ++i) {
+        const _dstr_builder_fragment* fragment = &builder->fragments[i];
+        const dstr_char_t* data = _dstr_builder_fragment_data(builder, fragment);
+        dstr_append_range(s, (dstr_it)data, (dstr_it)data + fragment->size);
+    }
+} // dstr_builder_flatten
+
+void* _dstr_builder_grow(dstr_builder* builder, void* array, size_t* capacity, size_t count, size_t element_size) {
+
+    size_t new_capacity;
+    void* result;
+
+    if (count < *capacity) {
+        return array;
+    }
+
+    new_capacity = *capacity ? *capacity * 2 : 8;
+
+    if (array) {
+        result = builder->allocator->realloc(builder->allocator->user_data, array, *capacity * element_size, new_capacity * element_size);
+    } else {
+        result = builder->allocator->alloc(builder->allocator->user_data, new_capacity * element_size);
+    }
+    assert(result);
+
+    *capacity = new_capacity;
+
+    return result;
+} // _dstr_builder_grow
+
+_dstr_builder_fragment* _dstr_builder_push(dstr_builder* builder, _dstr_builder_kind kind, size_t size) {
+
+    _dstr_builder_fragment* fragment;
+
+    builder->fragments = (_dstr_builder_fragment*)_dstr_builder_grow(builder, builder->fragments, &builder->fragment_capacity, builder->fragment_count, sizeof(_dstr_builder_fragment));
+
+    fragment = &builder->fragments[builder->fragment_count++];
+    fragment->kind = kind;
+    fragment->data = 0;
+    fragment->index = 0;
+    fragment->size = size;
+
+    builder->size += size;
+
+    return fragment;
+} // _dstr_builder_push
+
+const dstr_char_t* _dstr_builder_fragment_data(const dstr_builder* builder, const _dstr_builder_fragment* fragment) {
+
+    switch (fragment->kind) {
+    case _DSTR_BUILDER_OWNED:
+        return dstr_data(&builder->owned[fragment->index]);
+    case _DSTR_BUILDER_COPIED:
+        return dstr_data(&builder->copies) + fragment->index;
+    default:
+        return fragment->data;
+    }
+} // _dstr_builder_fragment_data
+
+//-------------------------------------------------------------------------
+// dstr_builder - Implementation - END
+//-------------------------------------------------------------------------
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // RE_DSTR_BUILDER_H
@@ -0,0 +1,365 @@
+// dstr_cache.h - v0.1 - kevreco - CC0 1.0 Licence (public domain)
+// Thread-local cache of released dstr buffers
+// https://github.com/kevreco/re_lib
+
+/*
+
+NOTES:
+=====
+
+- Depends on dstr.h
+- dstr_cache_allocator is a dstr_allocator keeping released blocks in per-thread free lists,
+  the next allocation of the same size class reuses them instead of calling malloc.
+- Opt-in per thread: dstr_cache_enable makes it the thread allocator, existing call sites are unchanged.
+- Size classes are powers of two, from DSTR_CACHE_MIN_SIZE to DSTR_CACHE_MIN_SIZE << (DSTR_CACHE_CLASS_COUNT - 1) bytes.
+  Larger blocks are not cached.
+- Limits: a number of blocks per class and a number of bytes per thread (see dstr_cache_set_limits).
+  Blocks released above the limits go back to malloc.
+- A block released on a thread where the cache is not enabled goes back to malloc.
+- Cached blocks are not released when a thread exits, call dstr_cache_disable (or dstr_cache_release) before.
+- Statistics (hits, misses, cached bytes) can be retrieved with dstr_cache_get_stats.
+- Unit tests are made in ./testsuite/
+
+CHANGES (DD/MM/YYYY):
+====================
+
+- 16/10/2026 (0.1) - First implementation
+
+EXAMPLE:
+=======
+
+    // At the start of the thread
+    dstr_cache_enable();
+
+    for (;;) {
+        dstr tmp = dstr_make_from_str(...); // Buffer from the cache after the first iteration
+        ...
+        dstr_clear(&tmp);                  // Buffer back to the cache
+    }
+
+    // Before the end of the thread
+    dstr_cache_disable();
+
+*/
+
+#ifndef RE_DSTR_CACHE_H
+#define RE_DSTR_CACHE_H
+
+#include "dstr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size of the smallest class, at least the size of a pointer.
+#ifndef DSTR_CACHE_MIN_SIZE
+#define DSTR_CACHE_MIN_SIZE 32
+#endif
+
+// Number of size classes, the largest cached block is 1 MiB by default.
+#ifndef DSTR_CACHE_CLASS_COUNT
+#define DSTR_CACHE_CLASS_COUNT 16
+#endif
+
+// Default limits, per thread.
+#ifndef DSTR_CACHE_DEFAULT_CLASS_LIMIT
+#define DSTR_CACHE_DEFAULT_CLASS_LIMIT 64
+#endif
+
+#ifndef DSTR_CACHE_DEFAULT_THREAD_LIMIT
+#define DSTR_CACHE_DEFAULT_THREAD_LIMIT (4 * 1024 * 1024)
+#endif
+
+//-------------------------------------------------------------------------
+// dstr_cache - API - BEGIN
+//-------------------------------------------------------------------------
+
+typedef struct dstr_cache_stats {
+    size_t hits;          // Allocations served by the cache
+    size_t misses;        // Allocations forwarded to malloc (empty or no size class)
+    double hit_rate;      // hits / (hits + misses)
+    size_t cached_blocks; // Blocks waiting to be reused
+    size_t cached_bytes;  // Bytes of the cached blocks
+} dstr_cache_stats;
+
+// Allocator using the cache of the calling thread
+extern const dstr_allocator dstr_cache_allocator;
+
+// Uses dstr_cache_allocator as thread allocator (see dstr_set_thread_allocator).
+void dstr_cache_enable();
+// Restores the previous thread allocator and releases the cached blocks.
+void dstr_cache_disable();
+// Releases the cached blocks of the calling thread.
+void dstr_cache_release();
+
+// Limits of the calling thread, cached blocks above the new limits are released.
+void dstr_cache_set_limits(size_t max_blocks_per_class, size_t max_bytes);
+// Limit of the class containing blocks of 'size' bytes.
+void dstr_cache_set_class_limit(size_t size, size_t max_blocks);
+
+// Statistics of the calling thread
+void dstr_cache_get_stats(dstr_cache_stats* stats);
+void dstr_cache_reset_stats();
+
+//-------------------------------------------------------------------------
+// dstr_cache - API - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_cache - Private - BEGIN
+//-------------------------------------------------------------------------
+
+// Cached blocks are linked through their first bytes.
+typedef struct _dstr_cache_node {
+    struct _dstr_cache_node* next;
+} _dstr_cache_node;
+
+typedef struct _dstr_cache {
+    _dstr_cache_node* heads[DSTR_CACHE_CLASS_COUNT];
+    size_t counts[DSTR_CACHE_CLASS_COUNT];
+    size_t class_limits[DSTR_CACHE_CLASS_COUNT];
+    size_t max_bytes;
+    size_t cached_bytes;
+    size_t hits;
+    size_t misses;
+    int initialized;
+    const dstr_allocator* previous; // Thread allocator before dstr_cache_enable
+} _dstr_cache;
+
+// Cache of the calling thread, initialized with the default limits.
+_dstr_cache* _dstr_cache_get();
+// Index of the smallest class containing 'size' bytes, DSTR_CACHE_CLASS_COUNT if it's too large.
+size_t _dstr_cache_class(size_t size);
+// Releases cached blocks until the limits are respected.
+void   _dstr_cache_trim(_dstr_cache* cache);
+
+void*  _dstr_cache_alloc(void* user_data, size_t size);
+void*  _dstr_cache_realloc(void* user_data, void* ptr, size_t old_size, size_t new_size);
+void   _dstr_cache_free(void* user_data, void* ptr, size_t size);
+
+//-------------------------------------------------------------------------
+// dstr_cache - Private - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_cache - Implementation - BEGIN
+//-------------------------------------------------------------------------
+
+static DSTR_THREAD_LOCAL _dstr_cache _dstr_thread_cache;
+
+const dstr_allocator dstr_cache_allocator = {
+    _dstr_cache_alloc,
+    _dstr_cache_realloc,
+    _dstr_cache_free,
+    0
+};
+
+void dstr_cache_enable() {
+
+    _dstr_cache* cache = _dstr_cache_get();
+
+    if (dstr_get_thread_allocator() != &dstr_cache_allocator) {
+        cache->previous = dstr_get_thread_allocator();
+        dstr_set_thread_allocator(&dstr_cache_allocator);
+    }
+} // dstr_cache_enable
+
+void dstr_cache_disable() {
+
+    _dstr_cache* cache = _dstr_cache_get();
+
+    if (dstr_get_thread_allocator() == &dstr_cache_allocator) {
+        dstr_set_thread_allocator(cache->previous);
+    }
+    dstr_cache_release();
+} // dstr_cache_disable
+
+void dstr_cache_release() {
+
+    _dstr_cache* cache = _dstr_cache_get();
+    size_t i;
+
+    for (i = 0; i < DSTR_CACHE_CLASS_COUNT; ++i) {
+        while (cache->heads[i]) {
+            _dstr_cache_node* node = cache->heads[i];
+            cache->heads[i] = node->next;
+            free(node);
+        }
+        cache->counts[i] = 0;
+    }
+    cache->cached_bytes = 0;
+} // dstr_cache_release
+
+void dstr_cache_set_limits(size_t max_blocks_per_class, size_t max_bytes) {
+
+    _dstr_cache* cache = _dstr_cache_get();
+    size_t i;
+
+    for (i = 0; i < DSTR_CACHE_CLASS_COUNT; ++i) {
+        cache->class_limits[i] = max_blocks_per_class;
+    }
+    cache->max_bytes = max_bytes;
+
+    _dstr_cache_trim(cache);
+} // dstr_cache_set_limits
+
+void dstr_cache_set_class_limit(size_t size, size_t max_blocks) {
+
+    _dstr_cache* cache = _dstr_cache_get();
+    size_t index = _dstr_cache_class(size);
+
+    if (index < DSTR_CACHE_CLASS_COUNT) {
+        cache->class_limits[index] = max_blocks;
+        _dstr_cache_trim(cache);
+    }
+} // dstr_cache_set_class_limit
+
+void dstr_cache_get_stats(dstr_cache_stats* stats) {
+
+    _dstr_cache* cache = _dstr_cache_get();
+    size_t lookups = cache->hits + cache->misses;
+    size_t i;
+
+    stats->hits = cache->hits;
+    stats->misses = cache->misses;
+    stats->hit_rate = lookups ? (double)cache->hits / (double)lookups : 0.0;
+    stats->cached_blocks = 0;
+    for (i = 0; i < DSTR_CACHE_CLASS_COUNT; ++i) {
+        stats->cached_blocks += cache->counts[i];
+    }
+    stats->cached_bytes = cache->cached_bytes;
+} // dstr_cache_get_stats
+
+void dstr_cache_reset_stats() {
+
+    _dstr_cache* cache = _dstr_cache_get();
+
+    cache->hits = 0;
+    cache->misses = 0;
+} // dstr_cache_reset_stats
+
+_dstr_cache* _dstr_cache_get() {
+
+    _dstr_cache* cache = &_dstr_thread_cache;
+
+    if (!cache->initialized) {
+        size_t i;
+
+        for (i = 0; i < DSTR_CACHE_CLASS_COUNT; ++i) {
+            cache->class_limits[i] = DSTR_CACHE_DEFAULT_CLASS_LIMIT;
+        }
+        cache->max_bytes = DSTR_CACHE_DEFAULT_THREAD_LIMIT;
+        cache->initialized = 1;
+    }
+
+    return cache;
+} // _dstr_cache_get
+
+inline size_t _dstr_cache_class(size_t size) {
+
+    size_t index = 0;
+    size_t class_size = DSTR_CACHE_MIN_SIZE;
+
+    while (class_size < size && index < DSTR_CACHE_CLASS_COUNT) {
+        class_size <<= 1;
+        ++index;
+    }
+
+    return index;
+} // _dstr_cache_class
+
+void _dstr_cache_trim(_dstr_cache* cache) {
+
+    size_t i = DSTR_CACHE_CLASS_COUNT;
+
+    // Largest blocks first, they are the most expensive to keep.
+    while (i--) {
+        while (cache->heads[i]
+               && (cache->counts[i] > cache->class_limits[i] || cache->cached_bytes > cache->max_bytes)) {
+            _dstr_cache_node* node = cache->heads[i];
+            cache->heads[i] = node->next;
+            --cache->counts[i];
+            cache->cached_bytes -= (size_t)DSTR_CACHE_MIN_SIZE << i;
+            free(node);
+        }
+    }
+} // _dstr_cache_trim
+
+void* _dstr_cache_alloc(void* user_data, size_t size) {
+
+    _dstr_cache* cache = _dstr_cache_get();
+    size_t index = _dstr_cache_class(size);
+    (void)user_data;
+
+    if (index == DSTR_CACHE_CLASS_COUNT) {
+        ++cache->misses;
+        return malloc(size);
+    }
+
+    if (cache->heads[index]) {
+        _dstr_cache_node* node = cache->heads[index];
+        cache->heads[index] = node->next;
+        --cache->counts[index];
+        cache->cached_bytes -= (size_t)DSTR_CACHE_MIN_SIZE << index;
+        ++cache->hits;
+        return node;
+    }
+
+    ++cache->misses;
+    return malloc((size_t)DSTR_CACHE_MIN_SIZE << index);
+} // _dstr_cache_alloc
+
+void* _dstr_cache_realloc(void* user_data, void* ptr, size_t old_size, size_t new_size) {
+
+    size_t old_index = _dstr_cache_class(old_size);
+    size_t new_index = _dstr_cache_class(new_size);
+    void* result;
+
+    // Same class, the block is already large enough.
+    if (old_index == new_index && old_index != DSTR_CACHE_CLASS_COUNT) {
+        return ptr;
+    }
+
+    if (old_index == DSTR_CACHE_CLASS_COUNT && new_index == DSTR_CACHE_CLASS_COUNT) {
+        return realloc(ptr, new_size);
+    }
+
+    result = _dstr_cache_alloc(user_data, new_size);
+    if (result) {
+        memcpy(result, ptr, old_size < new_size ? old_size : new_size);
+        _dstr_cache_free(user_data, ptr, old_size);
+    }
+
+    return result;
+} // _dstr_cache_realloc
+
+void _dstr_cache_free(void* user_data, void* ptr, size_t size) {
+
+    _dstr_cache* cache = &_dstr_thread_cache;
+    size_t index = _dstr_cache_class(size);
+    size_t class_size = (size_t)DSTR_CACHE_MIN_SIZE << index;
+    (void)user_data;
+
+    if (index == DSTR_CACHE_CLASS_COUNT
+        || dstr_get_thread_allocator() != &dstr_cache_allocator
+        || cache->counts[index] >= cache->class_limits[index]
+        || cache->cached_bytes + class_size > cache->max_bytes) {
+        free(ptr);
+        return;
+    }
+
+    ((_dstr_cache_node*)ptr)->next = cache->heads[index];
+    cache->heads[index] = (_dstr_cache_node*)ptr;
+    ++cache->counts[index];
+    cache->cached_bytes += class_size;
+} // _dstr_cache_free
+
+//-------------------------------------------------------------------------
+// dstr_cache - Implementation - END
+//-------------------------------------------------------------------------
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // RE_DSTR_CACHE_H
@@ -0,0 +1,278 @@
+// dstr_file.h - v0.1 - kevreco - CC0 1.0 Licence (public domain)
+// Read-only memory-mapped files as dstr views
+// https://github.com/kevreco/re_lib
+
+/*
+
+NOTES:
+=====
+
+- Depends on dstr.h
+- dstr_map_file maps a whole file read-only (mmap), pages are loaded by the OS when they are read:
+  nothing is copied, opening a file does not depend on its size.
+- The content is '\0' terminated, even when the file size is a multiple of the page size
+  (an extra zero page is mapped after the file).
+- Hints (DSTR_FILE_SEQUENTIAL, DSTR_FILE_WILLNEED, DSTR_FILE_RANDOM) are given to madvise.
+- The content must not be modified: the dstr returned by dstr_mapped_file_ref is read-only, like dstr_make_ref.
+- Views and refs are invalidated by dstr_unmap_file.
+- Without mmap (or with DSTR_FILE_NO_MMAP) the file is read in a buffer allocated with the thread allocator.
+- Unit tests are made in ./testsuite/
+
+CHANGES (DD/MM/YYYY):
+====================
+
+- 16/10/2026 (0.1) - First implementation
+
+EXAMPLE:
+=======
+
+    dstr_mapped_file file;
+
+    if (dstr_map_file(&file, "corpus.txt", DSTR_FILE_SEQUENTIAL)) {
+
+        dstr_view content = dstr_mapped_file_view(&file);
+        ...
+        dstr_unmap_file(&file);
+    }
+
+*/
+
+#ifndef RE_DSTR_FILE_H
+#define RE_DSTR_FILE_H
+
+#include "dstr.h"
+
+#if !defined(DSTR_FILE_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#include <sys/mman.h> // mmap, munmap, madvise
+// MAP_ANONYMOUS and madvise are missing in strict modes (-std=c99 without _DEFAULT_SOURCE), the file is read instead.
+#ifdef MAP_ANONYMOUS
+#define DSTR_FILE_MMAP
+#include <sys/stat.h> // fstat
+#include <fcntl.h>    // open
+#include <unistd.h>   // close, sysconf
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//-------------------------------------------------------------------------
+// dstr_file - API - BEGIN
+//-------------------------------------------------------------------------
+
+// Access pattern hints, they can be combined.
+enum {
+    DSTR_FILE_SEQUENTIAL = 1, // Read ahead aggressively, pages can be dropped once read
+    DSTR_FILE_WILLNEED   = 2, // Start loading the whole file now
+    DSTR_FILE_RANDOM     = 4  // Don't read ahead
+};
+
+typedef struct dstr_mapped_file {
+    const dstr_char_t* data;  // '\0' terminated
+    size_t size;
+    void* address;            // Start of the mapping (or buffer), 0 for an empty file
+    size_t mapped_size;       // Size of the mapping (or buffer)
+    const dstr_allocator* allocator; // Allocator of the buffer, 0 for a mapping
+} dstr_mapped_file;
+
+// Returns 0 if the file can't be opened or mapped, 'file' is then empty.
+int  dstr_map_file(dstr_mapped_file* file, const char* filename, int hints);
+void dstr_unmap_file(dstr_mapped_file* file);
+
+dstr_view dstr_mapped_file_view(const dstr_mapped_file* file);
+// Read-only dstr (like dstr_ref, it must not be modified), no need to call dstr_clear.
+dstr      dstr_mapped_file_ref(const dstr_mapped_file* file);
+
+//-------------------------------------------------------------------------
+// dstr_file - API - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_file - Private - BEGIN
+//-------------------------------------------------------------------------
+
+void _dstr_mapped_file_init(dstr_mapped_file* file);
+#ifdef DSTR_FILE_MMAP
+int  _dstr_map_file_mmap(dstr_mapped_file* file, const char* filename, int hints);
+#else
+int  _dstr_map_file_read(dstr_mapped_file* file, const char* filename);
+#endif
+
+//-------------------------------------------------------------------------
+// dstr_file - Private - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_file - Implementation - BEGIN
+//-------------------------------------------------------------------------
+
+int dstr_map_file(dstr_mapped_file* file, const char* filename, int hints) {
+
+    _dstr_mapped_file_init(file);
+
+#ifdef DSTR_FILE_MMAP
+    return _dstr_map_file_mmap(file, filename, hints);
+#else
+    (void)hints;
+    return _dstr_map_file_read(file, filename);
+#endif
+} // dstr_map_file
+
+void dstr_unmap_file(dstr_mapped_file* file) {
+
+    if (file->address) {
+        if (file->allocator) {
+            file->allocator->free(file->allocator->user_data, file->address, file->mapped_size);
+        } else {
+#ifdef DSTR_FILE_MMAP
+            munmap(file->address, file->mapped_size);
+#endif
+        }
+    }
+
+    _dstr_mapped_file_init(file);
+} // dstr_unmap_file
+
+inline dstr_view dstr_mapped_file_view(const dstr_mapped_file* file) {
+    return dstr_view_make(file->data, file->size);
+} // dstr_mapped_file_view
+
+inline dstr dstr_mapped_file_ref(const dstr_mapped_file* file) {
+    dstr result;
+
+    _dstr_set_large(&result, (dstr_char_t*)file->data, file->size, file->size + 1, _DSTR_EXTERNAL);
+
+    return result;
+} // dstr_mapped_file_ref
+
+inline void _dstr_mapped_file_init(dstr_mapped_file* file) {
+
+    file->data = "";
+    file->size = 0;
+    file->address = 0;
+    file->mapped_size = 0;
+    file->allocator = 0;
+} // _dstr_mapped_file_init
+
+#ifdef DSTR_FILE_MMAP
+
+int _dstr_map_file_mmap(dstr_mapped_file* file, const char* filename, int hints) {
+
+    struct stat st;
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t size;
+    size_t mapped_size;
+    void* address;
+    int fd = open(filename, O_RDONLY);
+
+    if (fd < 0) {
+        return 0;
+    }
+
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return 0;
+    }
+
+    size = (size_t)st.st_size;
+    if (!size) {
+        close(fd);
+        return 1;
+    }
+
+    // The end of the last page is filled with zeros. If there is none, an anonymous zero page is added.
+    mapped_size = (size + page_size - 1) & ~(page_size - 1);
+
+    if (mapped_size == size) {
+        mapped_size += page_size;
+
+        address = mmap(0, mapped_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (address != MAP_FAILED
+            && mmap(address, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(address, mapped_size);
+            address = MAP_FAILED;
+        }
+    } else {
+        address = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    // The mapping stays valid once the file is closed.
+    close(fd);
+
+    if (address == MAP_FAILED) {
+        return 0;
+    }
+
+    if (hints & DSTR_FILE_SEQUENTIAL) {
+        madvise(address, size, MADV_SEQUENTIAL);
+    }
+    if (hints & DSTR_FILE_RANDOM) {
+        madvise(address, size, MADV_RANDOM);
+    }
+    if (hints & DSTR_FILE_WILLNEED) {
+        madvise(address, size, MADV_WILLNEED);
+    }
+
+    file->data = (const dstr_char_t*)address;
+    file->size = size;
+    file->address = address;
+    file->mapped_size = mapped_size;
+
+    return 1;
+} // _dstr_map_file_mmap
+
+#else
+
+int _dstr_map_file_read(dstr_mapped_file* file, const char* filename) {
+
+    const dstr_allocator* allocator = dstr_get_thread_allocator();
+    FILE* f = fopen(filename, "rb");
+    dstr_char_t* buffer;
+    long size;
+
+    if (!f) {
+        return 0;
+    }
+
+    if (fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0) {
+        fclose(f);
+        return 0;
+    }
+
+    if (!size) {
+        fclose(f);
+        return 1;
+    }
+
+    buffer = (dstr_char_t*)allocator->alloc(allocator->user_data, (size_t)size + 1); // +1 for '\0'
+    if (!buffer || fread(buffer, 1, (size_t)size, f) != (size_t)size) {
+        if (buffer) {
+            allocator->free(allocator->user_data, buffer, (size_t)size + 1);
+        }
+        fclose(f);
+        return 0;
+    }
+    buffer[size] = '\0';
+    fclose(f);
+
+    file->data = buffer;
+    file->size = (size_t)size;
+    file->address = buffer;
+    file->mapped_size = (size_t)size + 1;
+    file->allocator = allocator;
+
+    return 1;
+} // _dstr_map_file_read
+
+#endif
+
+//-------------------------------------------------------------------------
+// dstr_file - Implementation - END
+//-------------------------------------------------------------------------
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // RE_DSTR_FILE_H
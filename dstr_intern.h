@@ -0,0 +1,343 @@
+// dstr_intern.h - v0.1 - kevreco - CC0 1.0 Licence (public domain)
+// String interning table for dstr
+// https://github.com/kevreco/re_lib
+
+/*
+
+NOTES:
+=====
+
+- Depends on dstr.h and dstr_hash.h
+- Each distinct content is stored once, in an arena, and is never moved or released
+  before dstr_intern_clear: returned pointers are stable.
+- Interned strings are '\0' terminated, their size is stored before the first char (see dstr_interned_size).
+- Two strings interned in the same table are equal if and only if their pointers are equal.
+- Lookup is an open addressing hash table (linear probing), hashes are stored to avoid most comparisons.
+- Statistics (hit rate, memory saved) can be retrieved with dstr_intern_get_stats.
+- Not thread-safe.
+- Memory comes from the thread allocator at initialization time.
+- Unit tests are made in ./testsuite/
+
+CHANGES (DD/MM/YYYY):
+====================
+
+- 16/10/2026 (0.1) - First implementation
+
+EXAMPLE:
+=======
+
+    dstr_intern table;
+    const char* a;
+    const char* b;
+
+    dstr_intern_init(&table);
+
+    a = dstr_intern_str(&table, "Content-Type");
+    b = dstr_intern_dstr(&table, &header_name);
+
+    if (a == b) {
+        ...
+    }
+
+    dstr_intern_clear(&table);
+
+*/
+
+#ifndef RE_DSTR_INTERN_H
+#define RE_DSTR_INTERN_H
+
+#include "dstr.h"
+#include "dstr_hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DSTR_INTERN_BLOCK_SIZE
+#define DSTR_INTERN_BLOCK_SIZE (64 * 1024)
+#endif
+
+//-------------------------------------------------------------------------
+// dstr_intern - API - BEGIN
+//-------------------------------------------------------------------------
+
+typedef struct _dstr_intern_block {
+    struct _dstr_intern_block* next;
+    size_t capacity;
+    size_t used;
+} _dstr_intern_block;
+
+typedef struct _dstr_intern_slot {
+    size_t hash;
+    const dstr_char_t* str; // 0 if the slot is empty
+} _dstr_intern_slot;
+
+typedef struct dstr_intern {
+    const dstr_allocator* allocator;
+    _dstr_intern_slot* slots;
+    size_t slot_count;          // Power of two
+    size_t count;               // Distinct strings
+    _dstr_intern_block* blocks; // Current block first
+    size_t block_bytes;         // Memory allocated for blocks
+    size_t string_bytes;        // Bytes used by distinct strings, including '\0'
+    size_t lookups;
+    size_t hits;
+    size_t saved_bytes;         // Bytes of the hits, including '\0'
+} dstr_intern;
+
+typedef struct dstr_intern_stats {
+    size_t count;          // Distinct strings
+    size_t lookups;        // Calls to the intern functions
+    size_t hits;           // Calls which found an existing string
+    double hit_rate;       // hits / lookups
+    size_t string_bytes;   // Bytes used by distinct strings, including '\0'
+    size_t memory_bytes;   // Memory allocated by the table (arena and slots)
+    size_t saved_bytes;    // Bytes that would have been allocated for duplicates
+} dstr_intern_stats;
+
+void   dstr_intern_init(dstr_intern* table);
+// Releases all interned strings.
+void   dstr_intern_clear(dstr_intern* table);
+
+// Returns the canonical copy, it's created if the content was not interned yet.
+const dstr_char_t* dstr_intern_range(dstr_intern* table, const dstr_it first, const dstr_it last);
+const dstr_char_t* dstr_intern_str(dstr_intern* table, const dstr_char_t* str);
+const dstr_char_t* dstr_intern_dstr(dstr_intern* table, const dstr* s);
+
+// Returns the canonical copy or 0 if the content was not interned.
+const dstr_char_t* dstr_intern_find_range(const dstr_intern* table, const dstr_it first, const dstr_it last);
+
+size_t dstr_intern_count(const dstr_intern* table);
+void   dstr_intern_get_stats(const dstr_intern* table, dstr_intern_stats* stats);
+
+// Size of an interned string, without '\0'.
+size_t dstr_interned_size(const dstr_char_t* interned);
+
+//-------------------------------------------------------------------------
+// dstr_intern - API - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_intern - Private - BEGIN
+//-------------------------------------------------------------------------
+
+size_t _dstr_intern_hash(const dstr_char_t* data, size_t size);
+const _dstr_intern_slot* _dstr_intern_probe(const dstr_intern* table, const dstr_char_t* data, size_t size, size_t hash);
+const dstr_char_t* _dstr_intern_store(dstr_intern* table, const dstr_char_t* data, size_t size);
+void   _dstr_intern_grow(dstr_intern* table);
+
+//-------------------------------------------------------------------------
+// dstr_intern - Private - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_intern - Implementation - BEGIN
+//-------------------------------------------------------------------------
+
+void dstr_intern_init(dstr_intern* table) {
+
+    table->allocator = dstr_get_thread_allocator();
+    table->slots = 0;
+    table->slot_count = 0;
+    table->count = 0;
+    table->blocks = 0;
+    table->block_bytes = 0;
+    table->string_bytes = 0;
+    table->lookups = 0;
+    table->hits = 0;
+    table->saved_bytes = 0;
+} // dstr_intern_init
+
+void dstr_intern_clear(dstr_intern* table) {
+
+    const dstr_allocator* allocator = table->allocator;
+    _dstr_intern_block* block = table->blocks;
+
+    while (block) {
+        _dstr_intern_block* next = block->next;
+        allocator->free(allocator->user_data, block, sizeof(_dstr_intern_block) + block->capacity);
+        block = next;
+    }
+
+    if (table->slots) {
+        allocator->free(allocator->user_data, table->slots, table->slot_count * sizeof(_dstr_intern_slot));
+    }
+
+    dstr_intern_init(table);
+    table->allocator = allocator;
+} // dstr_intern_clear
+
+const dstr_char_t* dstr_intern_range(dstr_intern* table, const dstr_it first, const dstr_it last) {
+
+    size_t size = (size_t)(last - first);
+    size_t hash = _dstr_intern_hash(first, size);
+    _dstr_intern_slot* slot;
+
+    ++table->lookups;
+
+    // Load factor is kept under 3/4
+    if ((table->count + 1) * 4 > table->slot_count * 3) {
+        _dstr_intern_grow(table);
+    }
+
+    slot = (_dstr_intern_slot*)_dstr_intern_probe(table, first, size, hash);
+
+    if (slot->str) {
+        ++table->hits;
+        table->saved_bytes += size + 1;
+        return slot->str;
+    }
+
+    slot->hash = hash;
+    slot->str = _dstr_intern_store(table, first, size);
+    ++table->count;
+
+    return slot->str;
+} // dstr_intern_range
+
+const dstr_char_t* dstr_intern_str(dstr_intern* table, const dstr_char_t* str) {
+    return dstr_intern_range(table, (dstr_it)str, (dstr_it)str + strlen(str));
+} // dstr_intern_str
+
+const dstr_char_t* dstr_intern_dstr(dstr_intern* table, const dstr* s) {
+    return dstr_intern_range(table, dstr_begin(s), dstr_end(s));
+} // dstr_intern_dstr
+
+const dstr_char_t* dstr_intern_find_range(const dstr_intern* table, const dstr_it first, const dstr_it last) {
+
+    size_t size = (size_t)(last - first);
+
+    if (!table->slot_count) {
+        return 0;
+    }
+
+    return _dstr_intern_probe(table, first, size, _dstr_intern_hash(first, size))->str;
+} // dstr_intern_find_range
+
+size_t dstr_intern_count(const dstr_intern* table) {
+    return table->count;
+} // dstr_intern_count
+
+void dstr_intern_get_stats(const dstr_intern* table, dstr_intern_stats* stats) {
+
+    stats->count = table->count;
+    stats->lookups = table->lookups;
+    stats->hits = table->hits;
+    stats->hit_rate = table->lookups ? (double)table->hits / (double)table->lookups : 0.0;
+    stats->string_bytes = table->string_bytes;
+    stats->memory_bytes = table->block_bytes + table->slot_count * sizeof(_dstr_intern_slot);
+    stats->saved_bytes = table->saved_bytes;
+} // dstr_intern_get_stats
+
+size_t dstr_interned_size(const dstr_char_t* interned) {
+
+    size_t size;
+    memcpy(&size, interned - sizeof(size_t), sizeof(size_t));
+
+    return size;
+} // dstr_interned_size
+
+size_t _dstr_intern_hash(const dstr_char_t* data, size_t size) {
+    return (size_t)dstr_hash_bytes(data, size, 0);
+} // _dstr_intern_hash
+
+// Returns the slot of the string, or the empty slot where it should be inserted.
+const _dstr_intern_slot* _dstr_intern_probe(const dstr_intern* table, const dstr_char_t* data, size_t size, size_t hash) {
+
+    size_t mask = table->slot_count - 1;
+    size_t index = hash & mask;
+
+    for (;;) {
+        const _dstr_intern_slot* slot = &table->slots[index];
+
+        if (!slot->str) {
+            return slot;
+        }
+
+        if (slot->hash == hash
+            && dstr_interned_size(slot->str) == size
+            && memcmp(slot->str, data, size) == 0) {
+            return slot;
+        }
+
+        index = (index + 1) & mask;
+    }
+} // _dstr_intern_probe
+
+const dstr_char_t* _dstr_intern_store(dstr_intern* table, const dstr_char_t* data, size_t size) {
+
+    // [size][chars]['\0'], entries are aligned on size_t
+    size_t entry_size = (sizeof(size_t) + size + 1 + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+    _dstr_intern_block* block = table->blocks;
+    dstr_char_t* entry;
+
+    if (!block || block->capacity - block->used < entry_size) {
+
+        size_t capacity = entry_size > DSTR_INTERN_BLOCK_SIZE ? entry_size : DSTR_INTERN_BLOCK_SIZE;
+        _dstr_intern_block* new_block = (_dstr_intern_block*)table->allocator->alloc(table->allocator->user_data, sizeof(_dstr_intern_block) + capacity);
+        assert(new_block);
+
+        new_block->capacity = capacity;
+        new_block->used = 0;
+
+        // A large string gets its own block, the current block stays the current one.
+        if (block && capacity > DSTR_INTERN_BLOCK_SIZE) {
+            new_block->next = block->next;
+            block->next = new_block;
+        } else {
+            new_block->next = block;
+            table->blocks = new_block;
+        }
+
+        table->block_bytes += sizeof(_dstr_intern_block) + capacity;
+        block = new_block;
+    }
+
+    entry = (dstr_char_t*)(block + 1) + block->used;
+    block->used += entry_size;
+
+    memcpy(entry, &size, sizeof(size_t));
+    entry += sizeof(size_t);
+    memcpy(entry, data, size);
+    entry[size] = '\0';
+
+    table->string_bytes += size + 1;
+
+    return entry;
+} // _dstr_intern_store
+
+void _dstr_intern_grow(dstr_intern* table) {
+
+    _dstr_intern_slot* old_slots = table->slots;
+    size_t old_count = table->slot_count;
+    size_t i;
+
+    table->slot_count = old_count ? old_count * 2 : 64;
+    table->slots = (_dstr_intern_slot*)table->allocator->alloc(table->allocator->user_data, table->slot_count * sizeof(_dstr_intern_slot));
+    assert(table->slots);
+    memset(table->slots, 0, table->slot_count * sizeof(_dstr_intern_slot));
+
+    for (i = 0; i < old_count; ++i) {
+        if (old_slots[i].str) {
+            size_t index = old_slots[i].hash & (table->slot_count - 1);
+            while (table->slots[index].str) {
+                index = (index + 1) & (table->slot_count - 1);
+            }
+            table->slots[index] = old_slots[i];
+        }
+    }
+
+    if (old_slots) {
+        table->allocator->free(table->allocator->user_data, old_slots, old_count * sizeof(_dstr_intern_slot));
+    }
+} // _dstr_intern_grow
+
+//-------------------------------------------------------------------------
+// dstr_intern - Implementation - END
+//-------------------------------------------------------------------------
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // RE_DSTR_INTERN_H
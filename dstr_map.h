@@ -0,0 +1,448 @@
+// dstr_map.h - v0.1 - kevreco - CC0 1.0 Licence (public domain)
+// Hash map with dstr keys (SwissTable-like open addressing)
+// https://github.com/kevreco/re_lib
+
+/*
+
+NOTES:
+=====
+
+- Depends on dstr.h and dstr_hash.h
+- Keys are copied in dstr (short keys are stored inline thanks to SSO), values are void*.
+- Slots are split in groups of 16, each slot has a control byte:
+   - empty, deleted, or the 7 low bits of the hash for used slots.
+   - A group is probed with one SSE2 comparison (16 control bytes at once), with a scalar fallback.
+   - Keys are compared only when the control byte and the stored 64-bit hash match.
+- Groups are probed with triangular steps, the load factor is kept under 7/8.
+- Lookup takes a pointer and a size, no temporary dstr is needed (see dstr_map_find_str, dstr_map_find_dstr).
+- Pointers to values and entries are invalidated by insertions (rehash) and erase.
+- Memory comes from the thread allocator at initialization time.
+- Unit tests are made in ./testsuite/
+
+CHANGES (DD/MM/YYYY):
+====================
+
+- 16/10/2026 (0.1) - First implementation
+
+EXAMPLE:
+=======
+
+    dstr_map map;
+    void** value;
+    dstr_map_entry* entry;
+
+    dstr_map_init(&map);
+    dstr_map_reserve(&map, 100);
+
+    dstr_map_set_str(&map, "/index", &index_handler);
+
+    value = dstr_map_find(&map, path, path_size);
+    if (value) {
+        ...
+    }
+
+    for (entry = dstr_map_first(&map); entry; entry = dstr_map_next(&map, entry)) {
+        ...
+    }
+
+    dstr_map_clear(&map);
+
+*/
+
+#ifndef RE_DSTR_MAP_H
+#define RE_DSTR_MAP_H
+
+#include "dstr.h"
+#include "dstr_hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DSTR_MAP_GROUP_SIZE 16
+
+//-------------------------------------------------------------------------
+// dstr_map - API - BEGIN
+//-------------------------------------------------------------------------
+
+typedef struct dstr_map_entry {
+    uint64_t hash;
+    dstr key;
+    void* value;
+} dstr_map_entry;
+
+typedef struct dstr_map {
+    const dstr_allocator* allocator;
+    unsigned char* controls;  // One control byte per slot
+    dstr_map_entry* entries;
+    size_t capacity;          // 0 or a power of two, at least DSTR_MAP_GROUP_SIZE
+    size_t size;              // Used slots
+    size_t deleted;           // Deleted slots, they still count in the load factor
+} dstr_map;
+
+void   dstr_map_init(dstr_map* map);
+// Releases all keys and memory.
+void   dstr_map_clear(dstr_map* map);
+// Allocates enough slots for 'count' keys, no rehash happens until then.
+void   dstr_map_reserve(dstr_map* map, size_t count);
+
+size_t dstr_map_size(const dstr_map* map);
+int    dstr_map_empty(const dstr_map* map);
+
+// Returns 1 if the key was inserted, 0 if the value of an existing key was replaced.
+int    dstr_map_set(dstr_map* map, const dstr_char_t* key, size_t size, void* value);
+int    dstr_map_set_str(dstr_map* map, const dstr_char_t* key, void* value);
+int    dstr_map_set_dstr(dstr_map* map, const dstr* key, void* value);
+
+// Returns a pointer to the value, or 0 if the key is not found.
+void** dstr_map_find(const dstr_map* map, const dstr_char_t* key, size_t size);
+void** dstr_map_find_str(const dstr_map* map, const dstr_char_t* key);
+void** dstr_map_find_dstr(const dstr_map* map, const dstr* key);
+
+// Returns 1 if the key was removed.
+int    dstr_map_erase(dstr_map* map, const dstr_char_t* key, size_t size);
+int    dstr_map_erase_str(dstr_map* map, const dstr_char_t* key);
+int    dstr_map_erase_dstr(dstr_map* map, const dstr* key);
+
+// Iterates over entries in unspecified order, 0 at the end.
+dstr_map_entry* dstr_map_first(const dstr_map* map);
+dstr_map_entry* dstr_map_next(const dstr_map* map, const dstr_map_entry* entry);
+
+//-------------------------------------------------------------------------
+// dstr_map - API - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_map - Private - BEGIN
+//-------------------------------------------------------------------------
+
+#define _DSTR_MAP_EMPTY   ((unsigned char)0x80)
+#define _DSTR_MAP_DELETED ((unsigned char)0xFE)
+// Used slots have the high bit cleared.
+#define _DSTR_MAP_IS_FREE(control) ((control) & 0x80)
+
+// Bit 'i' of the result is set if control byte 'i' of the group is 'value'.
+unsigned int _dstr_map_match(const unsigned char* group, unsigned char value);
+// Bit 'i' of the result is set if slot 'i' of the group is empty or deleted.
+unsigned int _dstr_map_match_free(const unsigned char* group);
+unsigned int _dstr_map_first_bit(unsigned int mask);
+size_t _dstr_map_find_index(const dstr_map* map, const dstr_char_t* key, size_t size, uint64_t hash);
+size_t _dstr_map_find_free_index(const dstr_map* map, uint64_t hash);
+size_t _dstr_map_capacity_for(size_t count);
+void   _dstr_map_rehash(dstr_map* map, size_t capacity);
+
+//-------------------------------------------------------------------------
+// dstr_map - Private - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_map - Implementation - BEGIN
+//-------------------------------------------------------------------------
+
+void dstr_map_init(dstr_map* map) {
+
+    map->allocator = dstr_get_thread_allocator();
+    map->controls = 0;
+    map->entries = 0;
+    map->capacity = 0;
+    map->size = 0;
+    map->deleted = 0;
+} // dstr_map_init
+
+void dstr_map_clear(dstr_map* map) {
+
+    const dstr_allocator* allocator = map->allocator;
+    size_t i;
+
+    for (i = 0; i < map->capacity; ++i) {
+        if (!_DSTR_MAP_IS_FREE(map->controls[i])) {
+            dstr_clear(&map->entries[i].key);
+        }
+    }
+
+    if (map->capacity) {
+        allocator->free(allocator->user_data, map->controls, map->capacity);
+        allocator->free(allocator->user_data, map->entries, map->capacity * sizeof(dstr_map_entry));
+    }
+
+    dstr_map_init(map);
+    map->allocator = allocator;
+} // dstr_map_clear
+
+void dstr_map_reserve(dstr_map* map, size_t count) {
+
+    size_t capacity = _dstr_map_capacity_for(count);
+
+    if (capacity > map->capacity) {
+        _dstr_map_rehash(map, capacity);
+    }
+} // dstr_map_reserve
+
+size_t dstr_map_size(const dstr_map* map) {
+    return map->size;
+} // dstr_map_size
+
+int dstr_map_empty(const dstr_map* map) {
+    return !map->size;
+} // dstr_map_empty
+
+int dstr_map_set(dstr_map* map, const dstr_char_t* key, size_t size, void* value) {
+
+    uint64_t hash = dstr_hash_bytes(key, size, 0);
+    size_t index = _dstr_map_find_index(map, key, size, hash);
+    dstr_map_entry* entry;
+
+    if (index != DSTR_NPOS) {
+        map->entries[index].value = value;
+        return 0;
+    }
+
+    // Grow, or only remove deleted slots if there are many of them.
+    if ((map->size + map->deleted + 1) * 8 > map->capacity * 7) {
+        _dstr_map_rehash(map, _dstr_map_capacity_for((map->size + 1) * 2));
+    }
+
+    index = _dstr_map_find_free_index(map, hash);
+
+    if (map->controls[index] == _DSTR_MAP_DELETED) {
+        --map->deleted;
+    }
+
+    map->controls[index] = (unsigned char)(hash & 0x7F);
+    ++map->size;
+
+    entry = &map->entries[index];
+    entry->hash = hash;
+    entry->value = value;
+    dstr_init_with_allocator(&entry->key, map->allocator);
+    dstr_assign_range(&entry->key, (dstr_it)key, (dstr_it)key + size);
+
+    return 1;
+} // dstr_map_set
+
+int dstr_map_set_str(dstr_map* map, const dstr_char_t* key, void* value) {
+    return dstr_map_set(map, key, strlen(key), value);
+} // dstr_map_set_str
+
+int dstr_map_set_dstr(dstr_map* map, const dstr* key, void* value) {
+    return dstr_map_set(map, dstr_data(key), dstr_size(key), value);
+} // dstr_map_set_dstr
+
+void** dstr_map_find(const dstr_map* map, const dstr_char_t* key, size_t size) {
+
+    size_t index = _dstr_map_find_index(map, key, size, dstr_hash_bytes(key, size, 0));
+
+    return index != DSTR_NPOS ? &map->entries[index].value : 0;
+} // dstr_map_find
+
+void** dstr_map_find_str(const dstr_map* map, const dstr_char_t* key) {
+    return dstr_map_find(map, key, strlen(key));
+} // dstr_map_find_str
+
+void** dstr_map_find_dstr(const dstr_map* map, const dstr* key) {
+    return dstr_map_find(map, dstr_data(key), dstr_size(key));
+} // dstr_map_find_dstr
+
+int dstr_map_erase(dstr_map* map, const dstr_char_t* key, size_t size) {
+
+    size_t index = _dstr_map_find_index(map, key, size, dstr_hash_bytes(key, size, 0));
+
+    if (index == DSTR_NPOS) {
+        return 0;
+    }
+
+    dstr_clear(&map->entries[index].key);
+    map->controls[index] = _DSTR_MAP_DELETED;
+    --map->size;
+    ++map->deleted;
+
+    return 1;
+} // dstr_map_erase
+
+int dstr_map_erase_str(dstr_map* map, const dstr_char_t* key) {
+    return dstr_map_erase(map, key, strlen(key));
+} // dstr_map_erase_str
+
+int dstr_map_erase_dstr(dstr_map* map, const dstr* key) {
+    return dstr_map_erase(map, dstr_data(key), dstr_size(key));
+} // dstr_map_erase_dstr
+
+dstr_map_entry* dstr_map_first(const dstr_map* map) {
+
+    size_t i;
+
+    for (i = 0; i < map->capacity; ++i) {
+        if (!_DSTR_MAP_IS_FREE(map->controls[i])) {
+            return &map->entries[i];
+        }
+    }
+
+    return 0;
+} // dstr_map_first
+
+dstr_map_entry* dstr_map_next(const dstr_map* map, const dstr_map_entry* entry) {
+
+    size_t i;
+
+    for (i = (size_t)(entry - map->entries) + 1; i < map->capacity; ++i) {
+        if (!_DSTR_MAP_IS_FREE(map->controls[i])) {
+            return &map->entries[i];
+        }
+    }
+
+    return 0;
+} // dstr_map_next
+
+unsigned int _dstr_map_match(const unsigned char* group, unsigned char value) {
+#ifdef DSTR_SSE2
+    __m128i controls = _mm_loadu_si128((const __m128i*)group);
+    return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(controls, _mm_set1_epi8((char)value)));
+#else
+    unsigned int mask = 0;
+    int i;
+    for (i = 0; i < DSTR_MAP_GROUP_SIZE; ++i) {
+        mask |= (unsigned int)(group[i] == value) << i;
+    }
+    return mask;
+#endif
+} // _dstr_map_match
+
+unsigned int _dstr_map_match_free(const unsigned char* group) {
+#ifdef DSTR_SSE2
+    // Free slots are the ones with the high bit set.
+    return (unsigned int)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+    unsigned int mask = 0;
+    int i;
+    for (i = 0; i < DSTR_MAP_GROUP_SIZE; ++i) {
+        mask |= (unsigned int)(group[i] >> 7) << i;
+    }
+    return mask;
+#endif
+} // _dstr_map_match_free
+
+unsigned int _dstr_map_first_bit(unsigned int mask) {
+#ifdef DSTR_SSE2
+    return _dstr_bit_scan_forward(mask);
+#else
+    unsigned int bit = 0;
+    assert(mask);
+    while (!(mask & 1)) {
+        mask >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+} // _dstr_map_first_bit
+
+size_t _dstr_map_find_index(const dstr_map* map, const dstr_char_t* key, size_t size, uint64_t hash) {
+
+    size_t group_mask;
+    size_t group;
+    size_t step = 0;
+    unsigned char h2 = (unsigned char)(hash & 0x7F);
+
+    if (!map->capacity) {
+        return DSTR_NPOS;
+    }
+
+    group_mask = map->capacity / DSTR_MAP_GROUP_SIZE - 1;
+    group = (size_t)(hash >> 7) & group_mask;
+
+    for (;;) {
+
+        const unsigned char* controls = map->controls + group * DSTR_MAP_GROUP_SIZE;
+        unsigned int mask = _dstr_map_match(controls, h2);
+
+        while (mask) {
+            size_t index = group * DSTR_MAP_GROUP_SIZE + _dstr_map_first_bit(mask);
+            const dstr_map_entry* entry = &map->entries[index];
+
+            if (entry->hash == hash
+                && dstr_size(&entry->key) == size
+                && memcmp(dstr_data(&entry->key), key, size) == 0) {
+                return index;
+            }
+
+            mask &= mask - 1;
+        }
+
+        // An empty slot ends the probe sequence.
+        if (_dstr_map_match(controls, _DSTR_MAP_EMPTY)) {
+            return DSTR_NPOS;
+        }
+
+        ++step;
+        group = (group + step) & group_mask;
+    }
+} // _dstr_map_find_index
+
+size_t _dstr_map_find_free_index(const dstr_map* map, uint64_t hash) {
+
+    size_t group_mask = map->capacity / DSTR_MAP_GROUP_SIZE - 1;
+    size_t group = (size_t)(hash >> 7) & group_mask;
+    size_t step = 0;
+
+    for (;;) {
+
+        unsigned int mask = _dstr_map_match_free(map->controls + group * DSTR_MAP_GROUP_SIZE);
+
+        if (mask) {
+            return group * DSTR_MAP_GROUP_SIZE + _dstr_map_first_bit(mask);
+        }
+
+        ++step;
+        group = (group + step) & group_mask;
+    }
+} // _dstr_map_find_free_index
+
+size_t _dstr_map_capacity_for(size_t count) {
+
+    size_t capacity = DSTR_MAP_GROUP_SIZE;
+
+    while (count * 8 > capacity * 7) {
+        capacity *= 2;
+    }
+
+    return capacity;
+} // _dstr_map_capacity_for
+
+void _dstr_map_rehash(dstr_map* map, size_t capacity) {
+
+    unsigned char* old_controls = map->controls;
+    dstr_map_entry* old_entries = map->entries;
+    size_t old_capacity = map->capacity;
+    size_t i;
+
+    map->controls = (unsigned char*)map->allocator->alloc(map->allocator->user_data, capacity);
+    map->entries = (dstr_map_entry*)map->allocator->alloc(map->allocator->user_data, capacity * sizeof(dstr_map_entry));
+    assert(map->controls && map->entries);
+
+    memset(map->controls, _DSTR_MAP_EMPTY, capacity);
+    map->capacity = capacity;
+    map->deleted = 0;
+
+    // Entries are moved with a plain copy, stored hashes are reused.
+    for (i = 0; i < old_capacity; ++i) {
+        if (!_DSTR_MAP_IS_FREE(old_controls[i])) {
+            size_t index = _dstr_map_find_free_index(map, old_entries[i].hash);
+            map->controls[index] = old_controls[i];
+            map->entries[index] = old_entries[i];
+        }
+    }
+
+    if (old_capacity) {
+        map->allocator->free(map->allocator->user_data, old_controls, old_capacity);
+        map->allocator->free(map->allocator->user_data, old_entries, old_capacity * sizeof(dstr_map_entry));
+    }
+} // _dstr_map_rehash
+
+//-------------------------------------------------------------------------
+// dstr_map - Implementation - END
+//-------------------------------------------------------------------------
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // RE_DSTR_MAP_H
@@ -0,0 +1,256 @@
+// dstr_reader.h - v0.1 - kevreco - CC0 1.0 Licence (public domain)
+// Buffered line reader over a file descriptor or a FILE*
+// https://github.com/kevreco/re_lib
+
+/*
+
+NOTES:
+=====
+
+- Depends on dstr.h
+- The stream is read by large blocks (DSTR_READER_BLOCK_SIZE by default), lines are searched in the block
+  with memchr (vectorized by the C library, like dstr_tokenizer).
+- Lines are views inside the block, nothing is copied, except for a line spanning two blocks:
+  it's copied into a dstr owned by the reader.
+- A line view is invalidated by the next call to dstr_reader_next_line (or dstr_getline) and by dstr_reader_clear.
+- '\n' is not part of the line, '\r' is kept. The last line is returned even without a final '\n'.
+- File descriptors are only supported on POSIX platforms. The stream is never closed by the reader.
+- A file descriptor is read with read(): lines are returned as soon as they are available (pipes, terminals, sockets).
+  A FILE* is read with fread, which waits for a whole block or the end of the stream,
+  use dstr_reader_init_fd(&reader, fileno(file), 0) for pipes, terminals and sockets.
+- Memory comes from the thread allocator at initialization time.
+- Not thread-safe.
+- Unit tests are made in ./testsuite/
+
+CHANGES (DD/MM/YYYY):
+====================
+
+- 16/10/2026 (0.1) - First implementation
+
+EXAMPLE:
+=======
+
+    dstr_reader reader;
+    dstr_view line;
+
+    dstr_reader_init_fd(&reader, STDIN_FILENO, 0);
+
+    while (dstr_reader_next_line(&reader, &line)) {
+        ...
+    }
+
+    if (dstr_reader_error(&reader)) {
+        ...
+    }
+
+    dstr_reader_clear(&reader);
+
+*/
+
+#ifndef RE_DSTR_READER_H
+#define RE_DSTR_READER_H
+
+#include "dstr.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define DSTR_READER_FD
+#include <unistd.h> // read
+#include <errno.h>  // errno, EINTR
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DSTR_READER_BLOCK_SIZE
+#define DSTR_READER_BLOCK_SIZE (256 * 1024)
+#endif
+
+//-------------------------------------------------------------------------
+// dstr_reader - API - BEGIN
+//-------------------------------------------------------------------------
+
+typedef struct dstr_reader {
+    const dstr_allocator* allocator;
+    dstr_char_t* block;   // Allocated on the first read
+    size_t block_size;
+    size_t begin;         // First char not returned yet
+    size_t end;           // End of the chars read in the block
+    dstr line;            // Line spanning two blocks
+    FILE* file;           // 0 when reading a file descriptor
+    int fd;
+    int eof;
+    int error;
+} dstr_reader;
+
+// 'block_size' is the number of bytes read at once, 0 for DSTR_READER_BLOCK_SIZE.
+#ifdef DSTR_READER_FD
+void dstr_reader_init_fd(dstr_reader* reader, int fd, size_t block_size);
+#endif
+void dstr_reader_init_file(dstr_reader* reader, FILE* file, size_t block_size);
+// Releases memory, the stream is not closed.
+void dstr_reader_clear(dstr_reader* reader);
+
+// Returns 0 at the end of the stream (or on error), otherwise 'line' is the next line, without '\n'.
+int  dstr_reader_next_line(dstr_reader* reader, dstr_view* line);
+// Same as above, the line is copied into 'line'.
+int  dstr_getline(dstr_reader* reader, dstr* line);
+
+// Returns 1 if reading the stream failed.
+int  dstr_reader_error(const dstr_reader* reader);
+
+//-------------------------------------------------------------------------
+// dstr_reader - API - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_reader - Private - BEGIN
+//-------------------------------------------------------------------------
+
+void _dstr_reader_init(dstr_reader* reader, FILE* file, int fd, size_t block_size);
+// Reads the next block, returns 0 at the end of the stream.
+int  _dstr_reader_fill(dstr_reader* reader);
+
+//-------------------------------------------------------------------------
+// dstr_reader - Private - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_reader - Implementation - BEGIN
+//-------------------------------------------------------------------------
+
+#ifdef DSTR_READER_FD
+void dstr_reader_init_fd(dstr_reader* reader, int fd, size_t block_size) {
+    _dstr_reader_init(reader, 0, fd, block_size);
+} // dstr_reader_init_fd
+#endif
+
+void dstr_reader_init_file(dstr_reader* reader, FILE* file, size_t block_size) {
+    _dstr_reader_init(reader, file, -1, block_size);
+} // dstr_reader_init_file
+
+void dstr_reader_clear(dstr_reader* reader) {
+
+    if (reader->block) {
+        reader->allocator->free(reader->allocator->user_data, reader->block, reader->block_size);
+    }
+    dstr_clear(&reader->line);
+
+    _dstr_reader_init(reader, reader->file, reader->fd, reader->block_size);
+} // dstr_reader_clear
+
+int dstr_reader_next_line(dstr_reader* reader, dstr_view* line) {
+
+    // The previous line may have been copied.
+    if (dstr_size(&reader->line)) {
+        dstr_erase_range(&reader->line, dstr_begin(&reader->line), dstr_end(&reader->line));
+    }
+
+    for (;;) {
+        dstr_char_t* first = reader->block + reader->begin;
+        size_t count = reader->end - reader->begin;
+        dstr_char_t* found = count ? (dstr_char_t*)memchr(first, '\n', count) : 0;
+
+        if (found) {
+            reader->begin += (size_t)(found - first) + 1;
+
+            if (dstr_size(&reader->line)) {
+                dstr_append_range(&reader->line, first, found);
+                *line = dstr_view_make_from_dstr(&reader->line);
+            } else {
+                *line = dstr_view_make(first, (size_t)(found - first));
+            }
+            return 1;
+        }
+
+        // The rest of the block is the start of a line.
+        if (count) {
+            dstr_append_range(&reader->line, first, first + count);
+        }
+        reader->begin = 0;
+        reader->end = 0;
+
+        if (!_dstr_reader_fill(reader)) {
+            *line = dstr_view_make_from_dstr(&reader->line);
+            return dstr_size(&reader->line) != 0;
+        }
+    }
+} // dstr_reader_next_line
+
+int dstr_getline(dstr_reader* reader, dstr* line) {
+
+    dstr_view v;
+
+    if (!dstr_reader_next_line(reader, &v)) {
+        dstr_assign_str(line, "");
+        return 0;
+    }
+
+    dstr_assign_view(line, v);
+    return 1;
+} // dstr_getline
+
+inline int dstr_reader_error(const dstr_reader* reader) {
+    return reader->error;
+} // dstr_reader_error
+
+void _dstr_reader_init(dstr_reader* reader, FILE* file, int fd, size_t block_size) {
+
+    reader->allocator = dstr_get_thread_allocator();
+    reader->block = 0;
+    reader->block_size = block_size ? block_size : DSTR_READER_BLOCK_SIZE;
+    reader->begin = 0;
+    reader->end = 0;
+    dstr_init(&reader->line);
+    reader->file = file;
+    reader->fd = fd;
+    reader->eof = 0;
+    reader->error = 0;
+} // _dstr_reader_init
+
+int _dstr_reader_fill(dstr_reader* reader) {
+
+    size_t count = 0;
+
+    if (reader->eof) {
+        return 0;
+    }
+
+    if (!reader->block) {
+        reader->block = (dstr_char_t*)reader->allocator->alloc(reader->allocator->user_data, reader->block_size);
+        assert(reader->block);
+    }
+
+    if (reader->file) {
+        count = fread(reader->block, 1, reader->block_size, reader->file);
+        reader->error = !count && ferror(reader->file);
+    }
+#ifdef DSTR_READER_FD
+    else {
+        ssize_t result;
+
+        do {
+            result = read(reader->fd, reader->block, reader->block_size);
+        } while (result < 0 && errno == EINTR);
+
+        reader->error = result < 0;
+        count = result > 0 ? (size_t)result : 0;
+    }
+#endif
+
+    // Short reads (pipes, terminals) are returned as they are.
+    reader->eof = !count;
+    reader->end = count;
+
+    return count != 0;
+} // _dstr_reader_fill
+
+//-------------------------------------------------------------------------
+// dstr_reader - Implementation - END
+//-------------------------------------------------------------------------
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // RE_DSTR_READER_H
@@ -0,0 +1,399 @@
+// dstr_replacer.h - v0.1 - kevreco - CC0 1.0 Licence (public domain)
+// Multi-pattern find and replace for dstr (Aho-Corasick)
+// https://github.com/kevreco/re_lib
+
+/*
+
+NOTES:
+=====
+
+- Depends on dstr.h
+- Patterns are compiled once into a DFA (Aho-Corasick automaton with its failure transitions resolved)
+  of the reversed patterns: scanning the input backward gives the longest pattern starting at each position.
+- The input is processed by windows of DSTR_REPLACER_WINDOW positions (at least the size of the longest pattern).
+  Each window is read twice: backward by the automaton, which stores the matches, then forward to copy it.
+  The backward scan starts after the window to see the patterns crossing its end (at most the size of
+  the longest pattern), positions already replaced are not scanned. The cost is linear and does not depend
+  on the number or the size of the patterns.
+- Leftmost-longest semantics:
+   - The occurrence starting first is replaced, the longest one if several start at the same position.
+   - Replaced text is never scanned again (no recursive replacement).
+- Matches are stored in a temporary buffer of one window (one entry per position where a pattern starts).
+- Nothing is copied by dstr_replacer_replace when there is no match.
+- Bytes are grouped in classes (bytes not used by any pattern share the same class) to keep the table small.
+- Memory comes from the thread allocator at initialization time.
+- Unit tests are made in ./testsuite/
+
+CHANGES (DD/MM/YYYY):
+====================
+
+- 16/10/2026 (0.1) - First implementation
+
+EXAMPLE:
+=======
+
+    dstr_replace_pair pairs[] = {
+        { "&", "&amp;" },
+        { "<", "&lt;" },
+        { ">", "&gt;" }
+    };
+
+    dstr_replacer replacer;
+    dstr_replacer_init(&replacer, pairs, 3);
+
+    dstr_replacer_replace(&replacer, &s);
+
+    dstr_replacer_clear(&replacer);
+
+*/
+
+#ifndef RE_DSTR_REPLACER_H
+#define RE_DSTR_REPLACER_H
+
+#include "dstr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DSTR_REPLACER_WINDOW
+#define DSTR_REPLACER_WINDOW 4096
+#endif
+
+//-------------------------------------------------------------------------
+// dstr_replacer - API - BEGIN
+//-------------------------------------------------------------------------
+
+typedef struct dstr_replace_pair {
+    const dstr_char_t* pattern;
+    const dstr_char_t* replacement;
+} dstr_replace_pair;
+
+typedef struct _dstr_replacer_state {
+    size_t depth;        // Length of the prefix represented by the state
+    size_t output;       // Index of the longest (reversed) pattern ending at this state + 1, 0 if none
+} _dstr_replacer_state;
+
+typedef struct _dstr_replacer_match {
+    size_t position;     // Start of the pattern in the input
+    size_t pattern;
+} _dstr_replacer_match;
+
+typedef struct dstr_replacer {
+    const dstr_allocator* allocator;
+    unsigned char classes[256];   // Class of each byte, 0 for bytes not used by patterns
+    size_t class_count;
+    size_t state_count;
+    size_t* transitions;          // state_count * class_count next states
+    _dstr_replacer_state* states;
+    size_t pattern_count;
+    size_t max_pattern_size;
+    size_t* pattern_sizes;
+    size_t* replacement_offsets;  // Replacement 'i' is in [offsets[i], offsets[i + 1]) of 'replacements'
+    dstr replacements;
+} dstr_replacer;
+
+// Compiles the patterns, empty patterns are ignored.
+// If a pattern is given twice the first replacement is used.
+void   dstr_replacer_init(dstr_replacer* replacer, const dstr_replace_pair* pairs, size_t count);
+void   dstr_replacer_clear(dstr_replacer* replacer);
+
+// Appends the replaced input to 'output', returns the number of replacements.
+size_t dstr_replacer_append(const dstr_replacer* replacer, dstr* output, const dstr_it first, const dstr_it last);
+// Replaces occurrences in 's', returns the number of replacements.
+size_t dstr_replacer_replace(const dstr_replacer* replacer, dstr* s);
+
+//-------------------------------------------------------------------------
+// dstr_replacer - API - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_replacer - Private - BEGIN
+//-------------------------------------------------------------------------
+
+void*  _dstr_replacer_alloc(const dstr_replacer* replacer, size_t size);
+void   _dstr_replacer_free(const dstr_replacer* replacer, void* ptr, size_t size);
+// Appends the input to 'output' up to the end of the last replacement, returns the number of replacements.
+// Nothing is appended if there is no match. 'copied' receives the size of the input already handled.
+size_t _dstr_replacer_scan(const dstr_replacer* replacer, dstr* output, const unsigned char* text, size_t size, size_t* copied);
+
+//-------------------------------------------------------------------------
+// dstr_replacer - Private - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_replacer - Implementation - BEGIN
+//-------------------------------------------------------------------------
+
+void dstr_replacer_init(dstr_replacer* replacer, const dstr_replace_pair* pairs, size_t count) {
+
+    size_t i;
+    size_t c;
+    size_t max_state_count = 1; // root
+    size_t* fail;
+    size_t* queue;
+    size_t queue_begin = 0;
+    size_t queue_end = 0;
+
+    replacer->allocator = dstr_get_thread_allocator();
+    replacer->pattern_count = count;
+    replacer->max_pattern_size = 0;
+
+    // Byte classes
+    memset(replacer->classes, 0, sizeof(replacer->classes));
+    replacer->class_count = 1;
+
+    for (i = 0; i < count; ++i) {
+        const unsigned char* p = (const unsigned char*)pairs[i].pattern;
+        for (; *p; ++p) {
+            if (!replacer->classes[*p]) {
+                replacer->classes[*p] = (unsigned char)replacer->class_count++;
+            }
+            ++max_state_count;
+        }
+    }
+
+    // Replacements
+    replacer->pattern_sizes = (size_t*)_dstr_replacer_alloc(replacer, count * sizeof(size_t));
+    replacer->replacement_offsets = (size_t*)_dstr_replacer_alloc(replacer, (count + 1) * sizeof(size_t));
+    dstr_init(&replacer->replacements);
+
+    for (i = 0; i < count; ++i) {
+        replacer->pattern_sizes[i] = strlen(pairs[i].pattern);
+        if (replacer->pattern_sizes[i] > replacer->max_pattern_size) {
+            replacer->max_pattern_size = replacer->pattern_sizes[i];
+        }
+        replacer->replacement_offsets[i] = dstr_size(&replacer->replacements);
+        dstr_append_str(&replacer->replacements, pairs[i].replacement);
+    }
+    replacer->replacement_offsets[count] = dstr_size(&replacer->replacements);
+
+    // Trie of the reversed patterns, 0 is the root and also means 'no child' since no transition goes back to the root.
+    replacer->transitions = (size_t*)_dstr_replacer_alloc(replacer, max_state_count * replacer->class_count * sizeof(size_t));
+    replacer->states = (_dstr_replacer_state*)_dstr_replacer_alloc(replacer, max_state_count * sizeof(_dstr_replacer_state));
+
+    memset(replacer->transitions, 0, max_state_count * replacer->class_count * sizeof(size_t));
+    replacer->states[0].depth = 0;
+    replacer->states[0].output = 0;
+    replacer->state_count = 1;
+
+    for (i = 0; i < count; ++i) {
+        const unsigned char* first = (const unsigned char*)pairs[i].pattern;
+        const unsigned char* p = first + replacer->pattern_sizes[i];
+        size_t state = 0;
+
+        if (p == first) {
+            continue;
+        }
+
+        while (p != first) {
+            size_t* next = &replacer->transitions[state * replacer->class_count + replacer->classes[*--p]];
+            if (!*next) {
+                *next = replacer->state_count++;
+                replacer->states[*next].depth = replacer->states[state].depth + 1;
+                replacer->states[*next].output = 0;
+            }
+            state = *next;
+        }
+
+        if (!replacer->states[state].output) {
+            replacer->states[state].output = i + 1;
+        }
+    }
+
+    // Failure links in breadth-first order, missing transitions are replaced
+    // by the transitions of the failure state (already complete since it's less deep).
+    fail = (size_t*)_dstr_replacer_alloc(replacer, replacer->state_count * sizeof(size_t));
+    queue = (size_t*)_dstr_replacer_alloc(replacer, replacer->state_count * sizeof(size_t));
+
+    fail[0] = 0;
+    queue[queue_end++] = 0;
+
+    while (queue_begin != queue_end) {
+
+        size_t state = queue[queue_begin++];
+        size_t* row = &replacer->transitions[state * replacer->class_count];
+        const size_t* fail_row = &replacer->transitions[fail[state] * replacer->class_count];
+
+        for (c = 0; c < replacer->class_count; ++c) {
+
+            size_t child = row[c];
+
+            // Children are always deeper, otherwise it's a resolved failure transition.
+            if (child && replacer->states[child].depth == replacer->states[state].depth + 1) {
+
+                fail[child] = state ? fail_row[c] : 0;
+
+                // Longest pattern ending here: its own pattern, or the longest one of its failure state.
+                if (!replacer->states[child].output) {
+                    replacer->states[child].output = replacer->states[fail[child]].output;
+                }
+
+                queue[queue_end++] = child;
+
+            } else {
+                row[c] = state ? fail_row[c] : 0;
+            }
+        }
+    }
+
+    _dstr_replacer_free(replacer, queue, replacer->state_count * sizeof(size_t));
+    _dstr_replacer_free(replacer, fail, replacer->state_count * sizeof(size_t));
+
+    // 'states' and 'transitions' are kept with their initial size, it's needed to release them.
+    replacer->state_count = max_state_count;
+} // dstr_replacer_init
+
+void dstr_replacer_clear(dstr_replacer* replacer) {
+
+    _dstr_replacer_free(replacer, replacer->transitions, replacer->state_count * replacer->class_count * sizeof(size_t));
+    _dstr_replacer_free(replacer, replacer->states, replacer->state_count * sizeof(_dstr_replacer_state));
+    _dstr_replacer_free(replacer, replacer->pattern_sizes, replacer->pattern_count * sizeof(size_t));
+    _dstr_replacer_free(replacer, replacer->replacement_offsets, (replacer->pattern_count + 1) * sizeof(size_t));
+    dstr_clear(&replacer->replacements);
+
+    replacer->transitions = 0;
+    replacer->states = 0;
+    replacer->pattern_sizes = 0;
+    replacer->replacement_offsets = 0;
+    replacer->state_count = 0;
+    replacer->pattern_count = 0;
+    replacer->max_pattern_size = 0;
+} // dstr_replacer_clear
+
+size_t dstr_replacer_append(const dstr_replacer* replacer, dstr* output, const dstr_it first, const dstr_it last) {
+
+    const unsigned char* text = (const unsigned char*)first;
+    const size_t size = (size_t)(last - first);
+    size_t copied;
+    size_t count = _dstr_replacer_scan(replacer, output, text, size, &copied);
+
+    dstr_append_range(output, (dstr_it)text + copied, (dstr_it)text + size);
+
+    return count;
+} // dstr_replacer_append
+
+size_t dstr_replacer_replace(const dstr_replacer* replacer, dstr* s) {
+
+    const unsigned char* text = (const unsigned char*)dstr_data(s);
+    const size_t size = dstr_size(s);
+    size_t copied;
+    dstr result = dstr_make_with_allocator(0, dstr_get_attached_allocator(s));
+    size_t count = _dstr_replacer_scan(replacer, &result, text, size, &copied);
+
+    if (count) {
+        dstr_append_range(&result, (dstr_it)text + copied, (dstr_it)text + size);
+        dstr_swap(s, &result);
+    }
+    dstr_clear(&result);
+
+    return count;
+} // dstr_replacer_replace
+
+void* _dstr_replacer_alloc(const dstr_replacer* replacer, size_t size) {
+
+    void* ptr = replacer->allocator->alloc(replacer->allocator->user_data, size ? size : 1);
+    assert(ptr);
+
+    return ptr;
+} // _dstr_replacer_alloc
+
+void _dstr_replacer_free(const dstr_replacer* replacer, void* ptr, size_t size) {
+
+    if (ptr) {
+        replacer->allocator->free(replacer->allocator->user_data, ptr, size ? size : 1);
+    }
+} // _dstr_replacer_free
+
+size_t _dstr_replacer_scan(const dstr_replacer* replacer, dstr* output, const unsigned char* text, size_t size, size_t* copied) {
+
+    const size_t* transitions = replacer->transitions;
+    const _dstr_replacer_state* states = replacer->states;
+    const size_t class_count = replacer->class_count;
+    const size_t max_pattern_size = replacer->max_pattern_size;
+    const size_t window = max_pattern_size > DSTR_REPLACER_WINDOW ? max_pattern_size : DSTR_REPLACER_WINDOW;
+    const size_t match_capacity = window < size ? window : size;
+
+    _dstr_replacer_match* matches;
+    size_t count = 0;
+    size_t begin = 0;
+
+    *copied = 0; // Text before 'copied' is already in the output
+
+    if (!max_pattern_size) {
+        return 0;
+    }
+
+    matches = (_dstr_replacer_match*)_dstr_replacer_alloc(replacer, match_capacity * sizeof(_dstr_replacer_match));
+
+    while (begin < size) {
+
+        const size_t end = size - begin > window ? begin + window : size;
+        // Positions inside the previous replacement can't start a match.
+        const size_t low = *copied > begin ? *copied : begin;
+        size_t match_count = 0;
+        size_t state = 0;
+        size_t i = size - end > max_pattern_size ? end + max_pattern_size : size;
+
+        // Backward: the longest pattern starting at 'i' is the longest reversed pattern ending at 'i'.
+        // Chars after the window only complete the patterns starting in it.
+        while (i > end) {
+            --i;
+            state = transitions[state * class_count + replacer->classes[text[i]]];
+        }
+
+        // Matches are stored by decreasing position.
+        while (i > low) {
+            --i;
+            state = transitions[state * class_count + replacer->classes[text[i]]];
+
+            if (states[state].output) {
+                matches[match_count].position = i;
+                matches[match_count].pattern = states[state].output - 1;
+                ++match_count;
+            }
+        }
+
+        // Forward: the leftmost match is replaced, matches starting inside it are skipped.
+        while (match_count) {
+
+            const _dstr_replacer_match* match = &matches[--match_count];
+            const dstr_char_t* replacement;
+            size_t replacement_size;
+
+            if (match->position < *copied) {
+                continue;
+            }
+
+            // Nothing is copied before the first match.
+            if (!count) {
+                dstr_reserve(output, dstr_size(output) + size + 1);
+            }
+
+            replacement = dstr_data(&replacer->replacements) + replacer->replacement_offsets[match->pattern];
+            replacement_size = replacer->replacement_offsets[match->pattern + 1] - replacer->replacement_offsets[match->pattern];
+
+            dstr_append_range(output, (dstr_it)text + *copied, (dstr_it)text + match->position);
+            dstr_append_range(output, (dstr_it)replacement, (dstr_it)replacement + replacement_size);
+            ++count;
+
+            *copied = match->position + replacer->pattern_sizes[match->pattern];
+        }
+
+        begin = end;
+    }
+
+    _dstr_replacer_free(replacer, matches, match_capacity * sizeof(_dstr_replacer_match));
+
+    return count;
+} // _dstr_replacer_scan
+
+//-------------------------------------------------------------------------
+// dstr_replacer - Implementation - END
+//-------------------------------------------------------------------------
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // RE_DSTR_REPLACER_H
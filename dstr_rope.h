@@ -0,0 +1,738 @@
+// dstr_rope.h - v0.1 - kevreco - CC0 1.0 Licence (public domain)
+// Rope (chunked string) for very large strings and mid-string edits
+// https://github.com/kevreco/re_lib
+
+/*
+
+NOTES:
+=====
+
+- Depends on dstr.h
+- A rope is an AVL tree of chunks, each chunk holds up to DSTR_ROPE_CHUNK_SIZE chars.
+- Insert, erase and concatenation are O(log n) (plus the size of the inserted data),
+  the tail of the string is never moved.
+- Small insertions are made in place when the chunk has enough room.
+- Adjacent chunks are merged when they fit in one chunk after an erase or a concatenation.
+- Chunks can be iterated with dstr_rope_first_chunk/dstr_rope_next_chunk.
+- Search uses dstr_searcher, compare follows dstr_compare_dstr.
+- Memory comes from the thread allocator at initialization time.
+- Positions are indexes, there is no iterator on chars.
+- Unit tests are made in ./testsuite/
+
+CHANGES (DD/MM/YYYY):
+====================
+
+- 16/10/2026 (0.1) - First implementation
+
+EXAMPLE:
+=======
+
+    dstr_rope rope;
+    dstr s;
+
+    dstr_rope_init(&rope);
+    dstr_rope_append_str(&rope, "Hello World!");
+    dstr_rope_insert_str(&rope, 5, ",");
+    dstr_rope_erase(&rope, 6, 6);
+
+    dstr_init(&s);
+    dstr_rope_flatten(&rope, &s); // "Hello,!"
+
+    dstr_clear(&s);
+    dstr_rope_clear(&rope);
+
+*/
+
+#ifndef RE_DSTR_ROPE_H
+#define RE_DSTR_ROPE_H
+
+#include "dstr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DSTR_ROPE_CHUNK_SIZE
+#define DSTR_ROPE_CHUNK_SIZE 4096
+#endif
+
+// AVL height is lower than 1.45 * log2(node count + 2)
+#define DSTR_ROPE_MAX_HEIGHT 96
+
+//-------------------------------------------------------------------------
+// dstr_rope - API - BEGIN
+//-------------------------------------------------------------------------
+
+typedef struct _dstr_rope_node {
+    struct _dstr_rope_node* left;
+    struct _dstr_rope_node* right;
+    size_t total;  // Chars in the subtree
+    size_t size;   // Chars in this chunk
+    int height;
+    dstr_char_t data[DSTR_ROPE_CHUNK_SIZE];
+} _dstr_rope_node;
+
+typedef struct dstr_rope {
+    const dstr_allocator* allocator;
+    _dstr_rope_node* root;
+} dstr_rope;
+
+typedef struct dstr_rope_iterator {
+    const dstr_char_t* data;  // Current chunk
+    size_t size;              // Size of the current chunk
+    size_t position;          // Position of 'data' in the rope
+    const _dstr_rope_node* current;
+    const _dstr_rope_node* stack[DSTR_ROPE_MAX_HEIGHT];
+    size_t depth;
+} dstr_rope_iterator;
+
+void   dstr_rope_init(dstr_rope* rope);
+void   dstr_rope_clear(dstr_rope* rope);
+
+size_t dstr_rope_size(const dstr_rope* rope);
+int    dstr_rope_empty(const dstr_rope* rope);
+dstr_char_t dstr_rope_at(const dstr_rope* rope, size_t pos);
+
+void   dstr_rope_append_str(dstr_rope* rope, const dstr_char_t* str);
+void   dstr_rope_append_range(dstr_rope* rope, const dstr_it first, const dstr_it last);
+void   dstr_rope_append_dstr(dstr_rope* rope, const dstr* s);
+// Moves the content of 'other' at the end of 'rope', 'other' is left empty.
+// Both ropes must use the same allocator.
+void   dstr_rope_append_rope(dstr_rope* rope, dstr_rope* other);
+
+void   dstr_rope_insert_str(dstr_rope* rope, size_t pos, const dstr_char_t* str);
+void   dstr_rope_insert_range(dstr_rope* rope, size_t pos, const dstr_it first, const dstr_it last);
+void   dstr_rope_erase(dstr_rope* rope, size_t pos, size_t count);
+
+// Replaces the content of 's' with the content of the rope.
+void   dstr_rope_flatten(const dstr_rope* rope, dstr* s);
+
+// Iterates over chunks starting at 'pos', the first chunk starts at 'pos'.
+// Returns 0 when there is no chunk left.
+int    dstr_rope_first_chunk(const dstr_rope* rope, size_t pos, dstr_rope_iterator* it);
+int    dstr_rope_next_chunk(dstr_rope_iterator* it);
+
+int    dstr_rope_compare_dstr(const dstr_rope* rope, const dstr* s);
+int    dstr_rope_compare_rope(const dstr_rope* rope, const dstr_rope* other);
+
+// Occurrences spanning several chunks are found.
+size_t dstr_rope_find(const dstr_rope* rope, size_t pos, const dstr_searcher* searcher);
+size_t dstr_rope_find_str(const dstr_rope* rope, size_t pos, const dstr_char_t* str);
+
+//-------------------------------------------------------------------------
+// dstr_rope - API - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_rope - Private - BEGIN
+//-------------------------------------------------------------------------
+
+int    _dstr_rope_height(const _dstr_rope_node* node);
+size_t _dstr_rope_total(const _dstr_rope_node* node);
+void   _dstr_rope_update(_dstr_rope_node* node);
+_dstr_rope_node* _dstr_rope_rotate_left(_dstr_rope_node* node);
+_dstr_rope_node* _dstr_rope_rotate_right(_dstr_rope_node* node);
+_dstr_rope_node* _dstr_rope_balance(_dstr_rope_node* node);
+_dstr_rope_node* _dstr_rope_join(_dstr_rope_node* left, _dstr_rope_node* node, _dstr_rope_node* right);
+_dstr_rope_node* _dstr_rope_remove_first(_dstr_rope_node* node, _dstr_rope_node** rest);
+_dstr_rope_node* _dstr_rope_remove_last(_dstr_rope_node* node, _dstr_rope_node** rest);
+_dstr_rope_node* _dstr_rope_merge(dstr_rope* rope, _dstr_rope_node* left, _dstr_rope_node* right);
+void   _dstr_rope_split(dstr_rope* rope, _dstr_rope_node* node, size_t pos, _dstr_rope_node** left, _dstr_rope_node** right);
+_dstr_rope_node* _dstr_rope_new_node(dstr_rope* rope, const dstr_char_t* data, size_t size);
+void   _dstr_rope_free_node(dstr_rope* rope, _dstr_rope_node* node);
+void   _dstr_rope_free_tree(dstr_rope* rope, _dstr_rope_node* node);
+
+//-------------------------------------------------------------------------
+// dstr_rope - Private - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_rope - Implementation - BEGIN
+//-------------------------------------------------------------------------
+
+void dstr_rope_init(dstr_rope* rope) {
+    rope->allocator = dstr_get_thread_allocator();
+    rope->root = 0;
+} // dstr_rope_init
+
+void dstr_rope_clear(dstr_rope* rope) {
+    _dstr_rope_free_tree(rope, rope->root);
+    rope->root = 0;
+} // dstr_rope_clear
+
+size_t dstr_rope_size(const dstr_rope* rope) {
+    return _dstr_rope_total(rope->root);
+} // dstr_rope_size
+
+int dstr_rope_empty(const dstr_rope* rope) {
+    return !rope->root;
+} // dstr_rope_empty
+
+dstr_char_t dstr_rope_at(const dstr_rope* rope, size_t pos) {
+
+    const _dstr_rope_node* node = rope->root;
+
+    assert(pos < dstr_rope_size(rope));
+
+    for (;;) {
+        size_t left_total = _dstr_rope_total(node->left);
+        if (pos < left_total) {
+            node = node->left;
+        } else if (pos < left_total + node->size) {
+            return node->data[pos - left_total];
+        } else {
+            pos -= left_total + node->size;
+            node = node->right;
+        }
+    }
+} // dstr_rope_at
+
+void dstr_rope_append_str(dstr_rope* rope, const dstr_char_t* str) {
+    dstr_rope_insert_range(rope, dstr_rope_size(rope), (dstr_it)str, (dstr_it)str + strlen(str));
+} // dstr_rope_append_str
+
+void dstr_rope_append_range(dstr_rope* rope, const dstr_it first, const dstr_it last) {
+    dstr_rope_insert_range(rope, dstr_rope_size(rope), first, last);
+} // dstr_rope_append_range
+
+void dstr_rope_append_dstr(dstr_rope* rope, const dstr* s) {
+    dstr_rope_insert_range(rope, dstr_rope_size(rope), dstr_begin(s), dstr_end(s));
+} // dstr_rope_append_dstr
+
+void dstr_rope_append_rope(dstr_rope* rope, dstr_rope* other) {
+
+    assert(rope->allocator == other->allocator);
+
+    rope->root = _dstr_rope_merge(rope, rope->root, other->root);
+    other->root = 0;
+} // dstr_rope_append_rope
+
+void dstr_rope_insert_str(dstr_rope* rope, size_t pos, const dstr_char_t* str) {
+    dstr_rope_insert_range(rope, pos, (dstr_it)str, (dstr_it)str + strlen(str));
+} // dstr_rope_insert_str
+
+void dstr_rope_insert_range(dstr_rope* rope, size_t pos, const dstr_it first, const dstr_it last) {
+
+    size_t size = (size_t)(last - first);
+    _dstr_rope_node* path[DSTR_ROPE_MAX_HEIGHT];
+    size_t depth = 0;
+    _dstr_rope_node* node = rope->root;
+    size_t offset = pos;
+
+    assert(pos <= dstr_rope_size(rope));
+
+    if (!size) {
+        return;
+    }
+
+    // Find the chunk containing 'pos', the end of a chunk is preferred to the start of the next one.
+    while (node) {
+        size_t left_total = _dstr_rope_total(node->left);
+        path[depth++] = node;
+        if (offset < left_total || (offset == left_total && node->left)) {
+            node = node->left;
+        } else if (offset <= left_total + node->size) {
+            offset -= left_total;
+            break;
+        } else {
+            offset -= left_total + node->size;
+            node = node->right;
+        }
+    }
+
+    if (node && node->size + size <= DSTR_ROPE_CHUNK_SIZE) {
+
+        size_t i;
+
+        memmove(node->data + offset + size, node->data + offset, node->size - offset);
+        memcpy(node->data + offset, first, size);
+        node->size += size;
+
+        for (i = 0; i < depth; ++i) {
+            path[i]->total += size;
+        }
+
+    } else {
+
+        _dstr_rope_node* left;
+        _dstr_rope_node* right;
+        _dstr_rope_node* middle = 0;
+        const dstr_char_t* data = first;
+
+        _dstr_rope_split(rope, rope->root, pos, &left, &right);
+
+        while (size) {
+            size_t chunk_size = size < DSTR_ROPE_CHUNK_SIZE ? size : DSTR_ROPE_CHUNK_SIZE;
+            middle = _dstr_rope_join(middle, _dstr_rope_new_node(rope, data, chunk_size), 0);
+            data += chunk_size;
+            size -= chunk_size;
+        }
+
+        rope->root = _dstr_rope_merge(rope, _dstr_rope_merge(rope, left, middle), right);
+    }
+} // dstr_rope_insert_range
+
+void dstr_rope_erase(dstr_rope* rope, size_t pos, size_t count) {
+
+    size_t size = dstr_rope_size(rope);
+    _dstr_rope_node* left;
+    _dstr_rope_node* middle;
+    _dstr_rope_node* right;
+
+    assert(pos <= size);
+
+    if (count > size - pos) {
+        count = size - pos;
+    }
+
+    if (!count) {
+        return;
+    }
+
+    _dstr_rope_split(rope, rope->root, pos, &left, &right);
+    _dstr_rope_split(rope, right, count, &middle, &right);
+    _dstr_rope_free_tree(rope, middle);
+
+    rope->root = _dstr_rope_merge(rope, left, right);
+} // dstr_rope_erase
+
+void dstr_rope_flatten(const dstr_rope* rope, dstr* s) {
+
+    dstr_rope_iterator it;
+
+    dstr_assign_str(s, "");
+    dstr_reserve(s, dstr_rope_size(rope) + 1);
+
+    if (dstr_rope_first_chunk(rope, 0, &it)) {
+        do {
+            dstr_append_range(s, (dstr_it)it.data, (dstr_it)it.data + it.size);
+        } while (dstr_rope_next_chunk(&it));
+    }
+} // dstr_rope_flatten
+
+int dstr_rope_first_chunk(const dstr_rope* rope, size_t pos, dstr_rope_iterator* it) {
+
+    const _dstr_rope_node* node = rope->root;
+    size_t offset = pos;
+
+    it->depth = 0;
+    it->current = 0;
+    it->data = 0;
+    it->size = 0;
+    it->position = pos;
+
+    while (node) {
+        size_t left_total = _dstr_rope_total(node->left);
+        if (offset < left_total) {
+            it->stack[it->depth++] = node;
+            node = node->left;
+        } else if (offset < left_total + node->size) {
+            offset -= left_total;
+            it->current = node;
+            it->data = node->data + offset;
+            it->size = node->size - offset;
+            return 1;
+        } else {
+            offset -= left_total + node->size;
+            node = node->right;
+        }
+    }
+
+    return 0;
+} // dstr_rope_first_chunk
+
+int dstr_rope_next_chunk(dstr_rope_iterator* it) {
+
+    const _dstr_rope_node* node = it->current->right;
+
+    it->position += it->size;
+
+    while (node) {
+        it->stack[it->depth++] = node;
+        node = node->left;
+    }
+
+    if (!it->depth) {
+        it->current = 0;
+        it->data = 0;
+        it->size = 0;
+        return 0;
+    }
+
+    it->current = it->stack[--it->depth];
+    it->data = it->current->data;
+    it->size = it->current->size;
+
+    return 1;
+} // dstr_rope_next_chunk
+
+int dstr_rope_compare_dstr(const dstr_rope* rope, const dstr* s) {
+
+    size_t size = dstr_rope_size(rope);
+    size_t other_size = dstr_size(s);
+    const dstr_char_t* other = dstr_data(s);
+    size_t remaining = size < other_size ? size : other_size;
+    dstr_rope_iterator it;
+
+    if (remaining && dstr_rope_first_chunk(rope, 0, &it)) {
+        do {
+            size_t count = it.size < remaining ? it.size : remaining;
+            int cmp = memcmp(it.data, other, count);
+            if (cmp) {
+                return cmp;
+            }
+            other += count;
+            remaining -= count;
+        } while (remaining && dstr_rope_next_chunk(&it));
+    }
+
+    return size < other_size ? -1 : size != other_size;
+} // dstr_rope_compare_dstr
+
+int dstr_rope_compare_rope(const dstr_rope* rope, const dstr_rope* other) {
+
+    size_t size = dstr_rope_size(rope);
+    size_t other_size = dstr_rope_size(other);
+    size_t remaining = size < other_size ? size : other_size;
+    dstr_rope_iterator it;
+    dstr_rope_iterator other_it;
+    size_t offset = 0;
+    size_t other_offset = 0;
+
+    if (remaining) {
+
+        dstr_rope_first_chunk(rope, 0, &it);
+        dstr_rope_first_chunk(other, 0, &other_it);
+
+        while (remaining) {
+
+            size_t count = it.size - offset;
+            int cmp;
+
+            if (count > other_it.size - other_offset) {
+                count = other_it.size - other_offset;
+            }
+            if (count > remaining) {
+                count = remaining;
+            }
+
+            cmp = memcmp(it.data + offset, other_it.data + other_offset, count);
+            if (cmp) {
+                return cmp;
+            }
+
+            remaining -= count;
+            offset += count;
+            other_offset += count;
+
+            if (remaining && offset == it.size) {
+                dstr_rope_next_chunk(&it);
+                offset = 0;
+            }
+            if (remaining && other_offset == other_it.size) {
+                dstr_rope_next_chunk(&other_it);
+                other_offset = 0;
+            }
+        }
+    }
+
+    return size < other_size ? -1 : size != other_size;
+} // dstr_rope_compare_rope
+
+size_t dstr_rope_find(const dstr_rope* rope, size_t pos, const dstr_searcher* searcher) {
+
+    size_t pattern_size = dstr_size(&searcher->pattern);
+    size_t overlap = pattern_size - 1;
+    size_t found = DSTR_NPOS;
+    dstr_rope_iterator it;
+    dstr carry;   // Last 'overlap' chars before the current chunk
+    dstr window;  // 'carry' followed by the first 'overlap' chars of the current chunk
+
+    if (!pattern_size || pos > dstr_rope_size(rope) || !dstr_rope_first_chunk(rope, pos, &it)) {
+        return DSTR_NPOS;
+    }
+
+    dstr_init(&carry);
+    dstr_init(&window);
+
+    do {
+        size_t index;
+
+        // Occurrences starting in a previous chunk
+        if (!dstr_empty(&carry)) {
+
+            size_t head = it.size < overlap ? it.size : overlap;
+
+            dstr_assign_dstr(&window, &carry);
+            dstr_append_range(&window, (dstr_it)it.data, (dstr_it)it.data + head);
+
+            index = dstr_searcher_find_range(searcher, dstr_begin(&window), dstr_end(&window));
+            if (index != DSTR_NPOS) {
+                found = it.position - dstr_size(&carry) + index;
+                break;
+            }
+        }
+
+        // Occurrences inside the chunk
+        index = dstr_searcher_find_range(searcher, (dstr_it)it.data, (dstr_it)it.data + it.size);
+        if (index != DSTR_NPOS) {
+            found = it.position + index;
+            break;
+        }
+
+        // Keep the last 'overlap' chars
+        if (overlap) {
+            if (it.size >= overlap) {
+                dstr_assign_range(&carry, (dstr_it)it.data + it.size - overlap, (dstr_it)it.data + it.size);
+            } else {
+                dstr_append_range(&carry, (dstr_it)it.data, (dstr_it)it.data + it.size);
+                if (dstr_size(&carry) > overlap) {
+                    dstr_erase_range(&carry, dstr_begin(&carry), dstr_begin(&carry) + dstr_size(&carry) - overlap);
+                }
+            }
+        }
+
+    } while (dstr_rope_next_chunk(&it));
+
+    dstr_clear(&carry);
+    dstr_clear(&window);
+
+    return found;
+} // dstr_rope_find
+
+size_t dstr_rope_find_str(const dstr_rope* rope, size_t pos, const dstr_char_t* str) {
+
+    dstr_searcher searcher;
+    size_t found;
+
+    dstr_searcher_init(&searcher, str, strlen(str));
+    found = dstr_rope_find(rope, pos, &searcher);
+    dstr_searcher_clear(&searcher);
+
+    return found;
+} // dstr_rope_find_str
+
+int _dstr_rope_height(const _dstr_rope_node* node) {
+    return node ? node->height : 0;
+} // _dstr_rope_height
+
+size_t _dstr_rope_total(const _dstr_rope_node* node) {
+    return node ? node->total : 0;
+} // _dstr_rope_total
+
+void _dstr_rope_update(_dstr_rope_node* node) {
+
+    int left_height = _dstr_rope_height(node->left);
+    int right_height = _dstr_rope_height(node->right);
+
+    node->height = 1 + (left_height > right_height ? left_height : right_height);
+    node->total = _dstr_rope_total(node->left) + node->size + _dstr_rope_total(node->right);
+} // _dstr_rope_update
+
+_dstr_rope_node* _dstr_rope_rotate_left(_dstr_rope_node* node) {
+
+    _dstr_rope_node* right = node->right;
+
+    node->right = right->left;
+    _dstr_rope_update(node);
+    right->left = node;
+    _dstr_rope_update(right);
+
+    return right;
+} // _dstr_rope_rotate_left
+
+_dstr_rope_node* _dstr_rope_rotate_right(_dstr_rope_node* node) {
+
+    _dstr_rope_node* left = node->left;
+
+    node->left = left->right;
+    _dstr_rope_update(node);
+    left->right = node;
+    _dstr_rope_update(left);
+
+    return left;
+} // _dstr_rope_rotate_right
+
+// Children heights must not differ by more than 2.
+_dstr_rope_node* _dstr_rope_balance(_dstr_rope_node* node) {
+
+    int balance;
+
+    _dstr_rope_update(node);
+    balance = _dstr_rope_height(node->left) - _dstr_rope_height(node->right);
+
+    if (balance > 1) {
+        if (_dstr_rope_height(node->left->left) < _dstr_rope_height(node->left->right)) {
+            node->left = _dstr_rope_rotate_left(node->left);
+        }
+        return _dstr_rope_rotate_right(node);
+    }
+
+    if (balance < -1) {
+        if (_dstr_rope_height(node->right->right) < _dstr_rope_height(node->right->left)) {
+            node->right = _dstr_rope_rotate_right(node->right);
+        }
+        return _dstr_rope_rotate_left(node);
+    }
+
+    return node;
+} // _dstr_rope_balance
+
+// Concatenates 'left', 'node' and 'right' in O(|height(left) - height(right)|).
+_dstr_rope_node* _dstr_rope_join(_dstr_rope_node* left, _dstr_rope_node* node, _dstr_rope_node* right) {
+
+    int left_height = _dstr_rope_height(left);
+    int right_height = _dstr_rope_height(right);
+
+    if (left_height > right_height + 1) {
+        left->right = _dstr_rope_join(left->right, node, right);
+        return _dstr_rope_balance(left);
+    }
+
+    if (right_height > left_height + 1) {
+        right->left = _dstr_rope_join(left, node, right->left);
+        return _dstr_rope_balance(right);
+    }
+
+    node->left = left;
+    node->right = right;
+    _dstr_rope_update(node);
+
+    return node;
+} // _dstr_rope_join
+
+_dstr_rope_node* _dstr_rope_remove_first(_dstr_rope_node* node, _dstr_rope_node** rest) {
+
+    _dstr_rope_node* first;
+
+    if (!node->left) {
+        *rest = node->right;
+        return node;
+    }
+
+    first = _dstr_rope_remove_first(node->left, rest);
+    *rest = _dstr_rope_join(*rest, node, node->right);
+
+    return first;
+} // _dstr_rope_remove_first
+
+_dstr_rope_node* _dstr_rope_remove_last(_dstr_rope_node* node, _dstr_rope_node** rest) {
+
+    _dstr_rope_node* last;
+
+    if (!node->right) {
+        *rest = node->left;
+        return node;
+    }
+
+    last = _dstr_rope_remove_last(node->right, rest);
+    *rest = _dstr_rope_join(node->left, node, *rest);
+
+    return last;
+} // _dstr_rope_remove_last
+
+// Concatenates two trees, the chunks around the junction are merged if they fit in one chunk.
+_dstr_rope_node* _dstr_rope_merge(dstr_rope* rope, _dstr_rope_node* left, _dstr_rope_node* right) {
+
+    _dstr_rope_node* last;
+    const _dstr_rope_node* first;
+
+    if (!left) {
+        return right;
+    }
+
+    if (!right) {
+        return left;
+    }
+
+    last = _dstr_rope_remove_last(left, &left);
+
+    first = right;
+    while (first->left) {
+        first = first->left;
+    }
+
+    if (last->size + first->size <= DSTR_ROPE_CHUNK_SIZE) {
+        _dstr_rope_node* removed = _dstr_rope_remove_first(right, &right);
+        memcpy(last->data + last->size, removed->data, removed->size);
+        last->size += removed->size;
+        _dstr_rope_free_node(rope, removed);
+    }
+
+    return _dstr_rope_join(left, last, right);
+} // _dstr_rope_merge
+
+// Splits the tree in two: the 'pos' first chars and the remaining ones.
+void _dstr_rope_split(dstr_rope* rope, _dstr_rope_node* node, size_t pos, _dstr_rope_node** left, _dstr_rope_node** right) {
+
+    _dstr_rope_node* node_left;
+    _dstr_rope_node* node_right;
+    _dstr_rope_node* middle;
+    size_t left_total;
+
+    if (!node) {
+        *left = 0;
+        *right = 0;
+        return;
+    }
+
+    node_left = node->left;
+    node_right = node->right;
+    left_total = _dstr_rope_total(node_left);
+
+    if (pos <= left_total) {
+        _dstr_rope_split(rope, node_left, pos, left, &middle);
+        *right = _dstr_rope_join(middle, node, node_right);
+    } else if (pos >= left_total + node->size) {
+        _dstr_rope_split(rope, node_right, pos - left_total - node->size, &middle, right);
+        *left = _dstr_rope_join(node_left, node, middle);
+    } else {
+        // Split inside the chunk
+        size_t offset = pos - left_total;
+        _dstr_rope_node* tail = _dstr_rope_new_node(rope, node->data + offset, node->size - offset);
+        node->size = offset;
+        *left = _dstr_rope_join(node_left, node, 0);
+        *right = _dstr_rope_join(0, tail, node_right);
+    }
+} // _dstr_rope_split
+
+_dstr_rope_node* _dstr_rope_new_node(dstr_rope* rope, const dstr_char_t* data, size_t size) {
+
+    _dstr_rope_node* node = (_dstr_rope_node*)rope->allocator->alloc(rope->allocator->user_data, sizeof(_dstr_rope_node));
+    assert(node);
+    assert(size <= DSTR_ROPE_CHUNK_SIZE);
+
+    memcpy(node->data, data, size);
+    node->left = 0;
+    node->right = 0;
+    node->size = size;
+    node->total = size;
+    node->height = 1;
+
+    return node;
+} // _dstr_rope_new_node
+
+void _dstr_rope_free_node(dstr_rope* rope, _dstr_rope_node* node) {
+    rope->allocator->free(rope->allocator->user_data, node, sizeof(_dstr_rope_node));
+} // _dstr_rope_free_node
+
+void _dstr_rope_free_tree(dstr_rope* rope, _dstr_rope_node* node) {
+
+    // Recursion depth is bounded by the height of the tree.
+    while (node) {
+        _dstr_rope_node* right = node->right;
+        _dstr_rope_free_tree(rope, node->left);
+        _dstr_rope_free_node(rope, node);
+        node = right;
+    }
+} // _dstr_rope_free_tree
+
+//-------------------------------------------------------------------------
+// dstr_rope - Implementation - END
+//-------------------------------------------------------------------------
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // RE_DSTR_ROPE_H
@@ -0,0 +1,326 @@
+// dstr_tokenizer.h - v0.1 - kevreco - CC0 1.0 Licence (public domain)
+// Zero-copy split of strings, tokens point inside the input
+// https://github.com/kevreco/re_lib
+
+/*
+
+NOTES:
+=====
+
+- Depends on dstr.h
+- Tokens are views (dstr_view) of the input, nothing is allocated or copied.
+  The input must outlive the tokens.
+- Delimiters can be:
+   - a set of chars (a single char is a set of one char), see dstr_tokenizer_init_any.
+   - a string, see dstr_tokenizer_init_str.
+- Delimiters are not copied (except sets of chars), they must outlive the tokenizer.
+- Sets up to DSTR_TOKENIZER_SIMD_SET_SIZE chars are scanned with SSE2 (16 bytes) or AVX2 (32 bytes):
+   - Delimiter positions of a whole block are computed at once, then consumed one token at a time.
+   - Larger sets use a 256-bit table.
+- String delimiters are searched with the same function as dstr_find_dstr.
+- Options (to set before the first call to dstr_tokenizer_next):
+   - dstr_tokenizer_skip_empty: empty tokens are not returned.
+   - dstr_tokenizer_max_splits: after 'count' delimiters the rest of the input is the last token.
+- Unit tests are made in ./testsuite/
+
+CHANGES (DD/MM/YYYY):
+====================
+
+- 16/10/2026 (0.1) - First implementation
+
+EXAMPLE:
+=======
+
+    dstr_tokenizer tk;
+
+    dstr_tokenizer_init_char(&tk, dstr_data(&line), dstr_size(&line), ',');
+
+    while (dstr_tokenizer_next(&tk)) {
+        // tk.token is a view of the field
+        ...
+    }
+
+*/
+
+#ifndef RE_DSTR_TOKENIZER_H
+#define RE_DSTR_TOKENIZER_H
+
+#include "dstr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//-------------------------------------------------------------------------
+// dstr_tokenizer - API - BEGIN
+//-------------------------------------------------------------------------
+
+enum {
+    // Maximum size of a delimiter set scanned with SIMD
+    DSTR_TOKENIZER_SIMD_SET_SIZE = 8
+};
+
+typedef struct dstr_tokenizer {
+    // Current token, set by dstr_tokenizer_next
+    dstr_view token;
+
+    const dstr_char_t* cursor;      // Start of the next token, 0 when all tokens are returned
+    const dstr_char_t* end;
+
+    // String delimiter (not copied)
+    const dstr_char_t* delimiter;
+    size_t delimiter_size;
+
+    // Set of chars
+    int is_set;
+    size_t set_size;
+    dstr_char_t set_chars[DSTR_TOKENIZER_SIMD_SET_SIZE]; // Only used by small sets
+    unsigned char set_table[32];    // Bit 'c' is set if 'c' is in the set
+
+    int skip_empty;
+    size_t splits_left;             // DSTR_NPOS if there is no limit
+
+    // Delimiters found in the current SIMD block and not consumed yet
+    const dstr_char_t* block;
+    unsigned int block_mask;
+} dstr_tokenizer;
+
+// Splits on a single char.
+void dstr_tokenizer_init_char(dstr_tokenizer* tk, const dstr_char_t* data, size_t size, dstr_char_t delimiter);
+// Splits on any char of 'delimiters'.
+void dstr_tokenizer_init_any(dstr_tokenizer* tk, const dstr_char_t* data, size_t size, const dstr_char_t* delimiters, size_t delimiter_count);
+// Splits on a string ('delimiter' is not copied and must outlive the tokenizer).
+// An empty delimiter never matches, the whole input is a single token.
+void dstr_tokenizer_init_str(dstr_tokenizer* tk, const dstr_char_t* data, size_t size, const dstr_char_t* delimiter, size_t delimiter_size);
+void dstr_tokenizer_init_dstr(dstr_tokenizer* tk, const dstr* s, const dstr* delimiter);
+void dstr_tokenizer_init_view(dstr_tokenizer* tk, dstr_view v, dstr_view delimiter);
+
+// Empty tokens are not returned ("a,,b" gives "a" and "b").
+void dstr_tokenizer_skip_empty(dstr_tokenizer* tk, int skip);
+// At most 'count' delimiters are used, the rest of the input is returned as the last token.
+void dstr_tokenizer_max_splits(dstr_tokenizer* tk, size_t count);
+
+// Returns 1 and sets 'token', or returns 0 when there are no more tokens.
+int  dstr_tokenizer_next(dstr_tokenizer* tk);
+
+//-------------------------------------------------------------------------
+// dstr_tokenizer - API - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_tokenizer - Private - BEGIN
+//-------------------------------------------------------------------------
+
+void   _dstr_tokenizer_init(dstr_tokenizer* tk, const dstr_char_t* data, size_t size, const dstr_char_t* delimiter, size_t delimiter_size, int is_set);
+// Returns the next delimiter at or after 'cursor', or 0. Writes the delimiter size.
+const dstr_char_t* _dstr_tokenizer_find(dstr_tokenizer* tk, size_t* delimiter_size);
+const dstr_char_t* _dstr_tokenizer_find_in_set(dstr_tokenizer* tk);
+// Size of the delimiter starting at 'p', 0 if there is none.
+size_t _dstr_tokenizer_match(const dstr_tokenizer* tk, const dstr_char_t* p);
+
+//-------------------------------------------------------------------------
+// dstr_tokenizer - Private - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_tokenizer - Implementation - BEGIN
+//-------------------------------------------------------------------------
+
+void dstr_tokenizer_init_char(dstr_tokenizer* tk, const dstr_char_t* data, size_t size, dstr_char_t delimiter) {
+    _dstr_tokenizer_init(tk, data, size, &delimiter, 1, 1);
+} // dstr_tokenizer_init_char
+
+void dstr_tokenizer_init_any(dstr_tokenizer* tk, const dstr_char_t* data, size_t size, const dstr_char_t* delimiters, size_t delimiter_count) {
+    _dstr_tokenizer_init(tk, data, size, delimiters, delimiter_count, 1);
+} // dstr_tokenizer_init_any
+
+void dstr_tokenizer_init_str(dstr_tokenizer* tk, const dstr_char_t* data, size_t size, const dstr_char_t* delimiter, size_t delimiter_size) {
+    // A string of one char is a set of one char
+    _dstr_tokenizer_init(tk, data, size, delimiter, delimiter_size, delimiter_size == 1);
+} // dstr_tokenizer_init_str
+
+void dstr_tokenizer_init_dstr(dstr_tokenizer* tk, const dstr* s, const dstr* delimiter) {
+    dstr_tokenizer_init_str(tk, dstr_data(s), dstr_size(s), dstr_data(delimiter), dstr_size(delimiter));
+} // dstr_tokenizer_init_dstr
+
+void dstr_tokenizer_init_view(dstr_tokenizer* tk, dstr_view v, dstr_view delimiter) {
+    dstr_tokenizer_init_str(tk, v.data, v.size, delimiter.data, delimiter.size);
+} // dstr_tokenizer_init_view
+
+void dstr_tokenizer_skip_empty(dstr_tokenizer* tk, int skip) {
+    tk->skip_empty = skip;
+} // dstr_tokenizer_skip_empty
+
+void dstr_tokenizer_max_splits(dstr_tokenizer* tk, size_t count) {
+    tk->splits_left = count;
+} // dstr_tokenizer_max_splits
+
+int dstr_tokenizer_next(dstr_tokenizer* tk) {
+
+    while (tk->cursor) {
+
+        const dstr_char_t* found = 0;
+        size_t delimiter_size = 0;
+
+        if (tk->splits_left == 0) {
+            // The rest is the last token, leading delimiters would make empty tokens.
+            if (tk->skip_empty) {
+                while (tk->cursor < tk->end && (delimiter_size = _dstr_tokenizer_match(tk, tk->cursor))) {
+                    tk->cursor += delimiter_size;
+                }
+            }
+        } else {
+            found = _dstr_tokenizer_find(tk, &delimiter_size);
+        }
+
+        tk->token.data = tk->cursor;
+
+        if (found) {
+            tk->token.size = (size_t)(found - tk->cursor);
+            tk->cursor = found + delimiter_size;
+        } else {
+            tk->token.size = (size_t)(tk->end - tk->cursor);
+            tk->cursor = 0;
+        }
+
+        if (!tk->skip_empty || tk->token.size) {
+            if (found && tk->splits_left != DSTR_NPOS) {
+                --tk->splits_left;
+            }
+            return 1;
+        }
+    }
+
+    return 0;
+} // dstr_tokenizer_next
+
+void _dstr_tokenizer_init(dstr_tokenizer* tk, const dstr_char_t* data, size_t size, const dstr_char_t* delimiter, size_t delimiter_size, int is_set) {
+
+    size_t i;
+
+    tk->token = dstr_view_make(data, 0);
+    tk->cursor = data;
+    tk->end = data + size;
+    tk->delimiter = is_set ? 0 : delimiter;
+    tk->delimiter_size = is_set ? 0 : delimiter_size;
+    tk->is_set = is_set;
+    tk->set_size = is_set ? delimiter_size : 0;
+    tk->skip_empty = 0;
+    tk->splits_left = DSTR_NPOS;
+    tk->block = 0;
+    tk->block_mask = 0;
+
+    memset(tk->set_table, 0, sizeof(tk->set_table));
+    if (is_set) {
+        for (i = 0; i < delimiter_size; ++i) {
+            unsigned char c = (unsigned char)delimiter[i];
+            tk->set_table[c >> 3] |= (unsigned char)(1 << (c & 7));
+            if (i < DSTR_TOKENIZER_SIMD_SET_SIZE) {
+                tk->set_chars[i] = delimiter[i];
+            }
+        }
+    }
+} // _dstr_tokenizer_init
+
+const dstr_char_t* _dstr_tokenizer_find(dstr_tokenizer* tk, size_t* delimiter_size) {
+
+    if (tk->is_set) {
+        *delimiter_size = 1;
+        return _dstr_tokenizer_find_in_set(tk);
+    }
+
+    *delimiter_size = tk->delimiter_size;
+
+    return (const dstr_char_t*)_dstr_memory_find(tk->cursor, (size_t)(tk->end - tk->cursor), tk->delimiter, tk->delimiter_size);
+} // _dstr_tokenizer_find
+
+const dstr_char_t* _dstr_tokenizer_find_in_set(dstr_tokenizer* tk) {
+
+    const dstr_char_t* p = tk->cursor;
+
+#if defined(DSTR_AVX2) || defined(DSTR_SSE2)
+    if (tk->set_size <= DSTR_TOKENIZER_SIMD_SET_SIZE) {
+
+#if defined(DSTR_AVX2)
+        enum { BLOCK_SIZE = 32 };
+#else
+        enum { BLOCK_SIZE = 16 };
+#endif
+        size_t i;
+
+        for (;;) {
+
+            // Delimiters of the current block, the ones before the cursor are skipped tokens.
+            while (tk->block_mask) {
+                const dstr_char_t* found = tk->block + _dstr_bit_scan_forward(tk->block_mask);
+                tk->block_mask &= tk->block_mask - 1;
+                if (found >= p) {
+                    return found;
+                }
+            }
+
+            const dstr_char_t* next = tk->block ? tk->block + BLOCK_SIZE : p;
+            if (next < p) {
+                next = p;
+            }
+            if ((size_t)(tk->end - next) < BLOCK_SIZE) {
+                // Scalar tail
+                p = next;
+                break;
+            }
+
+#if defined(DSTR_AVX2)
+            const __m256i block = _mm256_loadu_si256((const __m256i*)next);
+            __m256i eq = _mm256_setzero_si256();
+            for (i = 0; i < tk->set_size; ++i) {
+                eq = _mm256_or_si256(eq, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(tk->set_chars[i])));
+            }
+            tk->block_mask = (unsigned int)_mm256_movemask_epi8(eq);
+#else
+            const __m128i block = _mm_loadu_si128((const __m128i*)next);
+            __m128i eq = _mm_setzero_si128();
+            for (i = 0; i < tk->set_size; ++i) {
+                eq = _mm_or_si128(eq, _mm_cmpeq_epi8(block, _mm_set1_epi8(tk->set_chars[i])));
+            }
+            tk->block_mask = (unsigned int)_mm_movemask_epi8(eq);
+#endif
+            tk->block = next;
+        }
+    }
+#endif
+
+    if (tk->set_size == 1) {
+        return (const dstr_char_t*)memchr(p, tk->set_chars[0], (size_t)(tk->end - p));
+    }
+
+    for (; p < tk->end; ++p) {
+        unsigned char c = (unsigned char)*p;
+        if (tk->set_table[c >> 3] & (1 << (c & 7))) {
+            return p;
+        }
+    }
+
+    return 0;
+} // _dstr_tokenizer_find_in_set
+
+size_t _dstr_tokenizer_match(const dstr_tokenizer* tk, const dstr_char_t* p) {
+
+    if (tk->is_set) {
+        unsigned char c = (unsigned char)*p;
+        return (tk->set_table[c >> 3] & (1 << (c & 7))) ? 1 : 0;
+    }
+
+    return tk->delimiter_size
+        && (size_t)(tk->end - p) >= tk->delimiter_size
+        && memcmp(p, tk->delimiter, tk->delimiter_size) == 0 ? tk->delimiter_size : 0;
+} // _dstr_tokenizer_match
+
+//-------------------------------------------------------------------------
+// dstr_tokenizer - Implementation - END
+//-------------------------------------------------------------------------
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // RE_DSTR_TOKENIZER_H
@@ -0,0 +1,457 @@
+// dstr_utf8.h - v0.1 - kevreco - CC0 1.0 Licence (public domain)
+// UTF-8 validation, code point counting and truncation for dstr
+// https://github.com/kevreco/re_lib
+
+/*
+
+NOTES:
+=====
+
+- Depends on dstr.h and stdint.h
+- Contents are validated against the Unicode definition of UTF-8 (Table 3-7):
+   - overlong forms, surrogates (U+D800 to U+DFFF) and code points above U+10FFFF are rejected.
+   - A '\0' byte is valid (it's U+0000).
+- dstr_utf8_validate:
+   - AVX2: lookup tables, 32 bytes per iteration, in the style of simdutf/simdjson
+     (Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte", 2021).
+   - Used when compiled with AVX2 (-mavx2, /arch:AVX2).
+   - With GCC and Clang on x86-64 it's also used if the CPU supports it (runtime check).
+   - Otherwise blocks of ASCII chars are skipped 16 (SSE2) or 8 bytes at a time,
+     and other sequences are checked one by one.
+- dstr_utf8_length and dstr_utf8_truncated_size count the bytes which are not continuation bytes,
+  16 bytes at a time with SSE2. They don't validate, use dstr_utf8_validate first if needed.
+- Define DSTR_NO_SIMD to only use the scalar implementations.
+- Unit tests are made in ./testsuite/
+
+CHANGES (DD/MM/YYYY):
+====================
+
+- 16/10/2026 (0.1) - First implementation
+
+EXAMPLE:
+=======
+
+    if (!dstr_utf8_validate_bytes(payload, payload_size)) {
+        return ERROR_INVALID_UTF8;
+    }
+    dstr_append_range(&s, payload, payload + payload_size);
+
+    // Keep the first 80 code points
+    dstr_utf8_truncate(&s, 80);
+
+*/
+
+#ifndef RE_DSTR_UTF8_H
+#define RE_DSTR_UTF8_H
+
+#include "dstr.h"
+#include <stdint.h> // uint64_t
+
+#if !defined(DSTR_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#if defined(__AVX2__)
+#define DSTR_UTF8_AVX2
+#elif defined(__GNUC__)
+#define DSTR_UTF8_AVX2_DISPATCH
+#endif
+#endif
+
+#if defined(DSTR_UTF8_AVX2) || defined(DSTR_UTF8_AVX2_DISPATCH)
+#include <immintrin.h> // AVX2
+#endif
+
+#if defined(DSTR_UTF8_AVX2_DISPATCH)
+#define _DSTR_UTF8_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define _DSTR_UTF8_AVX2_TARGET
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//-------------------------------------------------------------------------
+// dstr_utf8 - API - BEGIN
+//-------------------------------------------------------------------------
+
+// Returns 1 if the content is valid UTF-8, 0 otherwise.
+int    dstr_utf8_validate_bytes(const void* data, size_t size);
+int    dstr_utf8_validate(const dstr* s);
+
+// Number of code points.
+size_t dstr_utf8_length_bytes(const void* data, size_t size);
+size_t dstr_utf8_length(const dstr* s);
+
+// Size in bytes of the first 'count' code points, 'size' if there are less code points.
+// A sequence is never split.
+size_t dstr_utf8_truncated_size(const void* data, size_t size, size_t count);
+// Keeps the first 'count' code points.
+void   dstr_utf8_truncate(dstr* s, size_t count);
+
+//-------------------------------------------------------------------------
+// dstr_utf8 - API - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_utf8 - Private - BEGIN
+//-------------------------------------------------------------------------
+
+// Size of the valid sequence starting at 'p', 0 if it's not valid. 'size' is at least 1.
+size_t _dstr_utf8_sequence_size(const unsigned char* p, size_t size);
+int    _dstr_utf8_validate_scalar(const unsigned char* p, size_t size);
+unsigned int _dstr_utf8_popcount(unsigned int mask);
+#if defined(DSTR_UTF8_AVX2) || defined(DSTR_UTF8_AVX2_DISPATCH)
+int    _dstr_utf8_validate_avx2(const unsigned char* p, size_t size);
+#endif
+
+//-------------------------------------------------------------------------
+// dstr_utf8 - Private - END
+//-------------------------------------------------------------------------
+
+//-------------------------------------------------------------------------
+// dstr_utf8 - Implementation - BEGIN
+//-------------------------------------------------------------------------
+
+int dstr_utf8_validate_bytes(const void* data, size_t size) {
+
+    const unsigned char* p = (const unsigned char*)data;
+
+#if defined(DSTR_UTF8_AVX2)
+    return _dstr_utf8_validate_avx2(p, size);
+#elif defined(DSTR_UTF8_AVX2_DISPATCH)
+    // Relaxed atomics: threads may check the CPU at the same time, they store the same value.
+    static int has_avx2 = -1;
+    int supported = __atomic_load_n(&has_avx2, __ATOMIC_RELAXED);
+    if (supported < 0) {
+        supported = __builtin_cpu_supports("avx2") ? 1 : 0;
+        __atomic_store_n(&has_avx2, supported, __ATOMIC_RELAXED);
+    }
+    if (supported) {
+        return _dstr_utf8_validate_avx2(p, size);
+    }
+    return _dstr_utf8_validate_scalar(p, size);
+#else
+    return _dstr_utf8_validate_scalar(p, size);
+#endif
+} // dstr_utf8_validate_bytes
+
+int dstr_utf8_validate(const dstr* s) {
+    return dstr_utf8_validate_bytes(dstr_data(s), dstr_size(s));
+} // dstr_utf8_validate
+
+size_t dstr_utf8_length_bytes(const void* data, size_t size) {
+
+    const unsigned char* p = (const unsigned char*)data;
+    size_t count = 0;
+    size_t i = 0;
+
+#ifdef DSTR_SSE2
+    // Continuation bytes are the signed chars lower than -64
+    const __m128i last_continuation = _mm_set1_epi8(-65);
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(p + i));
+        count += _dstr_utf8_popcount((unsigned int)_mm_movemask_epi8(_mm_cmpgt_epi8(block, last_continuation)));
+    }
+#endif
+
+    for (; i < size; ++i) {
+        count += (p[i] & 0xC0) != 0x80;
+    }
+
+    return count;
+} // dstr_utf8_length_bytes
+
+size_t dstr_utf8_length(const dstr* s) {
+    return dstr_utf8_length_bytes(dstr_data(s), dstr_size(s));
+} // dstr_utf8_length
+
+size_t dstr_utf8_truncated_size(const void* data, size_t size, size_t count) {
+
+    const unsigned char* p = (const unsigned char*)data;
+    size_t i = 0;
+
+    // The result is the position of the code point 'count' (0-based), it's searched in blocks first.
+#ifdef DSTR_SSE2
+    const __m128i last_continuation = _mm_set1_epi8(-65);
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(p + i));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpgt_epi8(block, last_continuation));
+        unsigned int block_count = _dstr_utf8_popcount(mask);
+
+        if (block_count > count) {
+            // Drops the 'count' first code points of the block
+            for (; count; --count) {
+                mask &= mask - 1;
+            }
+            return i + _dstr_bit_scan_forward(mask);
+        }
+        count -= block_count;
+    }
+#endif
+
+    for (; i < size; ++i) {
+        if ((p[i] & 0xC0) != 0x80) {
+            if (!count) {
+                return i;
+            }
+            --count;
+        }
+    }
+
+    return size;
+} // dstr_utf8_truncated_size
+
+void dstr_utf8_truncate(dstr* s, size_t count) {
+
+    size_t size = dstr_size(s);
+    size_t truncated_size = dstr_utf8_truncated_size(dstr_data(s), size, count);
+
+    if (truncated_size < size) {
+        dstr_resize(s, truncated_size);
+    }
+} // dstr_utf8_truncate
+
+inline size_t _dstr_utf8_sequence_size(const unsigned char* p, size_t size) {
+
+    unsigned char c = p[0];
+    unsigned char low;
+    unsigned char high;
+
+    if (c < 0x80) {
+        return 1;
+    }
+    // Continuation bytes, and 0xC0 0xC1 which are always overlong
+    if (c < 0xC2) {
+        return 0;
+    }
+    if (c < 0xE0) {
+        return size >= 2 && (p[1] & 0xC0) == 0x80 ? 2 : 0;
+    }
+    if (c < 0xF0) {
+        // Overlong below U+0800, surrogates after 0xED
+        low = c == 0xE0 ? 0xA0 : 0x80;
+        high = c == 0xED ? 0x9F : 0xBF;
+        return size >= 3
+            && p[1] >= low && p[1] <= high
+            && (p[2] & 0xC0) == 0x80 ? 3 : 0;
+    }
+    if (c < 0xF5) {
+        // Overlong below U+10000, too large after U+10FFFF
+        low = c == 0xF0 ? 0x90 : 0x80;
+        high = c == 0xF4 ? 0x8F : 0xBF;
+        return size >= 4
+            && p[1] >= low && p[1] <= high
+            && (p[2] & 0xC0) == 0x80
+            && (p[3] & 0xC0) == 0x80 ? 4 : 0;
+    }
+
+    return 0;
+} // _dstr_utf8_sequence_size
+
+int _dstr_utf8_validate_scalar(const unsigned char* p, size_t size) {
+
+    size_t i = 0;
+
+    while (i < size) {
+
+        // Skips ASCII blocks
+#ifdef DSTR_SSE2
+        if (i + 16 <= size && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(p + i)))) {
+            i += 16;
+            continue;
+        }
+#else
+        if (i + 8 <= size) {
+            uint64_t block;
+            memcpy(&block, p + i, 8);
+            if (!(block & 0x8080808080808080ull)) {
+                i += 8;
+                continue;
+            }
+        }
+#endif
+
+        size_t sequence_size = _dstr_utf8_sequence_size(p + i, size - i);
+        if (!sequence_size) {
+            return 0;
+        }
+        i += sequence_size;
+    }
+
+    return 1;
+} // _dstr_utf8_validate_scalar
+
+inline unsigned int _dstr_utf8_popcount(unsigned int mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned int)__builtin_popcount(mask);
+#else
+    unsigned int count = 0;
+    for (; mask; mask &= mask - 1) {
+        ++count;
+    }
+    return count;
+#endif
+} // _dstr_utf8_popcount
+
+#if defined(DSTR_UTF8_AVX2) || defined(DSTR_UTF8_AVX2_DISPATCH)
+
+// Error bits of the special cases, a pair of bytes is invalid if one bit is set in the three lookups.
+#define _DSTR_UTF8_TOO_SHORT   (1 << 0) // 11______ 0_______ or 11______ 11______
+#define _DSTR_UTF8_TOO_LONG    (1 << 1) // 0_______ 10______
+#define _DSTR_UTF8_OVERLONG_3  (1 << 2) // 11100000 100_____
+#define _DSTR_UTF8_TOO_LARGE   (1 << 3) // 11110100 1001____, 11110100 101_____, 11110101+ ________
+#define _DSTR_UTF8_SURROGATE   (1 << 4) // 11101101 101_____
+#define _DSTR_UTF8_OVERLONG_2  (1 << 5) // 1100000_ 10______
+#define _DSTR_UTF8_TOO_LARGE_1000 (1 << 6) // 11110101+ 1000____
+#define _DSTR_UTF8_OVERLONG_4  (1 << 6) // 11110000 1000____
+#define _DSTR_UTF8_TWO_CONTS   (1 << 7) // 10______ 10______
+#define _DSTR_UTF8_CARRY (_DSTR_UTF8_TOO_SHORT | _DSTR_UTF8_TOO_LONG | _DSTR_UTF8_TWO_CONTS)
+
+// Entries are casted to char, values above 127 would not fit.
+#define _DSTR_UTF8_TABLE(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o, p) \
+    _mm256_setr_epi8((char)(a), (char)(b), (char)(c), (char)(d), (char)(e), (char)(f), (char)(g), (char)(h), \
+                     (char)(i), (char)(j), (char)(k), (char)(l), (char)(m), (char)(n), (char)(o), (char)(p), \
+                     (char)(a), (char)(b), (char)(c), (char)(d), (char)(e), (char)(f), (char)(g), (char)(h), \
+                     (char)(i), (char)(j), (char)(k), (char)(l), (char)(m), (char)(n), (char)(o), (char)(p))
+
+// Bytes of 'input' shifted by 'N' (1 to 3), the first ones come from the end of 'previous'.
+#define _DSTR_UTF8_PREV(input, previous, N) \
+    _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - (N))
+
+_DSTR_UTF8_AVX2_TARGET
+int _dstr_utf8_validate_avx2(const unsigned char* p, size_t size) {
+
+    const __m256i byte_1_high_table = _DSTR_UTF8_TABLE(
+        // 0_______ ________ ASCII
+        _DSTR_UTF8_TOO_LONG, _DSTR_UTF8_TOO_LONG, _DSTR_UTF8_TOO_LONG, _DSTR_UTF8_TOO_LONG,
+        _DSTR_UTF8_TOO_LONG, _DSTR_UTF8_TOO_LONG, _DSTR_UTF8_TOO_LONG, _DSTR_UTF8_TOO_LONG,
+        // 10______ ________ continuation
+        _DSTR_UTF8_TWO_CONTS, _DSTR_UTF8_TWO_CONTS, _DSTR_UTF8_TWO_CONTS, _DSTR_UTF8_TWO_CONTS,
+        // 1100____ ________ two bytes lead
+        _DSTR_UTF8_TOO_SHORT | _DSTR_UTF8_OVERLONG_2,
+        // 1101____ ________ two bytes lead
+        _DSTR_UTF8_TOO_SHORT,
+        // 1110____ ________ three bytes lead
+        _DSTR_UTF8_TOO_SHORT | _DSTR_UTF8_OVERLONG_3 | _DSTR_UTF8_SURROGATE,
+        // 1111____ ________ four bytes lead
+        _DSTR_UTF8_TOO_SHORT | _DSTR_UTF8_TOO_LARGE | _DSTR_UTF8_TOO_LARGE_1000 | _DSTR_UTF8_OVERLONG_4);
+
+    const __m256i byte_1_low_table = _DSTR_UTF8_TABLE(
+        // ____0000 ________
+        _DSTR_UTF8_CARRY | _DSTR_UTF8_OVERLONG_3 | _DSTR_UTF8_OVERLONG_2 | _DSTR_UTF8_OVERLONG_4,
+        // ____0001 ________
+        _DSTR_UTF8_CARRY | _DSTR_UTF8_OVERLONG_2,
+        // ____001_ ________
+        _DSTR_UTF8_CARRY,
+        _DSTR_UTF8_CARRY,
+        // ____0100 ________
+        _DSTR_UTF8_CARRY | _DSTR_UTF8_TOO_LARGE,
+        // ____0101 ________ to ____1100 ________
+        _DSTR_UTF8_CARRY | _DSTR_UTF8_TOO_LARGE | _DSTR_UTF8_TOO_LARGE_1000,
+        _DSTR_UTF8_CARRY | _DSTR_UTF8_TOO_LARGE | _DSTR_UTF8_TOO_LARGE_1000,
+        _DSTR_UTF8_CARRY | _DSTR_UTF8_TOO_LARGE | _DSTR_UTF8_TOO_LARGE_1000,
+        _DSTR_UTF8_CARRY | _DSTR_UTF8_TOO_LARGE | _DSTR_UTF8_TOO_LARGE_1000,
+        _DSTR_UTF8_CARRY | _DSTR_UTF8_TOO_LARGE | _DSTR_UTF8_TOO_LARGE_1000,
+        _DSTR_UTF8_CARRY | _DSTR_UTF8_TOO_LARGE | _DSTR_UTF8_TOO_LARGE_1000,
+        _DSTR_UTF8_CARRY | _DSTR_UTF8_TOO_LARGE | _DSTR_UTF8_TOO_LARGE_1000,
+        _DSTR_UTF8_CARRY | _DSTR_UTF8_TOO_LARGE | _DSTR_UTF8_TOO_LARGE_1000,
+        // ____1101 ________
+        _DSTR_UTF8_CARRY | _DSTR_UTF8_TOO_LARGE | _DSTR_UTF8_TOO_LARGE_1000 | _DSTR_UTF8_SURROGATE,
+        // ____111_ ________
+        _DSTR_UTF8_CARRY | _DSTR_UTF8_TOO_LARGE | _DSTR_UTF8_TOO_LARGE_1000,
+        _DSTR_UTF8_CARRY | _DSTR_UTF8_TOO_LARGE | _DSTR_UTF8_TOO_LARGE_1000);
+
+    const __m256i byte_2_high_table = _DSTR_UTF8_TABLE(
+        // ________ 0_______ ASCII
+        _DSTR_UTF8_TOO_SHORT, _DSTR_UTF8_TOO_SHORT, _DSTR_UTF8_TOO_SHORT, _DSTR_UTF8_TOO_SHORT,
+        _DSTR_UTF8_TOO_SHORT, _DSTR_UTF8_TOO_SHORT, _DSTR_UTF8_TOO_SHORT, _DSTR_UTF8_TOO_SHORT,
+        // ________ 1000____
+        _DSTR_UTF8_TOO_LONG | _DSTR_UTF8_OVERLONG_2 | _DSTR_UTF8_TWO_CONTS | _DSTR_UTF8_OVERLONG_3 | _DSTR_UTF8_TOO_LARGE_1000 | _DSTR_UTF8_OVERLONG_4,
+        // ________ 1001____
+        _DSTR_UTF8_TOO_LONG | _DSTR_UTF8_OVERLONG_2 | _DSTR_UTF8_TWO_CONTS | _DSTR_UTF8_OVERLONG_3 | _DSTR_UTF8_TOO_LARGE,
+        // ________ 101_____
+        _DSTR_UTF8_TOO_LONG | _DSTR_UTF8_OVERLONG_2 | _DSTR_UTF8_TWO_CONTS | _DSTR_UTF8_SURROGATE | _DSTR_UTF8_TOO_LARGE,
+        _DSTR_UTF8_TOO_LONG | _DSTR_UTF8_OVERLONG_2 | _DSTR_UTF8_TWO_CONTS | _DSTR_UTF8_SURROGATE | _DSTR_UTF8_TOO_LARGE,
+        // ________ 11______
+        _DSTR_UTF8_TOO_SHORT, _DSTR_UTF8_TOO_SHORT, _DSTR_UTF8_TOO_SHORT, _DSTR_UTF8_TOO_SHORT);
+
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+    // A block ending with these bytes (or greater) has an incomplete sequence.
+    const __m256i incomplete_max = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+
+    __m256i previous = _mm256_setzero_si256();
+    __m256i previous_incomplete = _mm256_setzero_si256();
+    __m256i error = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 32 <= size; i += 32) {
+
+        __m256i input = _mm256_loadu_si256((const __m256i*)(p + i));
+
+        if (!_mm256_movemask_epi8(input)) {
+            // ASCII block, only the end of the previous block has to be checked.
+            error = _mm256_or_si256(error, previous_incomplete);
+        } else {
+            __m256i prev1 = _DSTR_UTF8_PREV(input, previous, 1);
+
+            // Errors between pairs of bytes
+            __m256i byte_1_high = _mm256_shuffle_epi8(byte_1_high_table, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+            __m256i byte_1_low  = _mm256_shuffle_epi8(byte_1_low_table, _mm256_and_si256(prev1, low_nibble));
+            __m256i byte_2_high = _mm256_shuffle_epi8(byte_2_high_table, _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble));
+            __m256i special_cases = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+            // Third and fourth bytes must be continuations: only 111_____ and 1111____ leads reach 0x80.
+            __m256i prev2 = _DSTR_UTF8_PREV(input, previous, 2);
+            __m256i prev3 = _DSTR_UTF8_PREV(input, previous, 3);
+            __m256i is_third_byte  = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+            __m256i is_fourth_byte = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+            __m256i must_be_continuation = _mm256_and_si256(_mm256_or_si256(is_third_byte, is_fourth_byte), _mm256_set1_epi8((char)0x80));
+
+            // Two continuations are expected there, it cancels the TWO_CONTS bit.
+            error = _mm256_or_si256(error, _mm256_xor_si256(must_be_continuation, special_cases));
+        }
+
+        previous_incomplete = _mm256_subs_epu8(input, incomplete_max);
+        previous = input;
+    }
+
+    if (!_mm256_testz_si256(error, error)) {
+        return 0;
+    }
+
+    // The last sequence of the blocks may continue in the tail, restart from its lead byte.
+    if (i) {
+        size_t k;
+        for (k = 1; k <= 3; ++k) {
+            unsigned char c = p[i - k];
+            if (c >= 0xC0) {
+                i -= k;
+                break;
+            }
+            if (c < 0x80) {
+                break;
+            }
+        }
+    }
+
+    return _dstr_utf8_validate_scalar(p + i, size - i);
+} // _dstr_utf8_validate_avx2
+
+#undef _DSTR_UTF8_PREV
+#undef _DSTR_UTF8_TABLE
+
+#endif // DSTR_UTF8_AVX2 || DSTR_UTF8_AVX2_DISPATCH
+
+//-------------------------------------------------------------------------
+// dstr_utf8 - Implementation - END
+//-------------------------------------------------------------------------
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // RE_DSTR_UTF8_H
@@ -0,0 +1,162 @@
+#include "string.h"
+#include "assert.h"
+
+#include "../dstr_builder.h"
+#include "../runit.h"
+
+#if !defined(_WIN32)
+#include <unistd.h> // pipe, read, close
+#endif
+
+// Tests
+void dstr_builder_simple_test();
+void dstr_builder_many_fragments_test();
+void dstr_builder_writev_test();
+
+void dstr_builder_testsuite() {
+
+    printf("dstr_builder_testsuite\n");
+
+    dstr_builder_simple_test();
+    dstr_builder_many_fragments_test();
+    dstr_builder_writev_test();
+}
+
+void dstr_builder_simple_test() {
+
+    printf("dstr_builder_simple_test\n");
+
+    {
+        dstr_builder builder;
+        const char* header = "Content-Length: ";
+        dstr small = dstr_make_from_str("small");
+        dstr large = dstr_make_from_str("a string which is too large to be stored inline");
+        const char* large_data = dstr_data(&large);
+        dstr s;
+        const dstr_iovec* iovecs;
+        size_t count;
+
+        dstr_builder_init(&builder);
+        dstr_init(&s);
+
+        dstr_builder_append_str_ref(&builder, header);
+        dstr_builder_append_copy(&builder, "42", 2);
+        dstr_builder_append_copy(&builder, "\r\n", 2);
+        dstr_builder_append_dstr(&builder, &small);
+        dstr_builder_append_str_ref(&builder, "");
+        dstr_builder_append_dstr(&builder, &large);
+
+        RUNIT_ASSERT(dstr_empty(&small));
+        RUNIT_ASSERT(dstr_empty(&large));
+        RUNIT_ASSERT(dstr_builder_fragment_count(&builder) == 4);
+        RUNIT_ASSERT(dstr_builder_size(&builder) == 16 + 4 + 5 + 47);
+
+        iovecs = dstr_builder_iovecs(&builder, &count);
+
+        RUNIT_ASSERT(count == 4);
+        // Borrowed and owned fragments are not copied
+        RUNIT_ASSERT(iovecs[0].iov_base == (void*)header && iovecs[0].iov_len == 16);
+        RUNIT_ASSERT(iovecs[1].iov_len == 4 && memcmp(iovecs[1].iov_base, "42\r\n", 4) == 0);
+        RUNIT_ASSERT(iovecs[2].iov_len == 5 && memcmp(iovecs[2].iov_base, "small", 5) == 0);
+        RUNIT_ASSERT(iovecs[3].iov_base == (void*)large_data && iovecs[3].iov_len == 47);
+
+        dstr_builder_flatten(&builder, &s);
+        RUNIT_ASSERT(dstr_compare_str(&s, "Content-Length: 42\r\nsmalla string which is too large to be stored inline") == 0);
+
+        // Reuse
+        dstr_builder_reset(&builder);
+        RUNIT_ASSERT(dstr_builder_size(&builder) == 0);
+        RUNIT_ASSERT(dstr_builder_fragment_count(&builder) == 0);
+
+        dstr_builder_append_copy(&builder, "x", 1);
+        dstr_builder_flatten(&builder, &s);
+        RUNIT_ASSERT(dstr_compare_str(&s, "x") == 0);
+
+        dstr_builder_clear(&builder);
+        dstr_clear(&small);
+        dstr_clear(&large);
+        dstr_clear(&s);
+    }
+}
+
+void dstr_builder_many_fragments_test() {
+
+    printf("dstr_builder_many_fragments_test\n");
+
+    {
+        dstr_builder builder;
+        dstr expected;
+        dstr s;
+        const dstr_iovec* iovecs;
+        size_t count;
+        size_t total = 0;
+        size_t i;
+
+        dstr_builder_init(&builder);
+        dstr_init(&expected);
+        dstr_init(&s);
+
+        // Owned and copied data move while the builder grows
+        for (i = 0; i < 500; ++i) {
+            dstr piece = dstr_make_from_nchar(i % 40 + 1, (char)('a' + i % 26));
+            dstr_append_dstr(&expected, &piece);
+            dstr_builder_append_dstr(&builder, &piece);
+            dstr_clear(&piece);
+
+            dstr_builder_append_copy(&builder, "-", 1);
+            dstr_append_str(&expected, "-");
+
+            dstr_builder_append_str_ref(&builder, "|");
+            dstr_append_str(&expected, "|");
+        }
+
+        iovecs = dstr_builder_iovecs(&builder, &count);
+        RUNIT_ASSERT(count == 1500);
+
+        for (i = 0; i < count; ++i) {
+            RUNIT_ASSERT(memcmp(iovecs[i].iov_base, dstr_data(&expected) + total, iovecs[i].iov_len) == 0);
+            total += iovecs[i].iov_len;
+        }
+        RUNIT_ASSERT(total == dstr_size(&expected));
+
+        dstr_builder_flatten(&builder, &s);
+        RUNIT_ASSERT(dstr_compare_dstr(&s, &expected) == 0);
+
+        dstr_builder_clear(&builder);
+        dstr_clear(&expected);
+        dstr_clear(&s);
+    }
+}
+
+void dstr_builder_writev_test() {
+
+    printf("dstr_builder_writev_test\n");
+
+#if !defined(_WIN32)
+    {
+        dstr_builder builder;
+        dstr body = dstr_make_from_str("<html>body</html>");
+        const dstr_iovec* iovecs;
+        size_t count;
+        char buffer[128];
+        int fds[2];
+
+        RUNIT_ASSERT(pipe(fds) == 0);
+
+        dstr_builder_init(&builder);
+        dstr_builder_append_str_ref(&builder, "HTTP/1.1 200 OK\r\n\r\n");
+        dstr_builder_append_dstr(&builder, &body);
+
+        iovecs = dstr_builder_iovecs(&builder, &count);
+
+        RUNIT_ASSERT(writev(fds[1], iovecs, (int)count) == (ssize_t)dstr_builder_size(&builder));
+        RUNIT_ASSERT(read(fds[0], buffer, sizeof(buffer)) == (ssize_t)dstr_builder_size(&builder));
+        RUNIT_ASSERT(memcmp(buffer, "HTTP/1.1 200 OK\r\n\r\n<html>body</html>", dstr_builder_size(&builder)) == 0);
+
+        dstr_builder_clear(&builder);
+        dstr_clear(&body);
+        close(fds[0]);
+        close(fds[1]);
+    }
+#endif
+}
@@ -0,0 +1,143 @@
+#include "string.h"
+#include "assert.h"
+
+#include "../dstr_cache.h"
+#include "../runit.h"
+
+// Tests
+void dstr_cache_reuse_test();
+void dstr_cache_limits_test();
+
+void dstr_cache_testsuite() {
+
+    printf("dstr_cache_testsuite\n");
+
+    dstr_cache_reuse_test();
+    dstr_cache_limits_test();
+}
+
+void dstr_cache_reuse_test() {
+
+    printf("dstr_cache_reuse_test\n");
+
+    // Temporary strings reuse the same buffers
+    {
+        dstr_cache_stats stats;
+        const dstr_allocator* previous = dstr_get_thread_allocator();
+        int i;
+
+        dstr_cache_enable();
+        dstr_cache_reset_stats();
+        RUNIT_ASSERT(dstr_get_thread_allocator() == &dstr_cache_allocator);
+
+        for (i = 0; i < 100; ++i) {
+            dstr tmp = dstr_make_from_str("a temporary string, too large to be inline");
+            dstr_clear(&tmp);
+        }
+
+        dstr_cache_get_stats(&stats);
+        RUNIT_ASSERT(stats.misses == 1);
+        RUNIT_ASSERT(stats.hits == 99);
+        RUNIT_ASSERT(stats.cached_blocks == 1);
+        RUNIT_ASSERT(stats.cached_bytes == 64);
+
+        // Growth goes through the size classes
+        {
+            dstr s = dstr_make();
+            for (i = 0; i < 1000; ++i) {
+                dstr_append_char(&s, (char)('a' + i % 26));
+            }
+            RUNIT_ASSERT(dstr_size(&s) == 1000);
+            RUNIT_ASSERT(dstr_get(&s, 999) == 'a' + 999 % 26);
+            dstr_clear(&s);
+        }
+
+        dstr_cache_disable();
+        RUNIT_ASSERT(dstr_get_thread_allocator() == previous);
+
+        dstr_cache_get_stats(&stats);
+        RUNIT_ASSERT(stats.cached_blocks == 0);
+        RUNIT_ASSERT(stats.cached_bytes == 0);
+    }
+
+    // Released after the cache is disabled, the block goes back to malloc
+    {
+        dstr_cache_stats stats;
+        dstr s;
+
+        dstr_cache_enable();
+        s = dstr_make_from_str("allocated by the cache, released without it");
+        dstr_cache_disable();
+
+        dstr_clear(&s);
+        dstr_cache_get_stats(&stats);
+        RUNIT_ASSERT(stats.cached_blocks == 0);
+    }
+
+    // Realloc keeps the content
+    {
+        void* p = dstr_cache_allocator.alloc(0, 40);
+        memset(p, 'x', 40);
+
+        p = dstr_cache_allocator.realloc(0, p, 40, 50);
+        RUNIT_ASSERT(((char*)p)[39] == 'x');
+
+        p = dstr_cache_allocator.realloc(0, p, 50, 10000000);
+        RUNIT_ASSERT(((char*)p)[39] == 'x');
+
+        p = dstr_cache_allocator.realloc(0, p, 10000000, 100);
+        RUNIT_ASSERT(((char*)p)[39] == 'x');
+
+        dstr_cache_allocator.free(0, p, 100);
+    }
+}
+
+void dstr_cache_limits_test() {
+
+    printf("dstr_cache_limits_test\n");
+
+    {
+        dstr_cache_stats stats;
+        dstr strs[10];
+        int i;
+
+        dstr_cache_enable();
+        dstr_cache_set_limits(4, 1024);
+
+        for (i = 0; i < 10; ++i) {
+            strs[i] = dstr_make_reserve(100);
+        }
+        for (i = 0; i < 10; ++i) {
+            dstr_clear(&strs[i]);
+        }
+
+        // Limited by the class
+        dstr_cache_get_stats(&stats);
+        RUNIT_ASSERT(stats.cached_blocks == 4);
+        RUNIT_ASSERT(stats.cached_bytes == 4 * 128);
+
+        // Limited by the thread
+        for (i = 0; i < 10; ++i) {
+            strs[i] = dstr_make_reserve(300);
+        }
+        for (i = 0; i < 10; ++i) {
+            dstr_clear(&strs[i]);
+        }
+        dstr_cache_get_stats(&stats);
+        RUNIT_ASSERT(stats.cached_bytes == 4 * 128 + 512);
+
+        // Lower limits release cached blocks
+        dstr_cache_set_class_limit(100, 1);
+        dstr_cache_get_stats(&stats);
+        RUNIT_ASSERT(stats.cached_bytes == 128 + 512);
+
+        // Large blocks are never cached
+        dstr_cache_set_limits(DSTR_CACHE_DEFAULT_CLASS_LIMIT, DSTR_CACHE_DEFAULT_THREAD_LIMIT);
+        strs[0] = dstr_make_reserve(2 * 1024 * 1024);
+        dstr_clear(&strs[0]);
+        dstr_cache_get_stats(&stats);
+        RUNIT_ASSERT(stats.cached_bytes == 128 + 512);
+
+        dstr_cache_disable();
+    }
+}
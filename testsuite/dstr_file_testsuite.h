@@ -0,0 +1,109 @@
+#include "string.h"
+#include "assert.h"
+
+#include "../dstr_file.h"
+#include "../runit.h"
+
+// Helpers
+int dstr_file_write_test_file(const char* filename, size_t size);
+
+// Tests
+void dstr_map_file_test();
+
+void dstr_file_testsuite() {
+
+    printf("dstr_file_testsuite\n");
+
+    dstr_map_file_test();
+}
+
+// Writes 'size' chars from 'a' to 'z'
+int dstr_file_write_test_file(const char* filename, size_t size) {
+
+    FILE* f = fopen(filename, "wb");
+    size_t i;
+
+    if (!f) {
+        return 0;
+    }
+    for (i = 0; i < size; ++i) {
+        fputc('a' + (int)(i % 26), f);
+    }
+    fclose(f);
+
+    return 1;
+}
+
+void dstr_map_file_test() {
+
+    printf("dstr_map_file_test\n");
+
+    // Sizes around page boundaries, the content is always '\0' terminated
+    {
+        const char* filename = "dstr_file_test.tmp";
+        size_t sizes[] = { 0, 1, 26, 4095, 4096, 4097, 8192, 65536, 100000 };
+        int hints[] = { 0, DSTR_FILE_SEQUENTIAL, DSTR_FILE_WILLNEED, DSTR_FILE_SEQUENTIAL | DSTR_FILE_WILLNEED, DSTR_FILE_RANDOM };
+        size_t i;
+
+        for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+            dstr_mapped_file file;
+            dstr_view v;
+            size_t k;
+            int all_equal = 1;
+
+            RUNIT_ASSERT(dstr_file_write_test_file(filename, sizes[i]));
+            RUNIT_ASSERT(dstr_map_file(&file, filename, hints[i % 5]));
+
+            v = dstr_mapped_file_view(&file);
+            RUNIT_ASSERT(v.size == sizes[i]);
+            RUNIT_ASSERT(v.data[v.size] == '\0');
+
+            for (k = 0; k < v.size; ++k) {
+                all_equal &= v.data[k] == 'a' + (int)(k % 26);
+            }
+            RUNIT_ASSERT(all_equal);
+
+            dstr_unmap_file(&file);
+            RUNIT_ASSERT(dstr_mapped_file_view(&file).size == 0);
+        }
+
+        remove(filename);
+    }
+
+    // Read-only dstr
+    {
+        const char* filename = "dstr_file_test.tmp";
+        dstr_mapped_file file;
+        dstr copy;
+
+        RUNIT_ASSERT(dstr_file_write_test_file(filename, 52));
+        RUNIT_ASSERT(dstr_map_file(&file, filename, DSTR_FILE_SEQUENTIAL));
+
+        {
+            dstr_ref ref = dstr_mapped_file_ref(&file);
+
+            RUNIT_ASSERT(dstr_size(&ref) == 52);
+            RUNIT_ASSERT(dstr_find_view(&ref, 0, dstr_view_make_from_str("xyzab")) == 23);
+            RUNIT_ASSERT(dstr_compare_str(&ref, "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz") == 0);
+
+            // Copies are owned and can be modified
+            copy = dstr_make_from_dstr(&ref);
+            dstr_to_upper(&copy);
+            RUNIT_ASSERT(dstr_starts_with(&copy, dstr_view_make_from_str("ABC")));
+            RUNIT_ASSERT(dstr_starts_with(&ref, dstr_view_make_from_str("abc")));
+        }
+
+        dstr_clear(&copy);
+        dstr_unmap_file(&file);
+        remove(filename);
+    }
+
+    // Missing file
+    {
+        dstr_mapped_file file;
+
+        RUNIT_ASSERT(!dstr_map_file(&file, "dstr_file_test_missing.tmp", 0));
+        RUNIT_ASSERT(dstr_mapped_file_view(&file).size == 0);
+        dstr_unmap_file(&file);
+    }
+}
@@ -0,0 +1,155 @@
+#include "string.h"
+#include "assert.h"
+
+#include "../dstr_hash.h"
+#include "../runit.h"
+
+// Tests
+void dstr_hash_vectors_test();
+void dstr_hash_streaming_test();
+void dstr_crc32c_test();
+
+void dstr_hash_testsuite() {
+
+    printf("dstr_hash_testsuite\n");
+
+    dstr_hash_vectors_test();
+    dstr_hash_streaming_test();
+    dstr_crc32c_test();
+}
+
+#define HASH_U64(high, low) (((uint64_t)(high) << 32) | (uint64_t)(low))
+
+// Reference values of wyhash (final version 4), the seed is the index of the message.
+void dstr_hash_vectors_test() {
+
+    printf("dstr_hash_vectors_test\n");
+
+    {
+        const char* messages[] = {
+            "",
+            "a",
+            "abc",
+            "message digest",
+            "abcdefghijklmnopqrstuvwxyz",
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+            "12345678901234567890123456789012345678901234567890123456789012345678901234567890"
+        };
+        uint64_t expected[] = {
+            HASH_U64(0x0409638e, 0xe2bde459),
+            HASH_U64(0xa8412d09, 0x1b5fe0a9),
+            HASH_U64(0x32dd92e4, 0xb2915153),
+            HASH_U64(0x86191240, 0x89a3a16b),
+            HASH_U64(0x7a43afb6, 0x1d7f5f40),
+            HASH_U64(0xff42329b, 0x90e50d58),
+            HASH_U64(0xc39cab13, 0xb115aad3)
+        };
+        size_t i;
+
+        for (i = 0; i < 7; ++i) {
+            RUNIT_ASSERT(dstr_hash_bytes(messages[i], strlen(messages[i]), i) == expected[i]);
+        }
+    }
+
+    {
+        dstr s = dstr_make_from_str("Content-Type");
+        RUNIT_ASSERT(dstr_hash(&s) == dstr_hash_str("Content-Type"));
+        RUNIT_ASSERT(dstr_hash(&s) == dstr_hash_bytes("Content-Type", 12, 0));
+        RUNIT_ASSERT(dstr_hash(&s) != dstr_hash_bytes("Content-Type", 12, 1));
+        RUNIT_ASSERT(dstr_hash(&s) != dstr_hash_str("Content-Typf"));
+        RUNIT_ASSERT(dstr_hash(&s) == dstr_hash_view(dstr_view_prefix(dstr_view_make_from_str("Content-Type: text/html"), 12)));
+        dstr_clear(&s);
+    }
+}
+
+// Streaming gives the same result as one call, whatever the piece sizes.
+void dstr_hash_streaming_test() {
+
+    printf("dstr_hash_streaming_test\n");
+
+    enum {
+        MAX_SIZE = 300
+    };
+
+    unsigned char data[MAX_SIZE];
+    size_t size;
+    size_t i;
+    int ok = 1;
+
+    for (i = 0; i < MAX_SIZE; ++i) {
+        data[i] = (unsigned char)(i * 131 + 7);
+    }
+
+    for (size = 0; size <= MAX_SIZE; ++size) {
+
+        uint64_t expected = dstr_hash_bytes(data, size, 42);
+        size_t step;
+
+        for (step = 1; step <= 70; step += 3) {
+
+            dstr_hash_state state;
+            size_t pos = 0;
+
+            dstr_hash_begin(&state, 42);
+
+            while (pos < size) {
+                size_t count = size - pos < step ? size - pos : step;
+                dstr_hash_update(&state, data + pos, count);
+                pos += count;
+            }
+
+            ok = ok && dstr_hash_end(&state) == expected;
+        }
+
+        // One piece, then an empty one
+        {
+            dstr_hash_state state;
+            dstr_hash_begin(&state, 42);
+            dstr_hash_update(&state, data, size);
+            dstr_hash_update(&state, data, 0);
+            ok = ok && dstr_hash_end(&state) == expected;
+        }
+    }
+
+    RUNIT_ASSERT(ok);
+}
+
+void dstr_crc32c_test() {
+
+    printf("dstr_crc32c_test\n");
+
+    {
+        dstr s = dstr_make_from_str("123456789");
+
+        RUNIT_ASSERT(dstr_crc32c(0, "", 0) == 0);
+        RUNIT_ASSERT(dstr_crc32c(0, "123456789", 9) == 0xE3069283u);
+        RUNIT_ASSERT(dstr_crc32c_dstr(&s) == 0xE3069283u);
+        RUNIT_ASSERT(_dstr_crc32c_table(0, (const unsigned char*)"123456789", 9) == 0xE3069283u);
+
+        // Continued CRC
+        RUNIT_ASSERT(dstr_crc32c(dstr_crc32c(0, "1234", 4), "56789", 5) == 0xE3069283u);
+
+        dstr_clear(&s);
+    }
+
+    // Hardware and table implementations give the same result
+    {
+        enum {
+            SIZE = 1000
+        };
+
+        unsigned char data[SIZE];
+        size_t i;
+        int ok = 1;
+
+        for (i = 0; i < SIZE; ++i) {
+            data[i] = (unsigned char)(i * 7 + i / 3);
+        }
+
+        for (i = 0; i < SIZE; i += 7) {
+            ok = ok && dstr_crc32c(0, data + (i % 5), SIZE - i - (i % 5)) == _dstr_crc32c_table(0, data + (i % 5), SIZE - i - (i % 5));
+        }
+
+        RUNIT_ASSERT(ok);
+    }
+}
@@ -0,0 +1,341 @@
+#include "string.h"
+#include "assert.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../dstr.hpp"
+#include "../runit.h"
+
+// Helpers
+struct hpp_test_counting_allocator {
+    static size_t allocations;
+    static void* alloc(void* user_data, size_t size) { (void)user_data; ++allocations; return malloc(size); }
+    static void* realloc(void* user_data, void* ptr, size_t old_size, size_t new_size) { (void)user_data; (void)old_size; ++allocations; return ::realloc(ptr, new_size); }
+    static void  free(void* user_data, void* ptr, size_t size) { (void)user_data; (void)size; ::free(ptr); }
+    static const dstr_allocator* get() {
+        static const dstr_allocator allocator = { alloc, realloc, free, 0 };
+        return &allocator;
+    }
+};
+size_t hpp_test_counting_allocator::allocations = 0;
+
+// Tests
+void dstr_hpp_basic_test();
+void dstr_hpp_move_test();
+void dstr_hpp_inline_test();
+void dstr_hpp_interop_test();
+
+void dstr_hpp_testsuite() {
+
+    printf("dstr_hpp_testsuite\n");
+
+    dstr_hpp_basic_test();
+    dstr_hpp_move_test();
+    dstr_hpp_inline_test();
+    dstr_hpp_interop_test();
+}
+
+void dstr_hpp_basic_test() {
+
+    printf("dstr_hpp_basic_test\n");
+
+    // Construction and access
+    {
+        re::dstr empty;
+        re::dstr s = "hello";
+        re::dstr n(3, 'x');
+
+        RUNIT_ASSERT(empty.empty());
+        RUNIT_ASSERT(empty.size() == 0);
+        RUNIT_ASSERT(strcmp(empty.c_str(), "") == 0);
+        RUNIT_ASSERT(s.size() == 5 && s.length() == 5);
+        RUNIT_ASSERT(strcmp(s.c_str(), "hello") == 0);
+        RUNIT_ASSERT(s[1] == 'e' && s.front() == 'h' && s.back() == 'o');
+        RUNIT_ASSERT(n == "xxx");
+    }
+
+    // Modifiers
+    {
+        re::dstr s = "hello";
+
+        s += ' ';
+        s += "world";
+        s.push_back('!');
+        RUNIT_ASSERT(s == "hello world!");
+
+        s.pop_back();
+        s.insert(5, ",");
+        RUNIT_ASSERT(s == "hello, world");
+
+        s.erase(5, 1);
+        RUNIT_ASSERT(s == "hello world");
+
+        s.replace(0, 5, "goodbye");
+        RUNIT_ASSERT(s == "goodbye world");
+
+        s.erase(7);
+        RUNIT_ASSERT(s == "goodbye");
+
+        s.resize(9, '.');
+        RUNIT_ASSERT(s == "goodbye..");
+
+        s.resize(4);
+        RUNIT_ASSERT(s == "good");
+
+        s.append(40, 'o');
+        RUNIT_ASSERT(s.size() == 44);
+        RUNIT_ASSERT(s.capacity() > 44);
+
+        s.clear();
+        RUNIT_ASSERT(s.empty());
+    }
+
+    // Insert and replace with chars of the string itself
+    {
+        re::dstr s = "0123456789abcdefghijklmnopqrstuvwxyz";
+        re::dstr expected = "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz";
+
+        s.insert(0, s);
+        RUNIT_ASSERT(s == expected);
+
+        s = "0123456789abcdefghijklmnopqrstuvwxyz";
+        s.replace(10, 3, std::string_view(s).substr(20, 16));
+        RUNIT_ASSERT(s == "0123456789klmnopqrstuvwxyzdefghijklmnopqrstuvwxyz");
+
+        s = "abc";
+        s.replace(1, 1, std::string_view(s));
+        RUNIT_ASSERT(s == "aabcc");
+    }
+
+    // Operations and comparisons
+    {
+        re::dstr s = "one two three";
+        re::dstr other = "one two three";
+
+        RUNIT_ASSERT(s.find("two") == 4);
+        RUNIT_ASSERT(s.find('t', 5) == 8);
+        RUNIT_ASSERT(s.find("four") == re::dstr::npos);
+        RUNIT_ASSERT(s.starts_with("one"));
+        RUNIT_ASSERT(s.ends_with("three"));
+        RUNIT_ASSERT(s.substr(4, 3) == "two");
+
+        RUNIT_ASSERT(s == other);
+        RUNIT_ASSERT(!(s != other));
+        RUNIT_ASSERT(s < "one two x");
+        RUNIT_ASSERT(s > "one");
+        RUNIT_ASSERT(s <= other && s >= other);
+    }
+
+    // Iterators
+    {
+        re::dstr s = "dcba";
+        std::string reversed(s.rbegin(), s.rend());
+
+        std::sort(s.begin(), s.end());
+        RUNIT_ASSERT(s == "abcd");
+        RUNIT_ASSERT(reversed == "abcd");
+        RUNIT_ASSERT(s.end() - s.begin() == 4);
+    }
+}
+
+void dstr_hpp_move_test() {
+
+    printf("dstr_hpp_move_test\n");
+
+    // Move construction and assignment steal the heap buffer
+    {
+        re::dstr s(100, 'a');
+        const char* data = s.data();
+
+        re::dstr moved(std::move(s));
+        RUNIT_ASSERT(moved.data() == data);
+        RUNIT_ASSERT(moved.size() == 100);
+        RUNIT_ASSERT(s.empty());
+
+        re::dstr assigned = "previous content, long enough to be on the heap";
+        assigned = std::move(moved);
+        RUNIT_ASSERT(assigned.data() == data);
+        RUNIT_ASSERT(moved.empty());
+
+        // Moved-from strings are usable
+        moved = "reused";
+        RUNIT_ASSERT(moved == "reused");
+    }
+
+    // std::vector growth does not touch the heap buffers
+    {
+        std::vector<re::dstr> strings;
+        std::vector<const char*> datas;
+        size_t i;
+        int all_equal = 1;
+
+        for (i = 0; i < 100; ++i) {
+            strings.push_back(re::dstr(64 + i, (char)('a' + i % 26)));
+            datas.push_back(strings.back().data());
+        }
+
+        for (i = 0; i < 100; ++i) {
+            all_equal &= strings[i].data() == datas[i];
+            all_equal &= strings[i].size() == 64 + i;
+            all_equal &= strings[i][0] == (char)('a' + i % 26);
+        }
+        RUNIT_ASSERT(all_equal);
+    }
+
+    // Small strings are moved with the object
+    {
+        std::vector<re::dstr> strings;
+        size_t i;
+        int all_equal = 1;
+
+        for (i = 0; i < 100; ++i) {
+            strings.push_back(re::dstr(i % 10, 'z'));
+        }
+        for (i = 0; i < 100; ++i) {
+            all_equal &= strings[i].size() == i % 10;
+            all_equal &= strings[i].c_str()[i % 10] == '\0';
+        }
+        RUNIT_ASSERT(all_equal);
+    }
+
+    // Swap
+    {
+        re::dstr a = "a";
+        re::dstr b(50, 'b');
+        const char* data = b.data();
+
+        a.swap(b);
+        RUNIT_ASSERT(a.data() == data);
+        RUNIT_ASSERT(b == "a");
+    }
+}
+
+void dstr_hpp_inline_test() {
+
+    printf("dstr_hpp_inline_test\n");
+
+    typedef re::basic_dstr<hpp_test_counting_allocator, 64> inline_dstr;
+
+    // No allocation below the inline capacity
+    {
+        hpp_test_counting_allocator::allocations = 0;
+
+        inline_dstr s = "/usr";
+        s += "/local/share/some/long/path";
+        RUNIT_ASSERT(s == "/usr/local/share/some/long/path");
+        RUNIT_ASSERT(s.capacity() == 64);
+
+        s.append(63 - s.size(), 'x');
+        RUNIT_ASSERT(s.size() == 63);
+        RUNIT_ASSERT(hpp_test_counting_allocator::allocations == 0);
+
+        // Heap buffer from the allocator policy
+        s += 'y';
+        RUNIT_ASSERT(s.size() == 64);
+        RUNIT_ASSERT(s.back() == 'y');
+        RUNIT_ASSERT(s.starts_with("/usr/local"));
+        RUNIT_ASSERT(hpp_test_counting_allocator::allocations == 1);
+
+        // Back to the inline buffer
+        s.resize(10);
+        s.shrink_to_fit();
+        RUNIT_ASSERT(s == "/usr/local");
+        RUNIT_ASSERT(s.capacity() == 64);
+    }
+
+    // Moves copy inline chars, heap buffers are stolen
+    {
+        inline_dstr small = "inline";
+        inline_dstr large(100, 'h');
+        const char* data = large.data();
+
+        inline_dstr moved_small(std::move(small));
+        inline_dstr moved_large(std::move(large));
+
+        RUNIT_ASSERT(moved_small == "inline");
+        RUNIT_ASSERT(moved_small.capacity() == 64);
+        RUNIT_ASSERT(small.empty());
+        RUNIT_ASSERT(moved_large.data() == data);
+        RUNIT_ASSERT(large.empty());
+
+        // Still usable
+        small = "again";
+        large += "again";
+        RUNIT_ASSERT(small == "again" && large == "again");
+    }
+
+    // Self insert in the inline buffer, moving to the heap
+    {
+        inline_dstr s(40, 'a');
+
+        s.replace(0, 1, "b");
+        s.insert(40, s);
+        RUNIT_ASSERT(s.size() == 80);
+        RUNIT_ASSERT(s.find('b', 1) == 40);
+    }
+
+    // Vector of inline strings
+    {
+        std::vector<inline_dstr> strings;
+        size_t i;
+        int all_equal = 1;
+
+        for (i = 0; i < 50; ++i) {
+            strings.push_back(inline_dstr(i * 3, 'i'));
+        }
+        for (i = 0; i < 50; ++i) {
+            all_equal &= strings[i].size() == i * 3;
+            all_equal &= strings[i] == inline_dstr(i * 3, 'i');
+        }
+        RUNIT_ASSERT(all_equal);
+    }
+}
+
+void dstr_hpp_interop_test() {
+
+    printf("dstr_hpp_interop_test\n");
+
+    // std::string_view
+    {
+        re::dstr s = "view me";
+        std::string_view v = s;
+        re::dstr from_view(std::string_view("abc", 2));
+
+        RUNIT_ASSERT(v == "view me");
+        RUNIT_ASSERT(v.data() == s.data());
+        RUNIT_ASSERT(std::string(s) == "view me");
+        RUNIT_ASSERT(from_view == "ab");
+        RUNIT_ASSERT(std::string_view("view me") == s);
+    }
+
+    // C API
+    {
+        re::dstr s = "c";
+
+        dstr_append_str(s.c(), " api");
+        RUNIT_ASSERT(s == "c api");
+        RUNIT_ASSERT(dstr_view_equals(s.view(), dstr_view_make_from_str("c api")));
+        RUNIT_ASSERT(dstr_view_equals(s.view(2, 3), dstr_view_make_from_str("api")));
+    }
+
+    // Shared buffers
+    {
+        re::dstr s(100, 's');
+        re::dstr shared = s.share();
+
+        RUNIT_ASSERT(shared.c_str() == s.c_str());
+        RUNIT_ASSERT(dstr_is_shared(s.c()));
+
+        // Non-const access copies the buffer
+        shared[0] = 'x';
+        RUNIT_ASSERT(shared.c_str() != s.c_str());
+        RUNIT_ASSERT(s[0] == 's' && shared[0] == 'x');
+
+        // Copies are deep copies
+        re::dstr copy = s;
+        RUNIT_ASSERT(copy == s);
+        RUNIT_ASSERT(copy.c_str() != s.c_str());
+    }
+}
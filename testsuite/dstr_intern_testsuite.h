@@ -0,0 +1,138 @@
+#include "string.h"
+#include "assert.h"
+
+#include "../dstr_intern.h"
+#include "../runit.h"
+
+// Tests
+void dstr_intern_simple_test();
+void dstr_intern_many_test();
+
+void dstr_intern_testsuite() {
+
+    printf("dstr_intern_testsuite\n");
+
+    dstr_intern_simple_test();
+    dstr_intern_many_test();
+}
+
+void dstr_intern_simple_test() {
+
+    printf("dstr_intern_simple_test\n");
+
+    {
+        dstr_intern table;
+        dstr_intern_stats stats;
+        dstr name = dstr_make_from_str("Content-Type");
+        const char* a;
+        const char* b;
+        const char* c;
+        const char* empty;
+        const char zeros[] = "a\0b";
+
+        dstr_intern_init(&table);
+
+        RUNIT_ASSERT(dstr_intern_find_range(&table, (dstr_it)"x", (dstr_it)"x" + 1) == 0);
+
+        a = dstr_intern_str(&table, "Content-Type");
+        b = dstr_intern_dstr(&table, &name);
+        c = dstr_intern_str(&table, "Content-Length");
+
+        RUNIT_ASSERT(a == b);
+        RUNIT_ASSERT(a != c);
+        RUNIT_ASSERT(a != dstr_data(&name));
+        RUNIT_ASSERT(strcmp(a, "Content-Type") == 0);
+        RUNIT_ASSERT(dstr_interned_size(a) == 12);
+        RUNIT_ASSERT(dstr_intern_find_range(&table, dstr_begin(&name), dstr_end(&name)) == a);
+
+        // Empty string and embedded '\0'
+        empty = dstr_intern_str(&table, "");
+        RUNIT_ASSERT(empty && empty[0] == '\0' && dstr_interned_size(empty) == 0);
+        RUNIT_ASSERT(dstr_intern_str(&table, "") == empty);
+
+        RUNIT_ASSERT(dstr_intern_range(&table, (dstr_it)zeros, (dstr_it)zeros + 3) != dstr_intern_str(&table, "a"));
+        RUNIT_ASSERT(dstr_interned_size(dstr_intern_range(&table, (dstr_it)zeros, (dstr_it)zeros + 3)) == 3);
+
+        RUNIT_ASSERT(dstr_intern_count(&table) == 5);
+
+        dstr_intern_get_stats(&table, &stats);
+        RUNIT_ASSERT(stats.count == 5);
+        RUNIT_ASSERT(stats.lookups == 8);
+        RUNIT_ASSERT(stats.hits == 3);
+        RUNIT_ASSERT(stats.saved_bytes == 13 + 1 + 4);
+        RUNIT_ASSERT(stats.string_bytes == 13 + 15 + 1 + 4 + 2);
+        RUNIT_ASSERT(stats.memory_bytes >= stats.string_bytes);
+
+        dstr_intern_clear(&table);
+        RUNIT_ASSERT(dstr_intern_count(&table) == 0);
+
+        dstr_clear(&name);
+    }
+}
+
+void dstr_intern_many_test() {
+
+    printf("dstr_intern_many_test\n");
+
+    enum {
+        DISTINCT = 5000,
+        ROUNDS = 3
+    };
+
+    {
+        dstr_intern table;
+        dstr_intern_stats stats;
+        const char** interned = (const char**)malloc(DISTINCT * sizeof(const char*));
+        dstr s;
+        dstr large;
+        const char* large_interned;
+        int ok = 1;
+        int round;
+        int i;
+
+        dstr_intern_init(&table);
+        dstr_init(&s);
+
+        for (round = 0; round < ROUNDS; ++round) {
+            for (i = 0; i < DISTINCT; ++i) {
+                const char* p;
+
+                dstr_assign_str(&s, "host-");
+                dstr_append_char(&s, (char)('a' + i % 26));
+                dstr_append_char(&s, (char)('a' + (i / 26) % 26));
+                dstr_append_char(&s, (char)('a' + (i / 676) % 26));
+
+                p = dstr_intern_dstr(&table, &s);
+
+                if (round == 0) {
+                    interned[i] = p;
+                } else {
+                    ok = ok && interned[i] == p;
+                }
+                ok = ok && strcmp(p, dstr_c_str(&s)) == 0;
+            }
+        }
+
+        RUNIT_ASSERT(ok);
+        RUNIT_ASSERT(dstr_intern_count(&table) == DISTINCT);
+
+        // Larger than a block
+        dstr_init(&large);
+        dstr_append_nchar(&large, DSTR_INTERN_BLOCK_SIZE * 2, 'z');
+        large_interned = dstr_intern_dstr(&table, &large);
+        RUNIT_ASSERT(dstr_interned_size(large_interned) == DSTR_INTERN_BLOCK_SIZE * 2);
+        RUNIT_ASSERT(dstr_intern_dstr(&table, &large) == large_interned);
+
+        // Previous strings have not moved
+        RUNIT_ASSERT(dstr_intern_str(&table, "host-aaa") == interned[0]);
+
+        dstr_intern_get_stats(&table, &stats);
+        RUNIT_ASSERT(stats.hits == DISTINCT * (ROUNDS - 1) + 2);
+        RUNIT_ASSERT(stats.hit_rate > 0.6);
+
+        dstr_intern_clear(&table);
+        dstr_clear(&s);
+        dstr_clear(&large);
+        free((void*)interned);
+    }
+}
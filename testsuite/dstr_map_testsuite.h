@@ -0,0 +1,192 @@
+#include "string.h"
+#include "assert.h"
+
+#include "../dstr_map.h"
+#include "../runit.h"
+
+// Helpers
+void map_test_key(dstr* key, size_t i);
+
+// Tests
+void dstr_map_simple_test();
+void dstr_map_many_test();
+void dstr_map_reserve_test();
+
+void dstr_map_testsuite() {
+
+    printf("dstr_map_testsuite\n");
+
+    dstr_map_simple_test();
+    dstr_map_many_test();
+    dstr_map_reserve_test();
+}
+
+void map_test_key(dstr* key, size_t i) {
+
+    dstr_assign_str(key, "key-");
+
+    do {
+        dstr_append_char(key, (char)('0' + i % 10));
+        i /= 10;
+    } while (i);
+
+    // Some keys are too large to be stored inline
+    if (dstr_size(key) % 3 == 0) {
+        dstr_append_str(key, "-with-a-long-suffix-to-be-allocated");
+    }
+}
+
+void dstr_map_simple_test() {
+
+    printf("dstr_map_simple_test\n");
+
+    {
+        dstr_map map;
+        dstr key = dstr_make_from_str("/about");
+        int index_handler = 1;
+        int about_handler = 2;
+        int other_handler = 3;
+        const char* path = "/index.html";
+        dstr_map_entry* entry;
+        size_t count = 0;
+
+        dstr_map_init(&map);
+
+        RUNIT_ASSERT(dstr_map_empty(&map));
+        RUNIT_ASSERT(dstr_map_find_str(&map, "/index") == 0);
+        RUNIT_ASSERT(dstr_map_first(&map) == 0);
+        RUNIT_ASSERT(dstr_map_erase_str(&map, "/index") == 0);
+
+        RUNIT_ASSERT(dstr_map_set_str(&map, "/index", &index_handler) == 1);
+        RUNIT_ASSERT(dstr_map_set_dstr(&map, &key, &about_handler) == 1);
+        RUNIT_ASSERT(dstr_map_set(&map, "", 0, &other_handler) == 1);
+        RUNIT_ASSERT(dstr_map_size(&map) == 3);
+
+        // Lookup with a slice of a larger string
+        RUNIT_ASSERT(dstr_map_find(&map, path, 6) && *dstr_map_find(&map, path, 6) == &index_handler);
+        RUNIT_ASSERT(dstr_map_find(&map, path, 7) == 0);
+        RUNIT_ASSERT(*dstr_map_find_dstr(&map, &key) == &about_handler);
+        RUNIT_ASSERT(*dstr_map_find_str(&map, "") == &other_handler);
+
+        // Replace
+        RUNIT_ASSERT(dstr_map_set_str(&map, "/about", &other_handler) == 0);
+        RUNIT_ASSERT(*dstr_map_find_str(&map, "/about") == &other_handler);
+        RUNIT_ASSERT(dstr_map_size(&map) == 3);
+
+        // Null values
+        RUNIT_ASSERT(dstr_map_set_str(&map, "/null", 0) == 1);
+        RUNIT_ASSERT(dstr_map_find_str(&map, "/null") && *dstr_map_find_str(&map, "/null") == 0);
+
+        for (entry = dstr_map_first(&map); entry; entry = dstr_map_next(&map, entry)) {
+            RUNIT_ASSERT(dstr_map_find_dstr(&map, &entry->key) == &entry->value);
+            ++count;
+        }
+        RUNIT_ASSERT(count == 4);
+
+        RUNIT_ASSERT(dstr_map_erase_str(&map, "/index") == 1);
+        RUNIT_ASSERT(dstr_map_erase_str(&map, "/index") == 0);
+        RUNIT_ASSERT(dstr_map_find_str(&map, "/index") == 0);
+        RUNIT_ASSERT(dstr_map_size(&map) == 3);
+
+        dstr_map_clear(&map);
+        RUNIT_ASSERT(dstr_map_empty(&map));
+
+        dstr_clear(&key);
+    }
+}
+
+void dstr_map_many_test() {
+
+    printf("dstr_map_many_test\n");
+
+    enum {
+        COUNT = 20000
+    };
+
+    {
+        dstr_map map;
+        dstr key;
+        size_t i;
+        int ok = 1;
+
+        dstr_map_init(&map);
+        dstr_init(&key);
+
+        for (i = 0; i < COUNT; ++i) {
+            map_test_key(&key, i);
+            ok = ok && dstr_map_set_dstr(&map, &key, (void*)(i + 1)) == 1;
+        }
+        RUNIT_ASSERT(ok);
+        RUNIT_ASSERT(dstr_map_size(&map) == COUNT);
+
+        for (i = 0; i < COUNT; ++i) {
+            void** value;
+            map_test_key(&key, i);
+            value = dstr_map_find_dstr(&map, &key);
+            ok = ok && value && *value == (void*)(i + 1);
+        }
+        RUNIT_ASSERT(ok);
+
+        // Erase half of the keys, then insert and erase again to create many deleted slots.
+        for (i = 0; i < COUNT; i += 2) {
+            map_test_key(&key, i);
+            ok = ok && dstr_map_erase_dstr(&map, &key) == 1;
+        }
+        RUNIT_ASSERT(ok);
+        RUNIT_ASSERT(dstr_map_size(&map) == COUNT / 2);
+
+        for (i = COUNT; i < COUNT * 3; ++i) {
+            map_test_key(&key, i);
+            ok = ok && dstr_map_set_dstr(&map, &key, (void*)(i + 1)) == 1;
+            ok = ok && dstr_map_erase_dstr(&map, &key) == 1;
+        }
+        RUNIT_ASSERT(ok);
+
+        for (i = 0; i < COUNT * 3; ++i) {
+            void** value;
+            map_test_key(&key, i);
+            value = dstr_map_find_dstr(&map, &key);
+            ok = ok && (i < COUNT && i % 2 == 1 ? value && *value == (void*)(i + 1) : value == 0);
+        }
+        RUNIT_ASSERT(ok);
+        RUNIT_ASSERT(dstr_map_size(&map) == COUNT / 2);
+
+        dstr_map_clear(&map);
+        dstr_clear(&key);
+    }
+}
+
+void dstr_map_reserve_test() {
+
+    printf("dstr_map_reserve_test\n");
+
+    {
+        dstr_map map;
+        dstr key;
+        size_t capacity;
+        size_t i;
+
+        dstr_map_init(&map);
+        dstr_init(&key);
+
+        dstr_map_reserve(&map, 1000);
+        capacity = map.capacity;
+        RUNIT_ASSERT(capacity * 7 >= 1000 * 8);
+
+        for (i = 0; i < 1000; ++i) {
+            map_test_key(&key, i);
+            dstr_map_set_dstr(&map, &key, 0);
+        }
+
+        // No rehash
+        RUNIT_ASSERT(map.capacity == capacity);
+
+        // Smaller reserve does nothing
+        dstr_map_reserve(&map, 10);
+        RUNIT_ASSERT(map.capacity == capacity);
+        RUNIT_ASSERT(dstr_map_size(&map) == 1000);
+
+        dstr_map_clear(&map);
+        dstr_clear(&key);
+    }
+}
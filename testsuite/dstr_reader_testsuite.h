@@ -0,0 +1,240 @@
+#include "string.h"
+#include "assert.h"
+
+#include "../dstr_reader.h"
+#include "../runit.h"
+#include "test_random.h"
+
+// Tests
+void dstr_reader_lines_test();
+void dstr_reader_random_test();
+
+void dstr_reader_testsuite() {
+
+    printf("dstr_reader_testsuite\n");
+
+    test_random_seed(2024);
+
+    dstr_reader_lines_test();
+    dstr_reader_random_test();
+}
+
+void dstr_reader_lines_test() {
+
+    printf("dstr_reader_lines_test\n");
+
+    // Empty lines, '\r' and last line without '\n'
+    {
+        const char* text = "first\n\nthird\r\nlast";
+        const char* expected[] = { "first", "", "third\r", "last" };
+        size_t block_sizes[] = { 1, 2, 3, 5, 0 };
+        size_t i;
+
+        for (i = 0; i < sizeof(block_sizes) / sizeof(block_sizes[0]); ++i) {
+            FILE* f = tmpfile();
+            dstr_reader reader;
+            dstr_view line;
+            size_t count = 0;
+            int all_equal = 1;
+
+            fputs(text, f);
+            rewind(f);
+
+            dstr_reader_init_file(&reader, f, block_sizes[i]);
+            while (dstr_reader_next_line(&reader, &line)) {
+                all_equal &= count < 4 && dstr_view_equals(line, dstr_view_make_from_str(expected[count]));
+                ++count;
+            }
+            RUNIT_ASSERT(all_equal);
+            RUNIT_ASSERT(count == 4);
+            RUNIT_ASSERT(!dstr_reader_next_line(&reader, &line));
+            RUNIT_ASSERT(!dstr_reader_error(&reader));
+
+            dstr_reader_clear(&reader);
+            fclose(f);
+        }
+    }
+
+    // Final '\n' does not add an empty line, empty stream has no line
+    {
+        FILE* f = tmpfile();
+        dstr_reader reader;
+        dstr line = dstr_make();
+
+        fputs("a\nb\n", f);
+        rewind(f);
+
+        dstr_reader_init_file(&reader, f, 0);
+        RUNIT_ASSERT(dstr_getline(&reader, &line) && dstr_compare_str(&line, "a") == 0);
+        RUNIT_ASSERT(dstr_getline(&reader, &line) && dstr_compare_str(&line, "b") == 0);
+        RUNIT_ASSERT(!dstr_getline(&reader, &line) && dstr_empty(&line));
+        dstr_reader_clear(&reader);
+        fclose(f);
+
+        f = tmpfile();
+        dstr_reader_init_file(&reader, f, 0);
+        RUNIT_ASSERT(!dstr_getline(&reader, &line));
+        dstr_reader_clear(&reader);
+        fclose(f);
+
+        dstr_clear(&line);
+    }
+
+    // Lines inside a block are not copied
+    {
+        FILE* f = tmpfile();
+        dstr_reader reader;
+        dstr_view line;
+
+        fputs("one\ntwo\n", f);
+        rewind(f);
+
+        dstr_reader_init_file(&reader, f, 0);
+        RUNIT_ASSERT(dstr_reader_next_line(&reader, &line));
+        RUNIT_ASSERT(line.data == reader.block);
+        RUNIT_ASSERT(dstr_reader_next_line(&reader, &line));
+        RUNIT_ASSERT(line.data == reader.block + 4);
+        RUNIT_ASSERT(dstr_capacity(&reader.line) == DSTR_SSO_CAPACITY);
+
+        dstr_reader_clear(&reader);
+        fclose(f);
+    }
+
+    // FILE* with chars already read or pushed back
+    {
+        FILE* f = tmpfile();
+        char first[16];
+        dstr_reader reader;
+        dstr_view line;
+
+        fputs("zero\nalpha\nbeta\ngamma", f);
+        rewind(f);
+
+        RUNIT_ASSERT(fgets(first, sizeof(first), f) && strcmp(first, "zero\n") == 0);
+        RUNIT_ASSERT(ungetc('A', f) == 'A');
+
+        dstr_reader_init_file(&reader, f, 4);
+
+        RUNIT_ASSERT(dstr_reader_next_line(&reader, &line));
+        RUNIT_ASSERT(dstr_view_equals(line, dstr_view_make_from_str("Aalpha")));
+        RUNIT_ASSERT(dstr_reader_next_line(&reader, &line));
+        RUNIT_ASSERT(dstr_view_equals(line, dstr_view_make_from_str("beta")));
+        RUNIT_ASSERT(dstr_reader_next_line(&reader, &line));
+        RUNIT_ASSERT(dstr_view_equals(line, dstr_view_make_from_str("gamma")));
+        RUNIT_ASSERT(!dstr_reader_next_line(&reader, &line));
+        RUNIT_ASSERT(!dstr_reader_error(&reader));
+
+        dstr_reader_clear(&reader);
+        fclose(f);
+    }
+
+#ifdef DSTR_READER_FD
+    // FILE* without a file descriptor
+    {
+        char text[] = "alpha\nbeta\ngamma";
+        FILE* f = fmemopen(text, strlen(text), "r");
+        dstr_reader reader;
+        dstr_view line;
+
+        dstr_reader_init_file(&reader, f, 0);
+
+        RUNIT_ASSERT(dstr_reader_next_line(&reader, &line));
+        RUNIT_ASSERT(dstr_view_equals(line, dstr_view_make_from_str("alpha")));
+        RUNIT_ASSERT(dstr_reader_next_line(&reader, &line));
+        RUNIT_ASSERT(dstr_view_equals(line, dstr_view_make_from_str("beta")));
+        RUNIT_ASSERT(dstr_reader_next_line(&reader, &line));
+        RUNIT_ASSERT(dstr_view_equals(line, dstr_view_make_from_str("gamma")));
+        RUNIT_ASSERT(!dstr_reader_next_line(&reader, &line));
+        RUNIT_ASSERT(!dstr_reader_error(&reader));
+
+        dstr_reader_clear(&reader);
+        fclose(f);
+    }
+
+    // Pipe: lines are returned without waiting for a whole block
+    {
+        int fds[2];
+        dstr_reader reader;
+        dstr_view line;
+
+        RUNIT_ASSERT(pipe(fds) == 0);
+        RUNIT_ASSERT(write(fds[1], "first\nsec", 9) == 9);
+
+        dstr_reader_init_fd(&reader, fds[0], 0);
+
+        RUNIT_ASSERT(dstr_reader_next_line(&reader, &line));
+        RUNIT_ASSERT(dstr_view_equals(line, dstr_view_make_from_str("first")));
+
+        RUNIT_ASSERT(write(fds[1], "ond\n", 4) == 4);
+        RUNIT_ASSERT(dstr_reader_next_line(&reader, &line));
+        RUNIT_ASSERT(dstr_view_equals(line, dstr_view_make_from_str("second")));
+
+        close(fds[1]);
+        RUNIT_ASSERT(!dstr_reader_next_line(&reader, &line));
+        RUNIT_ASSERT(!dstr_reader_error(&reader));
+
+        dstr_reader_clear(&reader);
+        close(fds[0]);
+    }
+#endif
+}
+
+void dstr_reader_random_test() {
+
+    printf("dstr_reader_random_test\n");
+
+    // Compared with a naive split, with a FILE* and a file descriptor
+    {
+        size_t block_sizes[] = { 1, 7, 64, 1000, 0 };
+        dstr text = dstr_make();
+        size_t round;
+
+        for (round = 0; round < 2000; ++round) {
+            size_t length = test_random() % 5 == 0 ? test_random() % 3000 : test_random() % 40;
+            dstr_append_nchar(&text, length, (char)('a' + round % 26));
+            dstr_append_char(&text, '\n');
+        }
+        dstr_append_str(&text, "no final new line");
+
+        for (round = 0; round < 2 * sizeof(block_sizes) / sizeof(block_sizes[0]); ++round) {
+            FILE* f = tmpfile();
+            dstr_reader reader;
+            dstr_view line;
+            dstr_view expected = dstr_view_make_from_dstr(&text);
+            size_t count = 0;
+            int all_equal = 1;
+
+            fwrite(dstr_data(&text), 1, dstr_size(&text), f);
+            fflush(f);
+            rewind(f);
+
+#ifdef DSTR_READER_FD
+            if (round % 2) {
+                dstr_reader_init_fd(&reader, fileno(f), block_sizes[round / 2]);
+            } else
+#endif
+            {
+                dstr_reader_init_file(&reader, f, block_sizes[round / 2]);
+            }
+
+            while (dstr_reader_next_line(&reader, &line)) {
+                size_t end = dstr_view_find_char(expected, 0, '\n');
+                if (end == DSTR_NPOS) {
+                    end = expected.size;
+                }
+                all_equal &= dstr_view_equals(line, dstr_view_prefix(expected, end));
+                expected = dstr_view_substr(expected, end + 1, DSTR_NPOS);
+                ++count;
+            }
+
+            RUNIT_ASSERT(all_equal);
+            RUNIT_ASSERT(count == 2001);
+            RUNIT_ASSERT(expected.size == 0);
+
+            dstr_reader_clear(&reader);
+            fclose(f);
+        }
+
+        dstr_clear(&text);
+    }
+}
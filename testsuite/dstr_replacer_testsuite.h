@@ -0,0 +1,412 @@
+#include "string.h"
+#include "assert.h"
+
+#include "../dstr_replacer.h"
+#include "../runit.h"
+#include "test_random.h"
+
+// Helpers
+size_t naive_replace(dstr* output, const dstr* input, const dstr_replace_pair* pairs, size_t count);
+void* replacer_test_alloc(void* user_data, size_t size);
+void* replacer_test_realloc(void* user_data, void* ptr, size_t old_size, size_t new_size);
+void  replacer_test_free(void* user_data, void* ptr, size_t size);
+
+// Tests
+void dstr_replacer_simple_test();
+void dstr_replacer_semantics_test();
+void dstr_replacer_window_test();
+void dstr_replacer_random_test();
+
+void dstr_replacer_testsuite() {
+
+    printf("dstr_replacer_testsuite\n");
+
+    test_random_seed(1);
+
+    dstr_replacer_simple_test();
+    dstr_replacer_semantics_test();
+    dstr_replacer_window_test();
+    dstr_replacer_random_test();
+}
+
+void dstr_replacer_simple_test() {
+
+    printf("dstr_replacer_simple_test\n");
+
+    // Escaping
+    {
+        dstr_replace_pair pairs[] = {
+            { "&", "&amp;" },
+            { "<", "&lt;" },
+            { ">", "&gt;" },
+            { "\"", "&quot;" }
+        };
+        dstr_replacer replacer;
+        dstr str = dstr_make_from_str("<a href=\"x\">Tom & Jerry</a>");
+
+        dstr_replacer_init(&replacer, pairs, 4);
+
+        RUNIT_ASSERT(dstr_replacer_replace(&replacer, &str) == 7);
+        RUNIT_ASSERT(dstr_compare_str(&str, "&lt;a href=&quot;x&quot;&gt;Tom &amp; Jerry&lt;/a&gt;") == 0);
+
+        // Replaced text is not scanned again
+        RUNIT_ASSERT(dstr_replacer_replace(&replacer, &str) == 7);
+        RUNIT_ASSERT(dstr_compare_str(&str, "&amp;lt;a href=&amp;quot;x&amp;quot;&amp;gt;Tom &amp;amp; Jerry&amp;lt;/a&amp;gt;") == 0);
+
+        dstr_assign_str(&str, "nothing to escape");
+        RUNIT_ASSERT(dstr_replacer_replace(&replacer, &str) == 0);
+        RUNIT_ASSERT(dstr_compare_str(&str, "nothing to escape") == 0);
+
+        dstr_assign_str(&str, "");
+        RUNIT_ASSERT(dstr_replacer_replace(&replacer, &str) == 0);
+        RUNIT_ASSERT(dstr_empty(&str));
+
+        dstr_replacer_clear(&replacer);
+        dstr_clear(&str);
+    }
+
+    // Nothing is copied without a match
+    {
+        dstr_replace_pair pairs[] = {
+            { "&", "&amp;" }
+        };
+        size_t allocations = 0;
+        dstr_allocator counting = {
+            replacer_test_alloc,
+            replacer_test_realloc,
+            replacer_test_free,
+            &allocations
+        };
+        dstr_replacer replacer;
+        dstr str = dstr_make_with_allocator(0, &counting);
+        const dstr_char_t* data;
+
+        dstr_replacer_init(&replacer, pairs, 1);
+
+        dstr_assign_str(&str, "a string long enough to be on the heap, without anything to escape");
+        data = dstr_data(&str);
+        allocations = 0;
+
+        RUNIT_ASSERT(dstr_replacer_replace(&replacer, &str) == 0);
+        RUNIT_ASSERT(dstr_data(&str) == data);
+        RUNIT_ASSERT(allocations == 0);
+
+        dstr_replacer_clear(&replacer);
+        dstr_clear(&str);
+    }
+
+    // Templating, output appended to an existing string
+    {
+        dstr_replace_pair pairs[] = {
+            { "{{name}}", "World" },
+            { "{{greeting}}", "Hello" },
+            { "{{empty}}", "" }
+        };
+        dstr_replacer replacer;
+        const char* text = "{{greeting}} {{name}}{{empty}}! {{unknown}} {{name";
+        dstr out = dstr_make_from_str(">");
+
+        dstr_replacer_init(&replacer, pairs, 3);
+
+        RUNIT_ASSERT(dstr_replacer_append(&replacer, &out, (dstr_it)text, (dstr_it)text + strlen(text)) == 3);
+        RUNIT_ASSERT(dstr_compare_str(&out, ">Hello World! {{unknown}} {{name") == 0);
+
+        dstr_replacer_clear(&replacer);
+        dstr_clear(&out);
+    }
+
+    // No pattern, empty patterns
+    {
+        dstr_replace_pair pairs[] = {
+            { "", "x" }
+        };
+        dstr_replacer replacer;
+        dstr str = dstr_make_from_str("abc");
+
+        dstr_replacer_init(&replacer, pairs, 0);
+        RUNIT_ASSERT(dstr_replacer_replace(&replacer, &str) == 0);
+        dstr_replacer_clear(&replacer);
+
+        dstr_replacer_init(&replacer, pairs, 1);
+        RUNIT_ASSERT(dstr_replacer_replace(&replacer, &str) == 0);
+        RUNIT_ASSERT(dstr_compare_str(&str, "abc") == 0);
+        dstr_replacer_clear(&replacer);
+
+        dstr_clear(&str);
+    }
+}
+
+void dstr_replacer_semantics_test() {
+
+    printf("dstr_replacer_semantics_test\n");
+
+    {
+        dstr_replace_pair pairs[] = {
+            { "he", "1" },
+            { "she", "2" },
+            { "his", "3" },
+            { "hers", "4" },
+            { "abcd", "5" },
+            { "bc", "6" },
+            { "he", "7" } // duplicated, ignored
+        };
+        dstr_replacer replacer;
+        dstr str;
+
+        dstr_replacer_init(&replacer, pairs, 7);
+
+        // Longest among the ones starting at the same position
+        str = dstr_make_from_str("ushers");
+        RUNIT_ASSERT(dstr_replacer_replace(&replacer, &str) == 1);
+        RUNIT_ASSERT(dstr_compare_str(&str, "u2rs") == 0);
+
+        dstr_assign_str(&str, "hers");
+        RUNIT_ASSERT(dstr_replacer_replace(&replacer, &str) == 1);
+        RUNIT_ASSERT(dstr_compare_str(&str, "4") == 0);
+
+        // Leftmost even if a shorter one ends before
+        dstr_assign_str(&str, "abcd");
+        RUNIT_ASSERT(dstr_replacer_replace(&replacer, &str) == 1);
+        RUNIT_ASSERT(dstr_compare_str(&str, "5") == 0);
+
+        // Fall back to the shorter one when the longer one fails
+        dstr_assign_str(&str, "abce abc");
+        RUNIT_ASSERT(dstr_replacer_replace(&replacer, &str) == 2);
+        RUNIT_ASSERT(dstr_compare_str(&str, "a6e a6") == 0);
+
+        dstr_assign_str(&str, "hishe");
+        RUNIT_ASSERT(dstr_replacer_replace(&replacer, &str) == 2);
+        RUNIT_ASSERT(dstr_compare_str(&str, "31") == 0);
+
+        dstr_replacer_clear(&replacer);
+        dstr_clear(&str);
+    }
+
+    // A long pattern failing at its last char at every position
+    {
+        dstr long_pattern = dstr_make_from_nchar(100, 'a');
+        dstr_replace_pair pairs[2];
+        dstr_replacer replacer;
+        dstr str = dstr_make_from_nchar(1000, 'a');
+        dstr expected = dstr_make_from_nchar(900, 'x');
+
+        dstr_append_char(&long_pattern, 'b');
+        pairs[0].pattern = "a";
+        pairs[0].replacement = "x";
+        pairs[1].pattern = dstr_c_str(&long_pattern);
+        pairs[1].replacement = "y";
+
+        dstr_replacer_init(&replacer, pairs, 2);
+
+        dstr_append_char(&str, 'b');
+        dstr_append_char(&expected, 'y');
+        RUNIT_ASSERT(dstr_replacer_replace(&replacer, &str) == 901);
+        RUNIT_ASSERT(dstr_compare_dstr(&str, &expected) == 0);
+
+        dstr_replacer_clear(&replacer);
+        dstr_clear(&long_pattern);
+        dstr_clear(&str);
+        dstr_clear(&expected);
+    }
+
+    // Embedded '\0' in the input
+    {
+        dstr_replace_pair pairs[] = {
+            { "a", "bb" }
+        };
+        dstr_replacer replacer;
+        const char text[] = "a\0a";
+        dstr str = dstr_make_from_range((dstr_it)text, (dstr_it)text + 3);
+
+        dstr_replacer_init(&replacer, pairs, 1);
+
+        RUNIT_ASSERT(dstr_replacer_replace(&replacer, &str) == 2);
+        RUNIT_ASSERT(dstr_size(&str) == 5);
+        RUNIT_ASSERT(memcmp(dstr_data(&str), "bb\0bb", 5) == 0);
+
+        dstr_replacer_clear(&replacer);
+        dstr_clear(&str);
+    }
+}
+
+// Matches crossing the windows (DSTR_REPLACER_WINDOW), patterns longer than a window
+void dstr_replacer_window_test() {
+
+    printf("dstr_replacer_window_test\n");
+
+    dstr long_pattern = dstr_make_from_nchar(DSTR_REPLACER_WINDOW + 10, 'a');
+    dstr_replace_pair pairs[4];
+    dstr_replacer replacer;
+    dstr text;
+    dstr expected;
+    dstr result;
+    size_t i;
+
+    dstr_append_char(&long_pattern, 'c');
+
+    pairs[0].pattern = "ab";
+    pairs[0].replacement = "[0]";
+    pairs[1].pattern = "bab";
+    pairs[1].replacement = "[1]";
+    pairs[2].pattern = "aaaaaaaaaaaaaaaaaaaab";
+    pairs[2].replacement = "[2]";
+    pairs[3].pattern = dstr_c_str(&long_pattern);
+    pairs[3].replacement = "[3]";
+
+    dstr_replacer_init(&replacer, pairs, 4);
+
+    // Random text
+    dstr_init(&text);
+    for (i = 0; i < 3 * DSTR_REPLACER_WINDOW + 100; ++i) {
+        dstr_append_char(&text, (char)('a' + test_random() % 3));
+    }
+    // Runs of 'a' ending at a window boundary and crossing it
+    for (i = 0; i < 30; ++i) {
+        dstr_data(&text)[DSTR_REPLACER_WINDOW - 30 + i] = 'a';
+        dstr_data(&text)[2 * DSTR_REPLACER_WINDOW - 10 + i] = 'a';
+    }
+    dstr_data(&text)[DSTR_REPLACER_WINDOW] = 'b';
+    dstr_data(&text)[2 * DSTR_REPLACER_WINDOW + 20] = 'b';
+
+    // Long pattern starting in the first window, ending in the second one
+    dstr_append_nchar(&text, DSTR_REPLACER_WINDOW + 20, 'a');
+    dstr_append_str(&text, "cab");
+
+    dstr_init(&expected);
+    dstr_init(&result);
+
+    RUNIT_ASSERT(dstr_replacer_append(&replacer, &result, dstr_begin(&text), dstr_end(&text))
+        == naive_replace(&expected, &text, pairs, 4));
+    RUNIT_ASSERT(dstr_compare_dstr(&result, &expected) == 0);
+
+    dstr_replacer_clear(&replacer);
+    dstr_clear(&long_pattern);
+    dstr_clear(&text);
+    dstr_clear(&expected);
+    dstr_clear(&result);
+}
+
+size_t naive_replace(dstr* output, const dstr* input, const dstr_replace_pair* pairs, size_t count) {
+
+    size_t replaced = 0;
+    size_t i = 0;
+    size_t p;
+
+    while (i < dstr_size(input)) {
+
+        size_t best = count;
+        size_t best_size = 0;
+
+        for (p = 0; p < count; ++p) {
+            size_t size = strlen(pairs[p].pattern);
+            if (size > best_size
+                && size <= dstr_size(input) - i
+                && memcmp(dstr_data(input) + i, pairs[p].pattern, size) == 0) {
+                best = p;
+                best_size = size;
+            }
+        }
+
+        if (best != count) {
+            dstr_append_str(output, pairs[best].replacement);
+            i += best_size;
+            ++replaced;
+        } else {
+            dstr_append_char(output, dstr_data(input)[i]);
+            ++i;
+        }
+    }
+
+    return replaced;
+}
+
+void* replacer_test_alloc(void* user_data, size_t size) {
+    ++*(size_t*)user_data;
+    return malloc(size);
+}
+
+void* replacer_test_realloc(void* user_data, void* ptr, size_t old_size, size_t new_size) {
+    (void)old_size;
+    ++*(size_t*)user_data;
+    return realloc(ptr, new_size);
+}
+
+void replacer_test_free(void* user_data, void* ptr, size_t size) {
+    (void)user_data;
+    (void)size;
+    free(ptr);
+}
+
+// Compare with a naive leftmost-longest replacement on small alphabets
+void dstr_replacer_random_test() {
+
+    printf("dstr_replacer_random_test\n");
+
+    enum {
+        ROUNDS = 300,
+        MAX_PATTERNS = 8,
+        MAX_PATTERN_SIZE = 6,
+        TEXT_SIZE = 300
+    };
+
+    char patterns[MAX_PATTERNS][MAX_PATTERN_SIZE + 1];
+    char replacements[MAX_PATTERNS][4];
+    dstr_replace_pair pairs[MAX_PATTERNS];
+    int round;
+
+    for (round = 0; round < ROUNDS; ++round) {
+
+        size_t alphabet = 2 + test_random() % 3;
+        size_t count = 1 + test_random() % MAX_PATTERNS;
+        size_t i;
+        size_t j;
+        dstr text;
+        dstr expected;
+        dstr result;
+        dstr_replacer replacer;
+
+        for (i = 0; i < count; ++i) {
+            size_t size = 1 + test_random() % MAX_PATTERN_SIZE;
+            for (j = 0; j < size; ++j) {
+                patterns[i][j] = (char)('a' + test_random() % alphabet);
+            }
+            patterns[i][size] = '\0';
+
+            replacements[i][0] = '[';
+            replacements[i][1] = (char)('0' + i);
+            replacements[i][2] = ']';
+            replacements[i][3] = '\0';
+
+            pairs[i].pattern = patterns[i];
+            pairs[i].replacement = replacements[i];
+        }
+
+        // Duplicates are ignored by the replacer, do the same for the naive version.
+        for (i = 0; i < count; ++i) {
+            for (j = 0; j < i; ++j) {
+                if (strcmp(pairs[i].pattern, pairs[j].pattern) == 0) {
+                    pairs[i].replacement = pairs[j].replacement;
+                }
+            }
+        }
+
+        dstr_init(&text);
+        for (i = 0; i < TEXT_SIZE; ++i) {
+            dstr_append_char(&text, (char)('a' + test_random() % (alphabet + 1)));
+        }
+
+        dstr_init(&expected);
+        dstr_init(&result);
+
+        dstr_replacer_init(&replacer, pairs, count);
+
+        RUNIT_ASSERT(dstr_replacer_append(&replacer, &result, dstr_begin(&text), dstr_end(&text))
+            == naive_replace(&expected, &text, pairs, count));
+        RUNIT_ASSERT(dstr_compare_dstr(&result, &expected) == 0);
+
+        dstr_replacer_clear(&replacer);
+        dstr_clear(&text);
+        dstr_clear(&expected);
+        dstr_clear(&result);
+    }
+}
@@ -0,0 +1,292 @@
+#include "string.h"
+#include "assert.h"
+
+// Small chunks to test chunk boundaries
+#ifndef DSTR_ROPE_CHUNK_SIZE
+#define DSTR_ROPE_CHUNK_SIZE 16
+#endif
+
+#include "../dstr_rope.h"
+#include "../runit.h"
+#include "test_random.h"
+
+// Helpers
+int rope_check_node(const _dstr_rope_node* node);
+int rope_equals(const dstr_rope* rope, const dstr* expected);
+
+// Tests
+void dstr_rope_simple_test();
+void dstr_rope_random_test();
+void dstr_rope_concat_test();
+void dstr_rope_find_test();
+
+void dstr_rope_testsuite() {
+
+    printf("dstr_rope_testsuite\n");
+
+    test_random_seed(1);
+
+    dstr_rope_simple_test();
+    dstr_rope_random_test();
+    dstr_rope_concat_test();
+    dstr_rope_find_test();
+}
+
+// Checks AVL invariants, subtree totals and chunk sizes
+int rope_check_node(const _dstr_rope_node* node) {
+
+    int left_height;
+    int right_height;
+
+    if (!node) {
+        return 1;
+    }
+
+    left_height = _dstr_rope_height(node->left);
+    right_height = _dstr_rope_height(node->right);
+
+    return rope_check_node(node->left)
+        && rope_check_node(node->right)
+        && node->size > 0
+        && node->size <= DSTR_ROPE_CHUNK_SIZE
+        && node->height == 1 + (left_height > right_height ? left_height : right_height)
+        && left_height - right_height <= 1
+        && right_height - left_height <= 1
+        && node->total == _dstr_rope_total(node->left) + node->size + _dstr_rope_total(node->right);
+}
+
+int rope_equals(const dstr_rope* rope, const dstr* expected) {
+
+    dstr flat;
+    int result;
+
+    dstr_init(&flat);
+    dstr_rope_flatten(rope, &flat);
+
+    result = rope_check_node(rope->root)
+        && dstr_rope_size(rope) == dstr_size(expected)
+        && dstr_compare_dstr(&flat, expected) == 0
+        && dstr_rope_compare_dstr(rope, expected) == 0;
+
+    dstr_clear(&flat);
+
+    return result;
+}
+
+void dstr_rope_simple_test() {
+
+    printf("dstr_rope_simple_test\n");
+
+    {
+        dstr_rope rope;
+        dstr s;
+        dstr_rope_iterator it;
+        size_t chunk_count = 0;
+        size_t total = 0;
+
+        dstr_rope_init(&rope);
+        dstr_init(&s);
+
+        RUNIT_ASSERT(dstr_rope_empty(&rope));
+        RUNIT_ASSERT(dstr_rope_size(&rope) == 0);
+        RUNIT_ASSERT(!dstr_rope_first_chunk(&rope, 0, &it));
+
+        dstr_rope_append_str(&rope, "Hello World!");
+        dstr_rope_insert_str(&rope, 5, ",");
+        dstr_rope_erase(&rope, 6, 6);
+
+        dstr_rope_flatten(&rope, &s);
+        RUNIT_ASSERT(dstr_compare_str(&s, "Hello,!") == 0);
+        RUNIT_ASSERT(dstr_rope_at(&rope, 5) == ',');
+
+        // Larger than a chunk
+        dstr_rope_insert_str(&rope, 6, " this string is much longer than a single chunk of the rope");
+        dstr_rope_flatten(&rope, &s);
+        RUNIT_ASSERT(dstr_compare_str(&s, "Hello, this string is much longer than a single chunk of the rope!") == 0);
+        RUNIT_ASSERT(rope_equals(&rope, &s));
+
+        if (dstr_rope_first_chunk(&rope, 0, &it)) {
+            do {
+                RUNIT_ASSERT(it.position == total);
+                RUNIT_ASSERT(memcmp(it.data, dstr_data(&s) + it.position, it.size) == 0);
+                total += it.size;
+                ++chunk_count;
+            } while (dstr_rope_next_chunk(&it));
+        }
+        RUNIT_ASSERT(total == dstr_rope_size(&rope));
+        RUNIT_ASSERT(chunk_count > 1);
+
+        // Iteration from the middle of a chunk
+        RUNIT_ASSERT(dstr_rope_first_chunk(&rope, 3, &it));
+        RUNIT_ASSERT(it.position == 3 && it.data[0] == 'l');
+
+        // Erase everything
+        dstr_rope_erase(&rope, 0, DSTR_NPOS);
+        RUNIT_ASSERT(dstr_rope_empty(&rope));
+
+        dstr_rope_clear(&rope);
+        dstr_clear(&s);
+    }
+}
+
+// Compare with the same operations on a dstr
+void dstr_rope_random_test() {
+
+    printf("dstr_rope_random_test\n");
+
+    enum {
+        OPERATIONS = 3000
+    };
+
+    dstr_rope rope;
+    dstr expected;
+    char buffer[100];
+    int ok = 1;
+    int i;
+    size_t j;
+
+    dstr_rope_init(&rope);
+    dstr_init(&expected);
+
+    for (i = 0; i < OPERATIONS && ok; ++i) {
+
+        size_t size = dstr_size(&expected);
+        size_t pos = size ? test_random() % (size + 1) : 0;
+        size_t count = test_random() % (i % 7 == 0 ? 100 : 8);
+
+        for (j = 0; j < count; ++j) {
+            buffer[j] = (char)('a' + test_random() % 26);
+        }
+
+        switch (test_random() % 4) {
+        case 0:
+            dstr_rope_append_range(&rope, buffer, buffer + count);
+            dstr_append_range(&expected, buffer, buffer + count);
+            break;
+        case 1:
+        case 2:
+            dstr_rope_insert_range(&rope, pos, buffer, buffer + count);
+            dstr_insert_range(&expected, dstr_begin(&expected) + pos, buffer, buffer + count);
+            break;
+        case 3:
+            count = count * 2;
+            if (count > size - pos) {
+                count = size - pos;
+            }
+            dstr_rope_erase(&rope, pos, count);
+            dstr_erase_range(&expected, dstr_begin(&expected) + pos, dstr_begin(&expected) + pos + count);
+            break;
+        }
+
+        ok = rope_equals(&rope, &expected);
+    }
+
+    RUNIT_ASSERT(ok);
+
+    for (j = 0; j < dstr_size(&expected); j += 37) {
+        RUNIT_ASSERT(dstr_rope_at(&rope, j) == dstr_data(&expected)[j]);
+    }
+
+    dstr_rope_clear(&rope);
+    dstr_clear(&expected);
+}
+
+void dstr_rope_concat_test() {
+
+    printf("dstr_rope_concat_test\n");
+
+    {
+        dstr_rope rope;
+        dstr_rope other;
+        dstr expected;
+        int i;
+
+        dstr_rope_init(&rope);
+        dstr_rope_init(&other);
+        dstr_init(&expected);
+
+        for (i = 0; i < 200; ++i) {
+            dstr_rope_append_str(&rope, "0123456789");
+            dstr_append_str(&expected, "0123456789");
+        }
+
+        dstr_rope_append_str(&other, "abc");
+        dstr_rope_append_rope(&rope, &other);
+        dstr_append_str(&expected, "abc");
+
+        RUNIT_ASSERT(dstr_rope_empty(&other));
+        RUNIT_ASSERT(rope_equals(&rope, &expected));
+
+        // Smaller rope on the left
+        dstr_rope_append_str(&other, "xyz");
+        dstr_rope_append_rope(&other, &rope);
+        dstr_insert_range(&expected, dstr_begin(&expected), (dstr_it)"xyz", (dstr_it)"xyz" + 3);
+
+        RUNIT_ASSERT(dstr_rope_empty(&rope));
+        RUNIT_ASSERT(rope_equals(&other, &expected));
+
+        // Compare ropes with different chunk boundaries
+        for (i = 0; i < 200; ++i) {
+            dstr_rope_append_str(&rope, i == 0 ? "xyz0123456" : "7890123456");
+        }
+        dstr_rope_append_str(&rope, "789abc");
+        RUNIT_ASSERT(dstr_rope_compare_rope(&rope, &other) == 0);
+
+        dstr_rope_append_str(&rope, "!");
+        RUNIT_ASSERT(dstr_rope_compare_rope(&rope, &other) > 0);
+        RUNIT_ASSERT(dstr_rope_compare_rope(&other, &rope) < 0);
+
+        dstr_rope_erase(&rope, 1000, 1);
+        dstr_rope_insert_str(&rope, 1000, " ");
+        RUNIT_ASSERT(dstr_rope_compare_rope(&rope, &other) < 0);
+
+        dstr_rope_clear(&rope);
+        dstr_rope_clear(&other);
+        dstr_clear(&expected);
+    }
+}
+
+void dstr_rope_find_test() {
+
+    printf("dstr_rope_find_test\n");
+
+    {
+        dstr_rope rope;
+        dstr flat;
+        int i;
+
+        dstr_rope_init(&rope);
+        dstr_init(&flat);
+
+        // Small appends at random positions create chunks of various sizes
+        for (i = 0; i < 300; ++i) {
+            const char* pieces[] = { "a", "ab", "abc", "b", "ba", "needle", "c" };
+            const char* piece = pieces[test_random() % 7];
+            dstr_rope_insert_str(&rope, test_random() % (dstr_rope_size(&rope) + 1), piece);
+        }
+
+        dstr_rope_flatten(&rope, &flat);
+
+        {
+            const char* patterns[] = { "needle", "abab", "ca", "needleneedle", "aaaa", "bcb", "zzz", "a" };
+            size_t p;
+
+            for (p = 0; p < 8; ++p) {
+                dstr_searcher searcher;
+                size_t pos;
+
+                dstr_searcher_init(&searcher, patterns[p], strlen(patterns[p]));
+                for (pos = 0; pos <= dstr_size(&flat); pos += 13) {
+                    RUNIT_ASSERT(dstr_rope_find(&rope, pos, &searcher) == dstr_searcher_find(&searcher, &flat, pos));
+                }
+                dstr_searcher_clear(&searcher);
+            }
+        }
+
+        RUNIT_ASSERT(dstr_rope_find_str(&rope, 0, "") == DSTR_NPOS);
+        RUNIT_ASSERT(dstr_rope_find_str(&rope, dstr_size(&flat) + 1, "a") == DSTR_NPOS);
+
+        dstr_rope_clear(&rope);
+        dstr_clear(&flat);
+    }
+}
@@ -4,10 +4,14 @@
 
 #include "../dstr.h"
 #include "../runit.h"
+#include "test_random.h"
 
 void print_dstr(const dstr* s);
 void print_dstr_ln(const dstr* s);
 
+// Capacity can't be less than the inline buffer
+#define EXPECTED_CAPACITY(capacity) ((capacity) < DSTR_SSO_CAPACITY ? (size_t)DSTR_SSO_CAPACITY : (capacity))
+
 
 void dstr_compare_test();
 void dstr_constructor_test();
@@ -20,13 +24,26 @@ void dstr_erase_test();
 void dstr_resize_test();
 void dstr_replace_test();
 void dstr_find_test();
+void dstr_sso_test();
+void dstr_allocator_test();
+void dstr_growth_test();
+void dstr_huge_test();
+void dstr_searcher_test();
+void dstr_view_test();
+void dstr_shared_test();
 
 void dstr_trim_test();
+void dstr_ascii_test();
 void dstr_find_and_replace_test();
+void dstr_append_integer_test();
+void dstr_fmt_test();
+void dstr_join_test();
 
 void dstr_testsuite() {
 
     printf("dstr_testsuite\n");
+
+    test_random_seed(12345);
     printf("sizeof_dstr: %d\n", sizeof(dstr));
 
     // standard api
@@ -40,10 +57,21 @@ void dstr_testsuite() {
     dstr_resize_test();
     dstr_replace_test();
     dstr_find_test();
+    dstr_sso_test();
+    dstr_allocator_test();
+    dstr_growth_test();
+    dstr_huge_test();
+    dstr_searcher_test();
+    dstr_view_test();
+    dstr_shared_test();
 
     // extended api
     dstr_trim_test();
+    dstr_ascii_test();
     dstr_find_and_replace_test();
+    dstr_append_integer_test();
+    dstr_fmt_test();
+    dstr_join_test();
 
 }
 
@@ -71,9 +99,9 @@ void dstr_compare_test() {
     dstr_append_str(&str[4], "zzz\0zzz");
     dstr_append_str(&str[5], "aaa\0aaa");
 
-    RUNIT_ASSERT(!!dstr_compare_dstr(&str[0], &str[1]) == !!strcmp(str[0].data, str[1].data),  "test");
-    RUNIT_ASSERT(!!dstr_compare_str(&str[0], str[1].data) == !!strcmp(str[0].data, str[1].data));
-    RUNIT_ASSERT(!!dstr_compare_str(&str[4], str[5].data) == !!strcmp(str[4].data, str[5].data));
+    RUNIT_ASSERT(!!dstr_compare_dstr(&str[0], &str[1]) == !!strcmp(dstr_data(&str[0]), dstr_data(&str[1])),  "test");
+    RUNIT_ASSERT(!!dstr_compare_str(&str[0], dstr_data(&str[1])) == !!strcmp(dstr_data(&str[0]), dstr_data(&str[1])));
+    RUNIT_ASSERT(!!dstr_compare_str(&str[4], dstr_data(&str[5])) == !!strcmp(dstr_data(&str[4]), dstr_data(&str[5])));
 
     for (size_t i = 0; i < SIZE; ++i) {
         dstr_clear(&str[i]);
@@ -102,7 +130,7 @@ void dstr_constructor_test() {
         dstr_make_from_dstr(&dummy),
         dstr_make_from_str("Hello Everybody!"),
         dstr_make_from_nchar(6, 'd'),
-        dstr_make_from_range(&dummy.data[6], &dummy.data[6+5])
+        dstr_make_from_range(&dstr_data(&dummy)[6], &dstr_data(&dummy)[6+5])
     };
 
     const char* cstr[SIZE] = {
@@ -115,7 +143,7 @@ void dstr_constructor_test() {
     };
 
     for (size_t i = 0; i < SIZE; ++i) {
-        RUNIT_ASSERT(str[i].size == strlen(cstr[i]));
+        RUNIT_ASSERT(dstr_size(&str[i]) == strlen(cstr[i]));
         RUNIT_ASSERT(dstr_compare_str(&str[i], cstr[i]) == 0);
     }
 
@@ -131,6 +159,7 @@ void dstr_constructor_test() {
     {
         dstr_ref ref = dstr_make_ref("Hello World!");
         RUNIT_ASSERT(dstr_compare_str(&ref, "Hello World!") == 0);
+        RUNIT_ASSERT(dstr_size(&ref) == 12);
     }
     
     // Buffer
@@ -167,14 +196,14 @@ void dstr_reserve_test() {
     {
         dstr_reserve(&str[0], 0);
 
-        RUNIT_ASSERT(str[0].capacity == 0);
+        RUNIT_ASSERT(dstr_capacity(&str[0]) == DSTR_SSO_CAPACITY);
         RUNIT_ASSERT(dstr_compare_str(&str[1], "") == 0);
     }
     // reserve 32 from 0 capacity dstr
     {
         dstr_reserve(&str[1], 32);
 
-        RUNIT_ASSERT(str[1].capacity == 32);
+        RUNIT_ASSERT(dstr_capacity(&str[1]) == 32);
         RUNIT_ASSERT(dstr_compare_str(&str[1], "") == 0);
     }
     
@@ -182,7 +211,7 @@ void dstr_reserve_test() {
     {
         dstr_reserve(&str[2], 0);
 
-        RUNIT_ASSERT(str[2].capacity == 0);
+        RUNIT_ASSERT(dstr_capacity(&str[2]) == DSTR_SSO_CAPACITY);
         RUNIT_ASSERT(dstr_compare_str(&str[2], "") == 0);
     }
 
@@ -190,7 +219,7 @@ void dstr_reserve_test() {
     {
         dstr_reserve(&str[3], 64);
 
-        RUNIT_ASSERT(str[3].capacity == 64);
+        RUNIT_ASSERT(dstr_capacity(&str[3]) == 64);
         RUNIT_ASSERT(dstr_compare_str(&str[3], "") == 0);
     }
     
@@ -198,7 +227,7 @@ void dstr_reserve_test() {
     {
         dstr_reserve(&str[4], 16);
 
-        RUNIT_ASSERT(str[4].capacity == 16);
+        RUNIT_ASSERT(dstr_capacity(&str[4]) == EXPECTED_CAPACITY(16));
         RUNIT_ASSERT(dstr_compare_str(&str[4], "") == 0);
     }
 
@@ -206,7 +235,7 @@ void dstr_reserve_test() {
     {
         dstr_reserve(&str[5], 32);
 
-        RUNIT_ASSERT(str[5].capacity == 32);
+        RUNIT_ASSERT(dstr_capacity(&str[5]) == 32);
         RUNIT_ASSERT(dstr_compare_str(&str[5], "") == 0);
     }
 
@@ -214,7 +243,7 @@ void dstr_reserve_test() {
     {
         dstr_reserve(&str[6], 16);
 
-        RUNIT_ASSERT(str[6].capacity == 16);
+        RUNIT_ASSERT(dstr_capacity(&str[6]) == EXPECTED_CAPACITY(16));
         RUNIT_ASSERT(dstr_compare_str(&str[6], "abcdefg") == 0);
     }
 
@@ -222,7 +251,7 @@ void dstr_reserve_test() {
     {
         dstr_reserve(&str[7], 8);
 
-        RUNIT_ASSERT(str[7].capacity == 8);
+        RUNIT_ASSERT(dstr_capacity(&str[7]) == EXPECTED_CAPACITY(8));
         RUNIT_ASSERT(dstr_compare_str(&str[7], "abcdefg") == 0);
     }
 
@@ -230,7 +259,7 @@ void dstr_reserve_test() {
     {
         dstr_reserve(&str[8], 8);
 
-        RUNIT_ASSERT(str[8].capacity == 8);
+        RUNIT_ASSERT(dstr_capacity(&str[8]) == EXPECTED_CAPACITY(8));
         RUNIT_ASSERT(dstr_compare_str(&str[8], "abcdefg") == 0);
     }
 
@@ -266,16 +295,16 @@ void dstr_append_test() {
     }
 
     for (size_t i = 0; i < SIZE; ++i) {
-        RUNIT_ASSERT(str[i].size == strlen(cstr[i]));
+        RUNIT_ASSERT(dstr_size(&str[i]) == strlen(cstr[i]));
         RUNIT_ASSERT(dstr_compare_str(&str[i], cstr[i]) == 0);
     }
 
     dstr_append_str(&str[0], "a long string");
     dstr_append_str(&str[1], "nother long string");
 
-    RUNIT_ASSERT(str[0].size == strlen("a long string"));
+    RUNIT_ASSERT(dstr_size(&str[0]) == strlen("a long string"));
     RUNIT_ASSERT(dstr_compare_str(&str[0], "a long string") == 0);
-    RUNIT_ASSERT(str[1].size == strlen("another long string"));
+    RUNIT_ASSERT(dstr_size(&str[1]) == strlen("another long string"));
     RUNIT_ASSERT(dstr_compare_str(&str[1], "another long string") == 0);
 
     dstr_append_char(&str[2], 'e');
@@ -333,16 +362,29 @@ void dstr_shrink_to_fit_test() {
         dstr_shrink_to_fit(&str[i]);
     }
 
-    RUNIT_ASSERT(str[0].size == 0);
-    RUNIT_ASSERT(str[0].capacity == 0);
+    RUNIT_ASSERT(dstr_size(&str[0]) == 0);
+    RUNIT_ASSERT(dstr_capacity(&str[0]) == DSTR_SSO_CAPACITY);
 
-    RUNIT_ASSERT(str[1].size == 0);
-    RUNIT_ASSERT(str[1].capacity == 0);
+    RUNIT_ASSERT(dstr_size(&str[1]) == 0);
+    RUNIT_ASSERT(dstr_capacity(&str[1]) == DSTR_SSO_CAPACITY);
 
     for (size_t i = 2; i < SIZE; ++i) {
-        RUNIT_ASSERT(str[i].size == 10);
+        RUNIT_ASSERT(dstr_size(&str[i]) == 10);
         // +1 for '\0'
-        RUNIT_ASSERT((str[i].size + 1) == str[i].capacity);
+        RUNIT_ASSERT(EXPECTED_CAPACITY(dstr_size(&str[i]) + 1) == dstr_capacity(&str[i]));
+    }
+
+    // Large string is shrunk to its size
+    {
+        dstr large = dstr_make_reserve(256);
+        dstr_append_nchar(&large, 100, 'a');
+        dstr_shrink_to_fit(&large);
+
+        // +1 for '\0'
+        RUNIT_ASSERT(dstr_capacity(&large) == 101);
+        RUNIT_ASSERT(dstr_size(&large) == 100);
+
+        dstr_clear(&large);
     }
 
     for (size_t i = 0; i < SIZE; ++i) {
@@ -406,18 +448,18 @@ void dstr_erase_test() {
     }
     RUNIT_ASSERT(dstr_compare_str(&str[1], "World!") == 0 );
 
-    dstr_erase_range(&str[2], str[2].data + 5, str[2].data + 5 + 7);
+    dstr_erase_range(&str[2], dstr_data(&str[2]) + 5, dstr_data(&str[2]) + 5 + 7);
     RUNIT_ASSERT(dstr_compare_str(&str[2], "Hello") == 0 );
 
-    dstr_erase_range(&str[2], str[2].data , str[2].data + str[2].size);
+    dstr_erase_range(&str[2], dstr_data(&str[2]) , dstr_data(&str[2]) + dstr_size(&str[2]));
 
     RUNIT_ASSERT(dstr_compare_str(&str[2], "") == 0 );
 
-    dstr_erase_range(&str[3], str[3].data , str[3].data + str[3].size);
+    dstr_erase_range(&str[3], dstr_data(&str[3]) , dstr_data(&str[3]) + dstr_size(&str[3]));
 
     RUNIT_ASSERT(dstr_compare_str(&str[3], "") == 0 );
 
-    dstr_erase_range(&str[0], str[0].data , str[0].data + str[0].size);
+    dstr_erase_range(&str[0], dstr_data(&str[0]) , dstr_data(&str[0]) + dstr_size(&str[0]));
 
     RUNIT_ASSERT(dstr_compare_str(&str[0], "") == 0 );
 
@@ -450,12 +492,12 @@ void dstr_resize_test() {
     dstr_resize(&str[4], 7);  // resize between size and capacity
     dstr_resize(&str[5], 16); // resize behond capacity
 
-    RUNIT_ASSERT(str[0].size == 0);
-    RUNIT_ASSERT(str[1].size == 8);
-    RUNIT_ASSERT(str[2].size == 6);
-    RUNIT_ASSERT(str[3].size == 4);
-    RUNIT_ASSERT(str[4].size == 7);
-    RUNIT_ASSERT(str[5].size == 16);
+    RUNIT_ASSERT(dstr_size(&str[0]) == 0);
+    RUNIT_ASSERT(dstr_size(&str[1]) == 8);
+    RUNIT_ASSERT(dstr_size(&str[2]) == 6);
+    RUNIT_ASSERT(dstr_size(&str[3]) == 4);
+    RUNIT_ASSERT(dstr_size(&str[4]) == 7);
+    RUNIT_ASSERT(dstr_size(&str[5]) == 16);
 
     dstr_resize_fill(&str[6],  0, 'b');  // resize to 0
     dstr_resize_fill(&str[7],  8, 'b');  // resize at capacity
@@ -505,9 +547,9 @@ void dstr_replace_test() {
     dstr replacing_less_len = dstr_make_from_str("bbbb");
     dstr replacing_greater_len = dstr_make_from_str("bbbbbbbbbbbb");
 
-    dstr_replace_with_dstr(&str[0], (size_t)0, str[0].size, &replacing_equal_len);
-    dstr_replace_with_dstr(&str[1], (size_t)0, str[1].size, &replacing_less_len);
-    dstr_replace_with_dstr(&str[2], (size_t)0, str[2].size, &replacing_greater_len);
+    dstr_replace_with_dstr(&str[0], (size_t)0, dstr_size(&str[0]), &replacing_equal_len);
+    dstr_replace_with_dstr(&str[1], (size_t)0, dstr_size(&str[1]), &replacing_less_len);
+    dstr_replace_with_dstr(&str[2], (size_t)0, dstr_size(&str[2]), &replacing_greater_len);
 
     dstr_replace_with_str(&str[3], (size_t)0, 4, "bbbb");
     dstr_replace_with_str(&str[4], (size_t)4, 4, "bbbb");
@@ -572,8 +614,138 @@ void dstr_trim_test() {
     for (size_t i = 0; i < SIZE; ++i) {
         RUNIT_ASSERT(dstr_size(&str[i]) == 0);
     }
+
+    // Longer than a SIMD block, all whitespaces
+    {
+        dstr s = dstr_make_from_str(" \t\n\v\f\r   \t\t  \n\n \r\n  content with spaces and\ttabs \v\f\r\n\t                             ");
+        dstr_trim(&s);
+        RUNIT_ASSERT(dstr_compare_str(&s, "content with spaces and\ttabs") == 0);
+
+        dstr_assign_str(&s, "                                                  ");
+        dstr_ltrim(&s);
+        RUNIT_ASSERT(dstr_size(&s) == 0);
+
+        dstr_assign_str(&s, "x                                                 ");
+        dstr_rtrim(&s);
+        RUNIT_ASSERT(dstr_compare_str(&s, "x") == 0);
+
+        // Not whitespaces
+        dstr_assign_str(&s, "\x1F\x0E\xA0 \x08");
+        dstr_trim(&s);
+        RUNIT_ASSERT(dstr_compare_str(&s, "\x1F\x0E\xA0 \x08") == 0);
+
+        dstr_clear(&s);
+    }
+
+    // Last non-whitespace at every position of the SIMD blocks (16 and 32 chars)
+    {
+        dstr s = dstr_make();
+        int all_equal = 1;
+        size_t last;
+
+        for (last = 0; last < 100; ++last) {
+            dstr_assign_nchar(&s, 100, ' ');
+            dstr_data(&s)[last] = 'x';
+            dstr_data(&s)[last / 2] = 'y';
+            dstr_rtrim(&s);
+            all_equal &= dstr_size(&s) == last + 1;
+        }
+        RUNIT_ASSERT(all_equal);
+
+        dstr_clear(&s);
+    }
 } // dstr_trim_test
 
+void dstr_ascii_test() {
+
+    printf("dstr_ascii_test\n");
+
+    // Case conversion
+    {
+        dstr str = dstr_make_from_str("Content-Type: Text/HTML; charset=UTF-8 @[`{ \xC3\x89t\xC3\xA9 0123456789 AZaz");
+
+        dstr_to_lower(&str);
+        RUNIT_ASSERT(dstr_compare_str(&str, "content-type: text/html; charset=utf-8 @[`{ \xC3\x89t\xC3\xA9 0123456789 azaz") == 0);
+
+        dstr_to_upper(&str);
+        RUNIT_ASSERT(dstr_compare_str(&str, "CONTENT-TYPE: TEXT/HTML; CHARSET=UTF-8 @[`{ \xC3\x89T\xC3\xA9 0123456789 AZAZ") == 0);
+
+        dstr_clear(&str);
+    }
+
+    // Collapse
+    {
+        dstr str = dstr_make_from_str("  \t Accept:   text/html,\r\n\t application/xhtml+xml   \n");
+
+        dstr_collapse_whitespace(&str);
+        RUNIT_ASSERT(dstr_compare_str(&str, "Accept: text/html, application/xhtml+xml") == 0);
+
+        dstr_assign_str(&str, " \t\n ");
+        dstr_collapse_whitespace(&str);
+        RUNIT_ASSERT(dstr_size(&str) == 0);
+
+        dstr_assign_str(&str, "a");
+        dstr_collapse_whitespace(&str);
+        RUNIT_ASSERT(dstr_compare_str(&str, "a") == 0);
+
+        dstr_clear(&str);
+    }
+
+    // Compare with a naive implementation on every byte value
+    {
+        char text[200];
+        char expected[200];
+        int all_equal = 1;
+
+        for (size_t round = 0; round < 200; ++round) {
+
+            const size_t size = test_random() % sizeof(text);
+            size_t expected_size = 0;
+            int space_pending = 0;
+
+            for (size_t i = 0; i < size; ++i) {
+                // Mostly whitespaces and letters
+                unsigned int r = test_random() % 4;
+                text[i] = r == 0 ? " \t\n\v\f\r"[test_random() % 6] : r == 1 ? (char)test_random() : (char)('A' + test_random() % 58);
+            }
+
+            dstr str = dstr_make_from_range(text, text + size);
+
+            dstr_to_lower(&str);
+            for (size_t i = 0; i < size; ++i) {
+                char c = (text[i] >= 'A' && text[i] <= 'Z') ? (char)(text[i] + 32) : text[i];
+                all_equal &= dstr_data(&str)[i] == c;
+            }
+
+            dstr_to_upper(&str);
+            for (size_t i = 0; i < size; ++i) {
+                char c = (text[i] >= 'a' && text[i] <= 'z') ? (char)(text[i] - 32) : text[i];
+                all_equal &= dstr_data(&str)[i] == c;
+            }
+
+            dstr_assign_range(&str, text, text + size);
+            dstr_collapse_whitespace(&str);
+            for (size_t i = 0; i < size; ++i) {
+                char c = text[i];
+                if (c == ' ' || (c >= '\t' && c <= '\r')) {
+                    space_pending = expected_size != 0;
+                } else {
+                    if (space_pending) {
+                        expected[expected_size++] = ' ';
+                        space_pending = 0;
+                    }
+                    expected[expected_size++] = c;
+                }
+            }
+            all_equal &= dstr_size(&str) == expected_size && memcmp(dstr_data(&str), expected, expected_size) == 0;
+
+            dstr_clear(&str);
+        }
+
+        RUNIT_ASSERT(all_equal, "ASCII transforms differ from naive implementation");
+    }
+} // dstr_ascii_test
+
 void dstr_find_and_replace_test() {
 
     printf("dstr_find_and_replace_test\n");
@@ -677,9 +849,251 @@ void dstr_find_and_replace_test() {
         dstr_clear(&d0);
     }
 
+    // Number of replacements
+    {
+        dstr d0 = dstr_make_from_str("{x} and {x} or {y}");
+
+        RUNIT_ASSERT(dstr_find_and_replace(&d0, "{x}", "longer value") == 2);
+        RUNIT_ASSERT(dstr_compare_str(&d0, "longer value and longer value or {y}") == 0);
+
+        RUNIT_ASSERT(dstr_find_and_replace(&d0, "{y}", "y") == 1);
+        RUNIT_ASSERT(dstr_compare_str(&d0, "longer value and longer value or y") == 0);
+
+        RUNIT_ASSERT(dstr_find_and_replace(&d0, "{z}", "z") == 0);
+        RUNIT_ASSERT(dstr_find_and_replace(&d0, "", "z") == 0);
+
+        dstr_clear(&d0);
+    }
+
+    // Embedded '\0'
+    {
+        dstr d0 = dstr_make_from_range((dstr_it)"a\0b\0c", (dstr_it)"a\0b\0c" + 5);
+        dstr t = dstr_make_from_range((dstr_it)"\0", (dstr_it)"\0" + 1);
+        dstr w = dstr_make_from_str("--");
+
+        RUNIT_ASSERT(dstr_find_and_replace_dstr(&d0, &t, &w) == 2);
+        RUNIT_ASSERT(dstr_compare_str(&d0, "a--b--c") == 0);
+        RUNIT_ASSERT(dstr_size(&d0) == 7);
+
+        dstr_clear(&d0);
+        dstr_clear(&t);
+        dstr_clear(&w);
+    }
+
+    // Many placeholders, growing and shrinking
+    {
+        enum {
+            COUNT = 5000
+        };
+
+        dstr d0 = dstr_make();
+        dstr expected = dstr_make();
+
+        for (size_t i = 0; i < COUNT; ++i) {
+            dstr_append_str(&d0, "text $name$ ");
+            dstr_append_str(&expected, "text placeholder value ");
+        }
+
+        RUNIT_ASSERT(dstr_find_and_replace(&d0, "$name$", "placeholder value") == COUNT);
+        RUNIT_ASSERT(dstr_compare_dstr(&d0, &expected) == 0);
+
+        RUNIT_ASSERT(dstr_find_and_replace(&d0, "placeholder value", "$") == COUNT);
+        RUNIT_ASSERT(dstr_find_and_replace(&expected, "placeholder value", "$") == COUNT);
+        RUNIT_ASSERT(dstr_size(&d0) == COUNT * strlen("text $ "));
+        RUNIT_ASSERT(dstr_compare_dstr(&d0, &expected) == 0);
+
+        dstr_clear(&d0);
+        dstr_clear(&expected);
+    }
 
 } // dstr_find_and_replace_test
 
+void dstr_append_integer_test() {
+
+    printf("dstr_append_integer_test\n");
+
+    // Decimal
+    {
+        dstr str = dstr_make();
+
+        dstr_append_u64(&str, 0);
+        RUNIT_ASSERT(dstr_compare_str(&str, "0") == 0);
+
+        dstr_assign_str(&str, "x=");
+        dstr_append_i64(&str, -42);
+        RUNIT_ASSERT(dstr_compare_str(&str, "x=-42") == 0);
+
+        dstr_assign_str(&str, "");
+        dstr_append_u64(&str, UINT64_MAX);
+        RUNIT_ASSERT(dstr_compare_str(&str, "18446744073709551615") == 0);
+
+        dstr_assign_str(&str, "");
+        dstr_append_i64(&str, INT64_MIN);
+        RUNIT_ASSERT(dstr_compare_str(&str, "-9223372036854775808") == 0);
+
+        dstr_assign_str(&str, "");
+        dstr_append_i64(&str, INT64_MAX);
+        RUNIT_ASSERT(dstr_compare_str(&str, "9223372036854775807") == 0);
+
+        dstr_clear(&str);
+    }
+
+    // Hexadecimal
+    {
+        dstr str = dstr_make();
+
+        dstr_append_hex(&str, 0);
+        dstr_append_char(&str, ' ');
+        dstr_append_hex(&str, 0xdeadbeef);
+        dstr_append_char(&str, ' ');
+        dstr_append_hex(&str, UINT64_MAX);
+        RUNIT_ASSERT(dstr_compare_str(&str, "0 deadbeef ffffffffffffffff") == 0);
+
+        dstr_clear(&str);
+    }
+
+    // Padded
+    {
+        dstr str = dstr_make();
+
+        dstr_append_u64_padded(&str, 7, 3);
+        dstr_append_char(&str, ' ');
+        dstr_append_i64_padded(&str, -7, 4);
+        dstr_append_char(&str, ' ');
+        dstr_append_hex_padded(&str, 0xab, 8);
+        dstr_append_char(&str, ' ');
+        dstr_append_u64_padded(&str, 12345, 2); // not truncated
+        RUNIT_ASSERT(dstr_compare_str(&str, "007 -007 000000ab 12345") == 0);
+
+        dstr_clear(&str);
+    }
+
+    // Same result as printf for every digit count
+    {
+        dstr str = dstr_make();
+        char expected[32];
+        int all_equal = 1;
+        uint64_t value = 1;
+
+        for (size_t i = 0; i < 20; ++i) {
+            uint64_t values[3] = { value - 1, value, value + 1 };
+            for (size_t j = 0; j < 3; ++j) {
+                dstr_assign_str(&str, "");
+                dstr_append_u64(&str, values[j]);
+                snprintf(expected, sizeof(expected), "%llu", (unsigned long long)values[j]);
+                all_equal &= dstr_compare_str(&str, expected) == 0;
+
+                dstr_assign_str(&str, "");
+                dstr_append_i64(&str, -(int64_t)(values[j] >> 1));
+                snprintf(expected, sizeof(expected), "%lld", -(long long)(values[j] >> 1));
+                all_equal &= dstr_compare_str(&str, expected) == 0;
+
+                dstr_assign_str(&str, "");
+                dstr_append_hex(&str, values[j]);
+                snprintf(expected, sizeof(expected), "%llx", (unsigned long long)values[j]);
+                all_equal &= dstr_compare_str(&str, expected) == 0;
+            }
+            value *= 10;
+        }
+
+        RUNIT_ASSERT(all_equal, "integer append differs from printf");
+
+        dstr_clear(&str);
+    }
+} // dstr_append_integer_test
+
+void dstr_fmt_test() {
+
+    printf("dstr_fmt_test\n");
+
+    // Append, fits in the inline buffer then grows
+    {
+        dstr str = dstr_make();
+
+        RUNIT_ASSERT(dstr_append_fmt(&str, "%d-%s", 42, "abc") == 6);
+        RUNIT_ASSERT(dstr_compare_str(&str, "42-abc") == 0);
+
+        // Exactly fills the inline buffer
+        RUNIT_ASSERT(dstr_append_fmt(&str, "%017d", 1) == 17);
+        RUNIT_ASSERT(dstr_size(&str) == DSTR_SSO_CAPACITY - 1);
+        RUNIT_ASSERT(dstr_compare_str(&str, "42-abc00000000000000001") == 0);
+
+        RUNIT_ASSERT(dstr_append_fmt(&str, "%s", "-this-one-does-not-fit") == 22);
+        RUNIT_ASSERT(dstr_compare_str(&str, "42-abc00000000000000001-this-one-does-not-fit") == 0);
+        RUNIT_ASSERT(dstr_size(&str) == 45);
+
+        dstr_clear(&str);
+    }
+
+    // Assign
+    {
+        dstr str = dstr_make_from_str("previous content, long enough to be allocated");
+
+        RUNIT_ASSERT(dstr_assign_fmt(&str, "%s=%u", "key", 7u) == 5);
+        RUNIT_ASSERT(dstr_compare_str(&str, "key=7") == 0);
+
+        dstr_clear(&str);
+    }
+
+    // Bounded, nothing is allocated
+    {
+        char buffer[8];
+        dstr str = dstr_make_with_buffer(buffer, sizeof(buffer));
+
+        RUNIT_ASSERT(dstr_assign_fmtb(&str, "%d", 123) == 3);
+        RUNIT_ASSERT(dstr_compare_str(&str, "123") == 0);
+
+        // Truncated to the capacity
+        RUNIT_ASSERT(dstr_append_fmtb(&str, "%s", "456789") == 6);
+        RUNIT_ASSERT(dstr_compare_str(&str, "1234567") == 0);
+        RUNIT_ASSERT(dstr_data(&str) == buffer);
+
+        // Full
+        RUNIT_ASSERT(dstr_append_fmtb(&str, "%s", "8") == 1);
+        RUNIT_ASSERT(dstr_compare_str(&str, "1234567") == 0);
+
+        dstr_clear(&str);
+    }
+
+    // Bounded in the inline buffer
+    {
+        dstr str = dstr_make();
+
+        RUNIT_ASSERT(dstr_append_fmtb(&str, "%s", "0123456789012345678901234567890123456789") == 40);
+        RUNIT_ASSERT(dstr_size(&str) == DSTR_SSO_CAPACITY - 1);
+        RUNIT_ASSERT(memcmp(dstr_data(&str), "0123456789012345678901234567890123456789", DSTR_SSO_CAPACITY - 1) == 0);
+        RUNIT_ASSERT(dstr_data(&str)[DSTR_SSO_CAPACITY - 1] == '\0');
+
+        dstr_append_char(&str, '!');
+        RUNIT_ASSERT(dstr_size(&str) == DSTR_SSO_CAPACITY);
+
+        dstr_clear(&str);
+    }
+
+    // Bounded with a shared buffer, nothing is copied
+    {
+        dstr str = dstr_make_from_str("a string which can't be stored inline");
+        dstr shared;
+        dstr_init(&shared);
+        dstr_reserve(&str, 100);
+        dstr_assign_shared(&shared, &str);
+
+        RUNIT_ASSERT(dstr_append_fmtb(&shared, "%d", 123) == 3);
+        RUNIT_ASSERT(dstr_is_shared(&shared));
+        RUNIT_ASSERT(dstr_data(&shared) == dstr_data(&str));
+        RUNIT_ASSERT(dstr_compare_str(&str, "a string which can't be stored inline") == 0);
+
+        // Assigning leaves the shared buffer
+        RUNIT_ASSERT(dstr_assign_fmtb(&shared, "%d", 123) == 3);
+        RUNIT_ASSERT(dstr_compare_str(&shared, "123") == 0);
+        RUNIT_ASSERT(!dstr_is_shared(&str));
+        RUNIT_ASSERT(dstr_compare_str(&str, "a string which can't be stored inline") == 0);
+
+        dstr_clear(&shared);
+        dstr_clear(&str);
+    }
+} // dstr_fmt_test
+
 
 
 void dstr_find_test() {
@@ -710,14 +1124,833 @@ void dstr_find_test() {
         dstr_clear(&sub2);
     }
 
+    // Compare with a naive search, on repetitive content and on every block boundary
+    {
+        enum {
+            TEXT_SIZE = 200
+        };
+
+        char text[TEXT_SIZE];
+        for (size_t i = 0; i < TEXT_SIZE; ++i) {
+            text[i] = (i % 7) ? 'a' : 'b';
+        }
+
+        const char* patterns[] = {
+            "ab", "ba", "aab", "aaaaaab", "baaaaaab", "abaaaaaab", "aaaaaa", "aaaaaaa",
+            "baaaaaabaaaaaabaaaaaabaaaaaabaaaaaab", "zz", "az"
+        };
+
+        int all_equal = 1;
+
+        for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); ++p) {
+
+            const size_t patt_len = strlen(patterns[p]);
+
+            for (size_t len = 0; len < TEXT_SIZE; ++len) {
+
+                const char* expected = 0;
+                for (size_t i = 0; i + patt_len <= len; ++i) {
+                    if (memcmp(text + i, patterns[p], patt_len) == 0) {
+                        expected = text + i;
+                        break;
+                    }
+                }
+
+                all_equal &= _dstr_memory_find(text, len, patterns[p], patt_len) == expected;
+                all_equal &= _dstr_memory_find_scalar(text, len, patterns[p], patt_len) == expected || patt_len > len;
+            }
+        }
+
+        RUNIT_ASSERT(all_equal, "_dstr_memory_find differs from naive search");
+    }
+
+    // Match at the very end of the string
+    {
+        dstr str = dstr_make_from_nchar(1000, 'a');
+        dstr sub = dstr_make_from_str("aab");
+
+        dstr_append_char(&str, 'b');
+
+        RUNIT_ASSERT(dstr_find_dstr(&str, 0, &sub) == 998);
+        RUNIT_ASSERT(dstr_find_dstr(&str, 998, &sub) == 998);
+        RUNIT_ASSERT(dstr_find_dstr(&str, 999, &sub) == DSTR_NPOS);
+
+        dstr_clear(&str);
+        dstr_clear(&sub);
+    }
+
 } // dstr_find_test
 
+void dstr_sso_test() {
+
+    printf("dstr_sso_test\n");
+
+    RUNIT_ASSERT(sizeof(dstr) == sizeof(char*) + sizeof(size_t) * 2);
+
+    // Inline until DSTR_SSO_CAPACITY - 1 chars
+    {
+        dstr str = dstr_make();
+        const char* inline_begin = (const char*)&str;
+        const char* inline_end   = inline_begin + sizeof(dstr);
+
+        for (size_t i = 0; i < DSTR_SSO_CAPACITY - 1; ++i) {
+            dstr_append_char(&str, (char)('a' + i % 26));
+
+            RUNIT_ASSERT(dstr_size(&str) == i + 1);
+            RUNIT_ASSERT(dstr_capacity(&str) == DSTR_SSO_CAPACITY);
+            RUNIT_ASSERT(dstr_data(&str) >= inline_begin && dstr_data(&str) < inline_end);
+            RUNIT_ASSERT(dstr_data(&str)[i + 1] == '\0');
+        }
+
+        // Goes to the heap
+        dstr_append_char(&str, 'z');
+
+        RUNIT_ASSERT(dstr_size(&str) == DSTR_SSO_CAPACITY);
+        RUNIT_ASSERT(dstr_capacity(&str) > DSTR_SSO_CAPACITY);
+        RUNIT_ASSERT(dstr_data(&str) < inline_begin || dstr_data(&str) >= inline_end);
+        RUNIT_ASSERT(dstr_data(&str)[DSTR_SSO_CAPACITY - 1] == 'z');
+
+        // Goes back inline
+        dstr_pop_back(&str);
+        dstr_shrink_to_fit(&str);
+
+        RUNIT_ASSERT(dstr_size(&str) == DSTR_SSO_CAPACITY - 1);
+        RUNIT_ASSERT(dstr_capacity(&str) == DSTR_SSO_CAPACITY);
+        RUNIT_ASSERT(dstr_data(&str) >= inline_begin && dstr_data(&str) < inline_end);
+        RUNIT_ASSERT(dstr_data(&str)[DSTR_SSO_CAPACITY - 1] == '\0');
+
+        dstr_clear(&str);
+    }
+
+    // Swap small and large strings
+    {
+        dstr small = dstr_make_from_str("small");
+        dstr large = dstr_make_from_str("a string which can't be stored inline");
+
+        dstr_swap(&small, &large);
+
+        RUNIT_ASSERT(dstr_compare_str(&small, "a string which can't be stored inline") == 0);
+        RUNIT_ASSERT(dstr_compare_str(&large, "small") == 0);
+
+        dstr_clear(&small);
+        dstr_clear(&large);
+    }
+
+    // Non-owned buffer is left untouched when more capacity is needed
+    {
+        char buffer[8] = "";
+        dstr buf = dstr_make_with_buffer(buffer, 8);
+
+        dstr_append_str(&buf, "abc");
+        RUNIT_ASSERT(dstr_data(&buf) == buffer);
+
+        dstr_append_str(&buf, "a string which can't be stored inline");
+        RUNIT_ASSERT(dstr_data(&buf) != buffer);
+        RUNIT_ASSERT(dstr_compare_str(&buf, "abca string which can't be stored inline") == 0);
+        RUNIT_ASSERT(strcmp(buffer, "abc") == 0);
+
+        dstr_clear(&buf);
+    }
+} // dstr_sso_test
+
+// Counts allocations, uses malloc
+typedef struct counting_allocator_data {
+    size_t alloc_count;
+    size_t free_count;
+    size_t bytes_in_use;
+} counting_allocator_data;
+
+void* counting_alloc(void* user_data, size_t size) {
+    counting_allocator_data* d = (counting_allocator_data*)user_data;
+    ++d->alloc_count;
+    d->bytes_in_use += size;
+    return malloc(size);
+}
+
+void* counting_realloc(void* user_data, void* ptr, size_t old_size, size_t new_size) {
+    counting_allocator_data* d = (counting_allocator_data*)user_data;
+    d->bytes_in_use += new_size - old_size;
+    return realloc(ptr, new_size);
+}
+
+void counting_free(void* user_data, void* ptr, size_t size) {
+    counting_allocator_data* d = (counting_allocator_data*)user_data;
+    ++d->free_count;
+    d->bytes_in_use -= size;
+    free(ptr);
+}
+
+void dstr_allocator_test() {
+
+    printf("dstr_allocator_test\n");
+
+    counting_allocator_data data = { 0, 0, 0 };
+    dstr_allocator counting = {
+        counting_alloc,
+        counting_realloc,
+        counting_free,
+        &data
+    };
+
+    RUNIT_ASSERT(dstr_get_thread_allocator() == &dstr_malloc_allocator);
+
+    // Per dstr allocator
+    {
+        dstr str;
+        dstr_init_with_allocator(&str, &counting);
+
+        RUNIT_ASSERT(dstr_get_allocator(&str) == &counting);
+
+        // Small strings don't allocate
+        dstr_append_str(&str, "abc");
+        RUNIT_ASSERT(data.alloc_count == 0);
+        RUNIT_ASSERT(dstr_compare_str(&str, "abc") == 0);
+
+        dstr_append_str(&str, "a string which can't be stored inline");
+        RUNIT_ASSERT(data.alloc_count == 1);
+        RUNIT_ASSERT(data.bytes_in_use > dstr_size(&str));
+        RUNIT_ASSERT(dstr_compare_str(&str, "abca string which can't be stored inline") == 0);
+
+        // The allocator is kept after clear
+        dstr_clear(&str);
+        RUNIT_ASSERT(data.free_count == 1);
+        RUNIT_ASSERT(data.bytes_in_use == 0);
+        RUNIT_ASSERT(dstr_get_allocator(&str) == &counting);
+
+        // The allocator is kept when the string goes back inline
+        dstr_assign_nchar(&str, 100, 'a');
+        dstr_resize(&str, 4);
+        dstr_shrink_to_fit(&str);
+        RUNIT_ASSERT(dstr_compare_str(&str, "aaaa") == 0);
+        RUNIT_ASSERT(dstr_capacity(&str) < DSTR_SSO_CAPACITY);
+        RUNIT_ASSERT(dstr_get_allocator(&str) == &counting);
+        RUNIT_ASSERT(data.alloc_count == data.free_count);
+
+        dstr_clear(&str);
+        RUNIT_ASSERT(data.bytes_in_use == 0);
+    }
+
+    // Thread allocator
+    {
+        dstr_set_thread_allocator(&counting);
+
+        dstr str = dstr_make_from_str("a string which can't be stored inline");
+
+        // The buffer remembers its allocator, the string doesn't
+        dstr_set_thread_allocator(0);
+
+        RUNIT_ASSERT(dstr_get_thread_allocator() == &dstr_malloc_allocator);
+        RUNIT_ASSERT(dstr_get_allocator(&str) == &dstr_malloc_allocator);
+        RUNIT_ASSERT(dstr_get_attached_allocator(&str) == 0);
+        RUNIT_ASSERT(data.bytes_in_use > 0);
+
+        dstr_clear(&str);
+        RUNIT_ASSERT(data.bytes_in_use == 0);
+        RUNIT_ASSERT(data.alloc_count == data.free_count);
+
+        // Later allocations use the current thread allocator
+        dstr_append_str(&str, "another string which can't be stored inline");
+        RUNIT_ASSERT(data.bytes_in_use == 0);
+        RUNIT_ASSERT(data.alloc_count == data.free_count);
+
+        dstr_clear(&str);
+    }
+
+    // Growing a buffer from a previous thread allocator
+    {
+        size_t alloc_count;
+        dstr str;
+
+        dstr_set_thread_allocator(&counting);
+        str = dstr_make_from_str("a string which can't be stored inline");
+        dstr_set_thread_allocator(0);
+
+        alloc_count = data.alloc_count;
+        dstr_reserve(&str, 1000);
+        RUNIT_ASSERT(data.alloc_count == alloc_count);
+        RUNIT_ASSERT(data.bytes_in_use == 0);
+        RUNIT_ASSERT(dstr_compare_str(&str, "a string which can't be stored inline") == 0);
+
+        dstr_clear(&str);
+    }
+
+    // Attaching the thread allocator
+    {
+        dstr str;
+        dstr_init_with_allocator(&str, &counting);
+
+        // The attachment doesn't depend on the thread allocator of the moment
+        dstr_set_thread_allocator(&counting);
+        dstr_reserve(&str, 20);
+        dstr_append_str(&str, "abc");
+        dstr_set_thread_allocator(0);
+
+        RUNIT_ASSERT(dstr_get_allocator(&str) == &counting);
+        RUNIT_ASSERT(dstr_get_attached_allocator(&str) == &counting);
+
+        dstr_append_str(&str, "a string which can't be stored inline");
+        RUNIT_ASSERT(data.bytes_in_use > 0);
+        RUNIT_ASSERT(dstr_get_attached_allocator(&str) == &counting);
+
+        // Kept by clear
+        dstr_clear(&str);
+        RUNIT_ASSERT(data.bytes_in_use == 0);
+        RUNIT_ASSERT(dstr_get_attached_allocator(&str) == &counting);
+
+        dstr_clear(&str);
+        RUNIT_ASSERT(data.alloc_count == data.free_count);
+    }
+} // dstr_allocator_test
+
+void dstr_growth_test() {
+
+    printf("dstr_growth_test\n");
+
+    RUNIT_ASSERT(dstr_get_thread_growth_policy() == &dstr_default_growth_policy);
+
+    // Default policy, +50%
+    {
+        dstr str = dstr_make_reserve(100);
+
+        dstr_append_nchar(&str, 100, 'a');
+        RUNIT_ASSERT(dstr_capacity(&str) == 150);
+
+        dstr_clear(&str);
+    }
+
+    // Doubling, with a minimum
+    {
+        dstr_growth_policy doubling = { 100, 256, 0 };
+        dstr str = dstr_make();
+
+        dstr_set_thread_growth_policy(&doubling);
+
+        dstr_append_nchar(&str, DSTR_SSO_CAPACITY, 'a');
+        RUNIT_ASSERT(dstr_capacity(&str) == 256);
+
+        dstr_append_nchar(&str, 256, 'a');
+        RUNIT_ASSERT(dstr_capacity(&str) == 512);
+
+        // Needed capacity is greater than the growth
+        dstr_append_nchar(&str, 2000, 'a');
+        RUNIT_ASSERT(dstr_capacity(&str) == DSTR_SSO_CAPACITY + 256 + 2000 + 1);
+
+        dstr_set_thread_growth_policy(0);
+        RUNIT_ASSERT(dstr_get_thread_growth_policy() == &dstr_default_growth_policy);
+
+        dstr_clear(&str);
+    }
+
+    // Blocks rounded to powers of two
+    {
+        dstr_growth_policy rounded = { 50, 8, 1 };
+        dstr str = dstr_make();
+        size_t i;
+        int all_rounded = 1;
+
+        dstr_set_thread_growth_policy(&rounded);
+
+        for (i = 0; i < 5000; ++i) {
+            size_t block_size;
+            dstr_append_char(&str, 'a');
+            block_size = dstr_capacity(&str) + sizeof(_dstr_block);
+            all_rounded &= dstr_capacity(&str) == DSTR_SSO_CAPACITY || (block_size & (block_size - 1)) == 0;
+        }
+        RUNIT_ASSERT(all_rounded);
+
+        dstr_set_thread_growth_policy(0);
+        dstr_clear(&str);
+    }
+
+#ifdef DSTR_STATS
+    {
+        dstr_stats stats;
+        dstr str = dstr_make();
+        dstr copy;
+
+        dstr_reset_stats();
+
+        dstr_append_nchar(&str, 100, 'a');   // allocation, '\0' copied
+        dstr_append_nchar(&str, 100, 'b');   // growth, reallocated
+        copy = dstr_make_shared(&str);
+        dstr_append_char(&copy, 'c');        // growth of the shared buffer, 201 bytes copied
+        dstr_clear(&copy);
+        dstr_clear(&str);
+
+        dstr_get_stats(&stats);
+        RUNIT_ASSERT(stats.allocations == 2);
+        RUNIT_ASSERT(stats.frees == 2);
+        RUNIT_ASSERT(stats.reallocations == 1);
+        RUNIT_ASSERT(stats.reserve_calls == 3);
+        RUNIT_ASSERT(stats.copied_bytes == 1 + 201);
+        RUNIT_ASSERT(stats.peak_capacity == 201 + 100);
+
+        dstr_reset_stats();
+        dstr_get_stats(&stats);
+        RUNIT_ASSERT(stats.allocations == 0 && stats.peak_capacity == 0);
+    }
+#endif
+} // dstr_growth_test
+
+void dstr_huge_test() {
+
+    printf("dstr_huge_test\n");
+
+    // Owned buffers grow with realloc
+    {
+        counting_allocator_data data = { 0, 0, 0 };
+        dstr_allocator counting = {
+            counting_alloc,
+            counting_realloc,
+            counting_free,
+            &data
+        };
+        dstr str;
+        size_t i;
+
+        dstr_init_with_allocator(&str, &counting);
+        for (i = 0; i < 10000; ++i) {
+            dstr_append_char(&str, (char)('a' + i % 26));
+        }
+
+        RUNIT_ASSERT(data.alloc_count == 1);
+        RUNIT_ASSERT(data.bytes_in_use == sizeof(_dstr_block) + dstr_capacity(&str));
+        RUNIT_ASSERT(dstr_get(&str, 9999) == 'a' + 9999 % 26);
+
+        dstr_shrink_to_fit(&str);
+        RUNIT_ASSERT(dstr_capacity(&str) == 10001);
+        RUNIT_ASSERT(data.alloc_count == 1);
+
+        dstr_clear(&str);
+        RUNIT_ASSERT(data.bytes_in_use == 0);
+    }
+
+    // Mapped blocks above the threshold
+    {
+        dstr_huge_options options[2] = { { 64 * 1024, 0 }, { 64 * 1024, 1 } };
+        size_t k;
+
+        for (k = 0; k < 2; ++k) {
+            dstr_allocator huge = dstr_make_huge_allocator(&options[k]);
+            dstr str;
+            size_t i;
+            int all_equal = 1;
+
+            dstr_init_with_allocator(&str, &huge);
+
+            // From malloc to mapped blocks
+            for (i = 0; i < 3 * 1024 * 1024; ++i) {
+                dstr_append_char(&str, (char)('a' + i % 26));
+            }
+            for (i = 0; i < dstr_size(&str); i += 4093) {
+                all_equal &= dstr_get(&str, i) == (char)('a' + i % 26);
+            }
+            RUNIT_ASSERT(all_equal);
+            RUNIT_ASSERT(dstr_get(&str, 3 * 1024 * 1024 - 1) == 'a' + (3 * 1024 * 1024 - 1) % 26);
+
+            // Back to malloc
+            dstr_resize(&str, 1000);
+            dstr_shrink_to_fit(&str);
+            RUNIT_ASSERT(dstr_capacity(&str) == 1001);
+            RUNIT_ASSERT(dstr_get(&str, 999) == 'a' + 999 % 26);
+
+            dstr_clear(&str);
+        }
+    }
+
+    // Default options
+    {
+        dstr str;
+
+        dstr_init_with_allocator(&str, &dstr_huge_allocator);
+        dstr_reserve(&str, DSTR_HUGE_THRESHOLD);
+        dstr_append_str(&str, "mapped");
+        dstr_reserve(&str, 2 * DSTR_HUGE_THRESHOLD);
+        RUNIT_ASSERT(dstr_compare_str(&str, "mapped") == 0);
+
+        dstr_clear(&str);
+    }
+} // dstr_huge_test
+
+// Naive search used as reference
+size_t naive_find(const char* text, size_t text_size, size_t pos, const char* pattern, size_t pattern_size) {
+    for (size_t i = pos; pattern_size && i + pattern_size <= text_size; ++i) {
+        if (memcmp(text + i, pattern, pattern_size) == 0) {
+            return i;
+        }
+    }
+    return DSTR_NPOS;
+}
+
+size_t naive_rfind(const char* text, size_t text_size, size_t pos, const char* pattern, size_t pattern_size) {
+    size_t result = DSTR_NPOS;
+    for (size_t i = 0; pattern_size && i + pattern_size <= text_size && i <= pos; ++i) {
+        if (memcmp(text + i, pattern, pattern_size) == 0) {
+            result = i;
+        }
+    }
+    return result;
+}
+
+void dstr_searcher_test() {
+
+    printf("dstr_searcher_test\n");
+
+    // Simple cases
+    {
+        dstr str = dstr_make_from_str("Hello World! Hello World!");
+        dstr_searcher searcher;
+        size_t positions[4];
+
+        dstr_searcher_init(&searcher, "World", 5);
+
+        RUNIT_ASSERT(dstr_searcher_find(&searcher, &str, 0) == 6);
+        RUNIT_ASSERT(dstr_searcher_find(&searcher, &str, 7) == 19);
+        RUNIT_ASSERT(dstr_searcher_find(&searcher, &str, 20) == DSTR_NPOS);
+        RUNIT_ASSERT(dstr_searcher_rfind(&searcher, &str, DSTR_NPOS) == 19);
+        RUNIT_ASSERT(dstr_searcher_rfind(&searcher, &str, 18) == 6);
+        RUNIT_ASSERT(dstr_searcher_rfind(&searcher, &str, 5) == DSTR_NPOS);
+        RUNIT_ASSERT(dstr_searcher_find_all(&searcher, &str, 0, positions, 4) == 2);
+        RUNIT_ASSERT(positions[0] == 6 && positions[1] == 19);
+        RUNIT_ASSERT(dstr_searcher_find_all(&searcher, &str, 0, positions, 1) == 1);
+
+        dstr_searcher_clear(&searcher);
+
+        // Empty pattern is never found
+        dstr_searcher_init(&searcher, "", 0);
+        RUNIT_ASSERT(dstr_searcher_find(&searcher, &str, 0) == DSTR_NPOS);
+        RUNIT_ASSERT(dstr_searcher_rfind(&searcher, &str, DSTR_NPOS) == DSTR_NPOS);
+        RUNIT_ASSERT(dstr_searcher_find_all(&searcher, &str, 0, positions, 4) == 0);
+        dstr_searcher_clear(&searcher);
+
+        dstr_clear(&str);
+    }
+
+    // Compare with naive search on small alphabets (periodic patterns, repetitive texts)
+    {
+        enum {
+            TEXT_SIZE = 400,
+            MAX_POSITIONS = TEXT_SIZE
+        };
+
+        char text[TEXT_SIZE];
+        char pattern[80];
+        size_t positions[MAX_POSITIONS];
+        int all_equal = 1;
+
+        for (size_t round = 0; round < 400; ++round) {
+
+            const unsigned int alphabet = 2 + round % 3;
+            const size_t text_size = test_random() % TEXT_SIZE;
+            const size_t pattern_size = 1 + test_random() % (round % 2 ? 8 : 79);
+
+            for (size_t i = 0; i < text_size; ++i) {
+                text[i] = (char)('a' + test_random() % alphabet);
+            }
+            if (round % 4 == 0) {
+                // periodic pattern
+                size_t period = 1 + test_random() % 5;
+                for (size_t i = 0; i < pattern_size; ++i) {
+                    pattern[i] = i < period ? (char)('a' + test_random() % alphabet) : pattern[i - period];
+                }
+            } else if (text_size > pattern_size) {
+                // pattern from the text
+                memcpy(pattern, text + test_random() % (text_size - pattern_size), pattern_size);
+            } else {
+                for (size_t i = 0; i < pattern_size; ++i) {
+                    pattern[i] = (char)('a' + test_random() % alphabet);
+                }
+            }
+
+            dstr str = dstr_make_from_range(text, text + text_size);
+            dstr_searcher searcher;
+            dstr_searcher_init(&searcher, pattern, pattern_size);
+
+            for (size_t pos = 0; pos <= text_size; pos += 1 + test_random() % 16) {
+                all_equal &= dstr_searcher_find(&searcher, &str, pos) == naive_find(text, text_size, pos, pattern, pattern_size);
+                all_equal &= dstr_searcher_rfind(&searcher, &str, pos) == naive_rfind(text, text_size, pos, pattern, pattern_size);
+            }
+            all_equal &= dstr_searcher_rfind(&searcher, &str, DSTR_NPOS) == naive_rfind(text, text_size, DSTR_NPOS, pattern, pattern_size);
+
+            // Non-overlapping occurrences
+            size_t count = dstr_searcher_find_all(&searcher, &str, 0, positions, MAX_POSITIONS);
+            size_t expected_count = 0;
+            size_t expected = naive_find(text, text_size, 0, pattern, pattern_size);
+            while (expected != DSTR_NPOS) {
+                all_equal &= expected_count < count && positions[expected_count] == expected;
+                ++expected_count;
+                expected = naive_find(text, text_size, expected + pattern_size, pattern, pattern_size);
+            }
+            all_equal &= count == expected_count;
+
+            dstr_searcher_clear(&searcher);
+            dstr_clear(&str);
+        }
+
+        RUNIT_ASSERT(all_equal, "dstr_searcher differs from naive search");
+    }
+} // dstr_searcher_test
+
+void dstr_view_test() {
+
+    printf("dstr_view_test\n");
+
+    // Substrings point inside the string
+    {
+        dstr str = dstr_make_from_str("Content-Type: text/html; charset=utf-8");
+        dstr_view v = dstr_substr(&str, 14, 9);
+
+        RUNIT_ASSERT(v.data == dstr_data(&str) + 14 && v.size == 9);
+        RUNIT_ASSERT(dstr_view_equals(v, dstr_view_make_from_str("text/html")));
+
+        // Count and position are reduced to the string
+        RUNIT_ASSERT(dstr_substr(&str, 33, DSTR_NPOS).size == 5);
+        RUNIT_ASSERT(dstr_substr(&str, 100, 2).size == 0);
+
+        RUNIT_ASSERT(dstr_view_equals(dstr_view_prefix(v, 4), dstr_view_make_from_str("text")));
+        RUNIT_ASSERT(dstr_view_equals(dstr_view_suffix(v, 4), dstr_view_make_from_str("html")));
+        RUNIT_ASSERT(dstr_view_equals(dstr_view_suffix(v, 40), v));
+        RUNIT_ASSERT(dstr_view_equals(dstr_view_substr(v, 5, 2), dstr_view_make_from_str("ht")));
+
+        RUNIT_ASSERT(dstr_starts_with(&str, dstr_view_make_from_str("Content-")));
+        RUNIT_ASSERT(!dstr_starts_with(&str, dstr_view_make_from_str("content-")));
+        RUNIT_ASSERT(dstr_ends_with(&str, dstr_view_make_from_str("utf-8")));
+        RUNIT_ASSERT(dstr_ends_with(&str, dstr_view_make(0, 0)));
+
+        RUNIT_ASSERT(dstr_find_view(&str, 0, dstr_view_make_from_str("charset")) == 25);
+        RUNIT_ASSERT(dstr_view_find(v, 0, dstr_view_make_from_str("html")) == 5);
+        RUNIT_ASSERT(dstr_view_find(v, 6, dstr_view_make_from_str("html")) == DSTR_NPOS);
+        RUNIT_ASSERT(dstr_view_find_char(v, 0, '/') == 4);
+        RUNIT_ASSERT(dstr_view_find_char(v, 5, '/') == DSTR_NPOS);
+
+        RUNIT_ASSERT(dstr_compare_view(&str, dstr_view_make_from_str("Content-Type")) > 0);
+        RUNIT_ASSERT(dstr_view_compare(v, dstr_view_make_from_str("text/htm")) > 0);
+        RUNIT_ASSERT(dstr_view_compare(v, dstr_view_make_from_str("text/html")) == 0);
+        RUNIT_ASSERT(dstr_view_compare(v, dstr_view_make_from_str("text/xml")) < 0);
+
+        dstr_clear(&str);
+    }
+
+    // Trim
+    {
+        dstr str = dstr_make_from_str(" \t value \r\n");
+
+        RUNIT_ASSERT(dstr_view_equals(dstr_trim_view(&str), dstr_view_make_from_str("value")));
+        RUNIT_ASSERT(dstr_view_equals(dstr_view_ltrim(dstr_view_make_from_dstr(&str)), dstr_view_make_from_str("value \r\n")));
+        RUNIT_ASSERT(dstr_view_equals(dstr_view_rtrim(dstr_view_make_from_dstr(&str)), dstr_view_make_from_str(" \t value")));
+        RUNIT_ASSERT(dstr_size(&str) == 11);
+
+        dstr_clear(&str);
+    }
+
+    // Append and assign views of the same string
+    {
+        dstr str = dstr_make_from_str("0123456789");
+        dstr copy = dstr_make_from_view(dstr_substr(&str, 2, 3));
+
+        RUNIT_ASSERT(dstr_compare_str(&copy, "234") == 0);
+
+        // Grows, the view is moved with the data
+        dstr_append_view(&str, dstr_view_make_from_dstr(&str));
+        dstr_append_view(&str, dstr_view_make_from_dstr(&str));
+        RUNIT_ASSERT(dstr_compare_str(&str, "0123456789012345678901234567890123456789") == 0);
+
+        dstr_assign_view(&str, dstr_substr(&str, 35, 5));
+        RUNIT_ASSERT(dstr_compare_str(&str, "56789") == 0);
+
+        dstr_assign_view(&copy, dstr_view_make_from_str("from a view"));
+        RUNIT_ASSERT(dstr_compare_str(&copy, "from a view") == 0);
+
+        dstr_clear(&str);
+        dstr_clear(&copy);
+    }
+} // dstr_view_test
+
+void dstr_shared_test() {
+
+    printf("dstr_shared_test\n");
+
+    counting_allocator_data data = { 0, 0, 0 };
+    dstr_allocator counting = {
+        counting_alloc,
+        counting_realloc,
+        counting_free,
+        &data
+    };
+
+    const char* payload = "a payload large enough to be allocated";
+
+    // Copies share the buffer until they are modified
+    {
+        dstr str;
+        dstr copies[8];
+        size_t i;
+
+        dstr_init_with_allocator(&str, &counting);
+        dstr_assign_str(&str, payload);
+        RUNIT_ASSERT(data.alloc_count == 1);
+        RUNIT_ASSERT(!dstr_is_shared(&str));
+
+        for (i = 0; i < 8; ++i) {
+            copies[i] = dstr_make_shared(&str);
+        }
+
+        RUNIT_ASSERT(data.alloc_count == 1);
+        RUNIT_ASSERT(dstr_is_shared(&str));
+        RUNIT_ASSERT(dstr_data(&copies[7]) == dstr_data(&str));
+        RUNIT_ASSERT(dstr_get_allocator(&copies[7]) == &counting);
+
+        dstr_append_char(&copies[0], '!');
+        dstr_insert(&copies[1], dstr_begin(&copies[1]), '>');
+        dstr_erase(&copies[2], dstr_begin(&copies[2]));
+        dstr_replace_with_str(&copies[3], 0, 1, "A");
+        dstr_pop_back(&copies[4]);
+        dstr_to_upper(&copies[5]);
+
+        RUNIT_ASSERT(data.alloc_count == 7);
+        RUNIT_ASSERT(dstr_compare_str(&str, payload) == 0);
+        RUNIT_ASSERT(dstr_compare_str(&copies[0], "a payload large enough to be allocated!") == 0);
+        RUNIT_ASSERT(dstr_compare_str(&copies[1], ">a payload large enough to be allocated") == 0);
+        RUNIT_ASSERT(dstr_compare_str(&copies[2], " payload large enough to be allocated") == 0);
+        RUNIT_ASSERT(dstr_compare_str(&copies[3], "A payload large enough to be allocated") == 0);
+        RUNIT_ASSERT(dstr_compare_str(&copies[4], "a payload large enough to be allocate") == 0);
+        RUNIT_ASSERT(dstr_compare_str(&copies[5], "A PAYLOAD LARGE ENOUGH TO BE ALLOCATED") == 0);
+        RUNIT_ASSERT(dstr_compare_str(&copies[6], payload) == 0);
+
+        // Released by the last owner, whatever the order
+        dstr_clear(&str);
+        RUNIT_ASSERT(data.free_count == 0);
+        RUNIT_ASSERT(dstr_compare_str(&copies[7], payload) == 0);
+
+        for (i = 0; i < 8; ++i) {
+            dstr_clear(&copies[i]);
+        }
+        RUNIT_ASSERT(data.alloc_count == data.free_count);
+        RUNIT_ASSERT(data.bytes_in_use == 0);
+    }
+
+    // Assign, trim and find_and_replace never modify the other strings
+    {
+        dstr str = dstr_make_from_str("  spaces around a string long enough to be allocated  ");
+        dstr copy = dstr_make_shared(&str);
+        dstr other = dstr_make_shared(&str);
+        dstr small = dstr_make_from_str("small");
+
+        dstr_trim(&copy);
+        RUNIT_ASSERT(dstr_compare_str(&copy, "spaces around a string long enough to be allocated") == 0);
+
+        dstr_find_and_replace(&other, "a", "");
+        RUNIT_ASSERT(dstr_compare_str(&other, "  spces round  string long enough to be llocted  ") == 0);
+        RUNIT_ASSERT(dstr_compare_str(&str, "  spaces around a string long enough to be allocated  ") == 0);
+
+        dstr_assign_shared(&other, &str);
+        dstr_assign_str(&other, "assigned");
+        RUNIT_ASSERT(!dstr_is_shared(&str));
+        RUNIT_ASSERT(dstr_compare_str(&str, "  spaces around a string long enough to be allocated  ") == 0);
+
+        // Inline strings are copied
+        dstr_assign_shared(&other, &small);
+        RUNIT_ASSERT(dstr_compare_str(&other, "small") == 0);
+        RUNIT_ASSERT(dstr_data(&other) != dstr_data(&small));
+
+        // Views of a shared buffer
+        dstr_assign_shared(&copy, &str);
+        dstr_assign_view(&copy, dstr_substr(&copy, 2, 6));
+        RUNIT_ASSERT(dstr_compare_str(&copy, "spaces") == 0);
+        RUNIT_ASSERT(dstr_compare_str(&str, "  spaces around a string long enough to be allocated  ") == 0);
+
+        dstr_assign_shared(&copy, &str);
+        dstr_unshare(&copy);
+        RUNIT_ASSERT(!dstr_is_shared(&copy) && !dstr_is_shared(&str));
+        RUNIT_ASSERT(dstr_data(&copy) != dstr_data(&str));
+
+        dstr_clear(&str);
+        dstr_clear(&copy);
+        dstr_clear(&other);
+        dstr_clear(&small);
+    }
+} // dstr_shared_test
+
+void dstr_join_test() {
+
+    printf("dstr_join_test\n");
+
+    counting_allocator_data data = { 0, 0, 0 };
+    dstr_allocator counting = {
+        counting_alloc,
+        counting_realloc,
+        counting_free,
+        &data
+    };
+
+    // Single allocation
+    {
+        dstr str;
+        dstr_view pieces[1000];
+        size_t i;
+
+        for (i = 0; i < 1000; ++i) {
+            pieces[i] = dstr_view_make_from_str(i % 2 ? "usr" : "local");
+        }
+
+        dstr_init_with_allocator(&str, &counting);
+        dstr_join(&str, dstr_view_make_from_str("/"), pieces, 1000);
+
+        RUNIT_ASSERT(data.alloc_count == 1);
+        RUNIT_ASSERT(dstr_size(&str) == 500 * 5 + 500 * 3 + 999);
+        RUNIT_ASSERT(dstr_capacity(&str) == dstr_size(&str) + 1);
+        RUNIT_ASSERT(dstr_starts_with(&str, dstr_view_make_from_str("local/usr/local/")));
+        RUNIT_ASSERT(dstr_ends_with(&str, dstr_view_make_from_str("/local/usr")));
+
+        dstr_clear(&str);
+    }
+
+    {
+        dstr str = dstr_make_from_str("a,");
+        dstr fields[3];
+        dstr_view views[3];
+
+        fields[0] = dstr_make_from_str("b");
+        fields[1] = dstr_make_from_str("");
+        fields[2] = dstr_make_from_str("a field long enough to be allocated");
+
+        dstr_join_dstr(&str, dstr_view_make_from_str(","), fields, 3);
+        RUNIT_ASSERT(dstr_compare_str(&str, "a,b,,a field long enough to be allocated") == 0);
+
+        dstr_append_many_dstr(&str, fields, 3);
+        RUNIT_ASSERT(dstr_compare_str(&str, "a,b,,a field long enough to be allocatedba field long enough to be allocated") == 0);
+
+        // Nothing to append
+        dstr_join_dstr(&str, dstr_view_make_from_str(","), fields, 0);
+        dstr_append_many(&str, views, 0);
+        RUNIT_ASSERT(dstr_size(&str) == 76);
+
+        // Pieces and separator inside the string, the string itself as a piece
+        dstr_assign_str(&str, "xy");
+        views[0] = dstr_substr(&str, 1, 1);
+        views[1] = dstr_substr(&str, 0, 2);
+        views[2] = dstr_view_make_from_str("z");
+        dstr_join(&str, dstr_substr(&str, 0, 1), views, 3);
+        RUNIT_ASSERT(dstr_compare_str(&str, "xyyxxyxz") == 0);
+
+        dstr_assign_shared(&fields[0], &fields[2]);
+        dstr_append_many_dstr(&fields[2], fields, 3);
+        RUNIT_ASSERT(dstr_compare_str(&fields[0], "a field long enough to be allocated") == 0);
+        RUNIT_ASSERT(dstr_size(&fields[2]) == 35 * 3);
+
+        dstr_clear(&str);
+        dstr_clear(&fields[0]);
+        dstr_clear(&fields[1]);
+        dstr_clear(&fields[2]);
+    }
+} // dstr_join_test
+
 void print_dstr(const dstr* s) {
 
-    printf("[\"%s\"]", s->data);
-    // or printf("[\"%.*s\"]", s->size, s->data);
-    printf("[s:%d]", s->size);
-    printf("[c:%d]", s->capacity);
+    printf("[\"%s\"]", dstr_data(s));
+    // or printf("[\"%.*s\"]", dstr_size(s), dstr_data(s));
+    printf("[s:%d]", dstr_size(s));
+    printf("[c:%d]", dstr_capacity(s));
 }
 
 void print_dstr_ln(const dstr* s) {
@@ -0,0 +1,207 @@
+
+#include "string.h"
+#include "assert.h"
+
+#include "../dstr_tokenizer.h"
+#include "../runit.h"
+
+// Helpers
+// Joins all tokens with '|'
+void tokenizer_join(dstr_tokenizer* tk, dstr* result);
+
+// Tests
+void dstr_tokenizer_char_test();
+void dstr_tokenizer_any_test();
+void dstr_tokenizer_str_test();
+void dstr_tokenizer_options_test();
+void dstr_tokenizer_many_fields_test();
+
+void dstr_tokenizer_testsuite() {
+
+    printf("dstr_tokenizer_testsuite\n");
+
+    dstr_tokenizer_char_test();
+    dstr_tokenizer_any_test();
+    dstr_tokenizer_str_test();
+    dstr_tokenizer_options_test();
+    dstr_tokenizer_many_fields_test();
+}
+
+void tokenizer_join(dstr_tokenizer* tk, dstr* result) {
+
+    int first = 1;
+
+    dstr_assign_str(result, "");
+
+    while (dstr_tokenizer_next(tk)) {
+        if (!first) {
+            dstr_append_char(result, '|');
+        }
+        dstr_append_view(result, tk->token);
+        first = 0;
+    }
+}
+
+void dstr_tokenizer_char_test() {
+
+    printf("dstr_tokenizer_char_test\n");
+
+    {
+        const char* line = "id,name,,email,";
+        dstr_tokenizer tk;
+        dstr result = dstr_make();
+
+        dstr_tokenizer_init_char(&tk, line, strlen(line), ',');
+
+        // Tokens point inside the input
+        RUNIT_ASSERT(dstr_tokenizer_next(&tk) && tk.token.data == line && tk.token.size == 2);
+        RUNIT_ASSERT(dstr_tokenizer_next(&tk) && tk.token.data == line + 3 && tk.token.size == 4);
+
+        dstr_tokenizer_init_char(&tk, line, strlen(line), ',');
+        tokenizer_join(&tk, &result);
+        RUNIT_ASSERT(dstr_compare_str(&result, "id|name||email|") == 0);
+
+        // Empty input is one empty token
+        dstr_tokenizer_init_char(&tk, line, 0, ',');
+        RUNIT_ASSERT(dstr_tokenizer_next(&tk) && tk.token.size == 0);
+        RUNIT_ASSERT(!dstr_tokenizer_next(&tk));
+        RUNIT_ASSERT(!dstr_tokenizer_next(&tk));
+
+        dstr_clear(&result);
+    }
+}
+
+void dstr_tokenizer_any_test() {
+
+    printf("dstr_tokenizer_any_test\n");
+
+    {
+        const char* text = "GET /index.html HTTP/1.1\r\nHost: example.com\r\n";
+        const char* large_set = "abcdefghijklmnopqrstuvwxyz";
+        dstr_tokenizer tk;
+        dstr result = dstr_make();
+
+        dstr_tokenizer_init_any(&tk, text, strlen(text), " \r\n", 3);
+        dstr_tokenizer_skip_empty(&tk, 1);
+        tokenizer_join(&tk, &result);
+        RUNIT_ASSERT(dstr_compare_str(&result, "GET|/index.html|HTTP/1.1|Host:|example.com") == 0);
+
+        // Not scanned with SIMD
+        dstr_tokenizer_init_any(&tk, text, strlen(text), large_set, strlen(large_set));
+        dstr_tokenizer_skip_empty(&tk, 1);
+        tokenizer_join(&tk, &result);
+        RUNIT_ASSERT(dstr_compare_str(&result, "GET /|.| HTTP/1.1\r\nH|: |.|\r\n") == 0);
+
+        dstr_clear(&result);
+    }
+}
+
+void dstr_tokenizer_str_test() {
+
+    printf("dstr_tokenizer_str_test\n");
+
+    {
+        dstr text = dstr_make_from_str("a::b:c::::d::");
+        dstr delimiter = dstr_make_from_str("::");
+        dstr_tokenizer tk;
+        dstr result = dstr_make();
+
+        dstr_tokenizer_init_dstr(&tk, &text, &delimiter);
+        tokenizer_join(&tk, &result);
+        RUNIT_ASSERT(dstr_compare_str(&result, "a|b:c||d|") == 0);
+
+        dstr_tokenizer_init_dstr(&tk, &text, &delimiter);
+        dstr_tokenizer_skip_empty(&tk, 1);
+        tokenizer_join(&tk, &result);
+        RUNIT_ASSERT(dstr_compare_str(&result, "a|b:c|d") == 0);
+
+        // Empty delimiter
+        dstr_tokenizer_init_str(&tk, dstr_data(&text), dstr_size(&text), "", 0);
+        tokenizer_join(&tk, &result);
+        RUNIT_ASSERT(dstr_compare_dstr(&result, &text) == 0);
+
+        dstr_clear(&text);
+        dstr_clear(&delimiter);
+        dstr_clear(&result);
+    }
+}
+
+void dstr_tokenizer_options_test() {
+
+    printf("dstr_tokenizer_options_test\n");
+
+    {
+        const char* text = "  key   value with  spaces ";
+        dstr_tokenizer tk;
+        dstr result = dstr_make();
+
+        dstr_tokenizer_init_char(&tk, text, strlen(text), ' ');
+        dstr_tokenizer_max_splits(&tk, 1);
+        tokenizer_join(&tk, &result);
+        RUNIT_ASSERT(dstr_compare_str(&result, "| key   value with  spaces ") == 0);
+
+        dstr_tokenizer_init_char(&tk, text, strlen(text), ' ');
+        dstr_tokenizer_skip_empty(&tk, 1);
+        dstr_tokenizer_max_splits(&tk, 1);
+        tokenizer_join(&tk, &result);
+        RUNIT_ASSERT(dstr_compare_str(&result, "key|value with  spaces ") == 0);
+
+        dstr_tokenizer_init_char(&tk, text, strlen(text), ' ');
+        dstr_tokenizer_max_splits(&tk, 0);
+        tokenizer_join(&tk, &result);
+        RUNIT_ASSERT(dstr_compare_str(&result, text) == 0);
+
+        dstr_tokenizer_init_str(&tk, "a--b--c--d", 10, "--", 2);
+        dstr_tokenizer_max_splits(&tk, 2);
+        tokenizer_join(&tk, &result);
+        RUNIT_ASSERT(dstr_compare_str(&result, "a|b|c--d") == 0);
+
+        dstr_clear(&result);
+    }
+}
+
+// Compares with a naive split on fields crossing SIMD blocks
+void dstr_tokenizer_many_fields_test() {
+
+    printf("dstr_tokenizer_many_fields_test\n");
+
+    {
+        dstr line = dstr_make();
+        dstr_tokenizer tk;
+        size_t field_count = 0;
+        size_t expected_count = 0;
+        size_t start = 0;
+        int all_equal = 1;
+        size_t i;
+
+        for (i = 0; i < 3000; ++i) {
+            dstr_append_nchar(&line, i % 37, (char)('a' + i % 26));
+            dstr_append_char(&line, i % 5 ? ',' : ';');
+        }
+
+        dstr_tokenizer_init_any(&tk, dstr_data(&line), dstr_size(&line), ",;", 2);
+
+        for (i = 0; i <= dstr_size(&line); ++i) {
+            if (i == dstr_size(&line) || dstr_data(&line)[i] == ',' || dstr_data(&line)[i] == ';') {
+                all_equal &= dstr_tokenizer_next(&tk)
+                    && tk.token.data == dstr_data(&line) + start
+                    && tk.token.size == i - start;
+                start = i + 1;
+                ++expected_count;
+            }
+        }
+        all_equal &= !dstr_tokenizer_next(&tk);
+        RUNIT_ASSERT(all_equal, "dstr_tokenizer differs from naive split");
+        RUNIT_ASSERT(expected_count == 3001);
+
+        dstr_tokenizer_init_char(&tk, dstr_data(&line), dstr_size(&line), ';');
+        dstr_tokenizer_skip_empty(&tk, 1);
+        while (dstr_tokenizer_next(&tk)) {
+            ++field_count;
+        }
+        // The first field of each group of 5 is empty when i % 37 == 0
+        RUNIT_ASSERT(field_count == 600);
+
+        dstr_clear(&line);
+    }
+}
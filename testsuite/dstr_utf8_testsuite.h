@@ -0,0 +1,242 @@
+
+#include "string.h"
+#include "assert.h"
+
+#include "../dstr_utf8.h"
+#include "../runit.h"
+#include "test_random.h"
+
+// Helpers
+int utf8_naive_validate(const unsigned char* p, size_t size);
+
+// Tests
+void dstr_utf8_validate_test();
+void dstr_utf8_validate_random_test();
+void dstr_utf8_length_test();
+
+void dstr_utf8_testsuite() {
+
+    printf("dstr_utf8_testsuite\n");
+
+    test_random_seed(4321);
+
+    dstr_utf8_validate_test();
+    dstr_utf8_validate_random_test();
+    dstr_utf8_length_test();
+}
+
+// Decodes code points and checks their range.
+int utf8_naive_validate(const unsigned char* p, size_t size) {
+
+    size_t i = 0;
+
+    while (i < size) {
+        unsigned int c = p[i];
+        unsigned int code_point;
+        size_t n;
+        size_t k;
+
+        if (c < 0x80)               { n = 1; code_point = c; }
+        else if ((c & 0xE0) == 0xC0) { n = 2; code_point = c & 0x1F; }
+        else if ((c & 0xF0) == 0xE0) { n = 3; code_point = c & 0x0F; }
+        else if ((c & 0xF8) == 0xF0) { n = 4; code_point = c & 0x07; }
+        else return 0;
+
+        if (i + n > size) {
+            return 0;
+        }
+        for (k = 1; k < n; ++k) {
+            if ((p[i + k] & 0xC0) != 0x80) {
+                return 0;
+            }
+            code_point = (code_point << 6) | (p[i + k] & 0x3F);
+        }
+
+        if ((n == 2 && code_point < 0x80)
+            || (n == 3 && code_point < 0x800)
+            || (n == 4 && code_point < 0x10000)
+            || (code_point >= 0xD800 && code_point <= 0xDFFF)
+            || code_point > 0x10FFFF) {
+            return 0;
+        }
+        i += n;
+    }
+
+    return 1;
+}
+
+void dstr_utf8_validate_test() {
+
+    printf("dstr_utf8_validate_test\n");
+
+    {
+        const char* valid[] = {
+            "",
+            "ascii only",
+            "caf\xC3\xA9",
+            "\xE2\x82\xAC",         // U+20AC
+            "\xF0\x9F\x98\x80",     // U+1F600
+            "\xED\x9F\xBF",         // U+D7FF, before surrogates
+            "\xEE\x80\x80",         // U+E000, after surrogates
+            "\xF4\x8F\xBF\xBF",     // U+10FFFF
+            "\xC2\x80\xDF\xBF\xE0\xA0\x80\xEF\xBF\xBF\xF0\x90\x80\x80" // first and last of each size
+        };
+        const char* invalid[] = {
+            "\x80",                 // lone continuation
+            "\xC3",                 // truncated
+            "\xE2\x82",             // truncated
+            "\xF0\x9F\x98",         // truncated
+            "\xC0\xAF",             // overlong
+            "\xC1\xBF",             // overlong
+            "\xE0\x9F\xBF",         // overlong
+            "\xF0\x8F\xBF\xBF",     // overlong
+            "\xED\xA0\x80",         // surrogate
+            "\xED\xBF\xBF",         // surrogate
+            "\xF4\x90\x80\x80",     // above U+10FFFF
+            "\xF5\x80\x80\x80",     // above U+10FFFF
+            "\xFF",
+            "\xC3\xA9\xA9",         // extra continuation
+            "\xE2\x28\xA1"          // ASCII instead of continuation
+        };
+        size_t i;
+
+        for (i = 0; i < sizeof(valid) / sizeof(valid[0]); ++i) {
+            RUNIT_ASSERT(dstr_utf8_validate_bytes(valid[i], strlen(valid[i])), valid[i]);
+        }
+        for (i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+            RUNIT_ASSERT(!dstr_utf8_validate_bytes(invalid[i], strlen(invalid[i])), invalid[i]);
+        }
+
+        // '\0' is a valid code point
+        RUNIT_ASSERT(dstr_utf8_validate_bytes("a\0b", 3));
+    }
+
+    // Errors at every position of large inputs (SIMD blocks and tail)
+    {
+        char text[100];
+        int all_equal = 1;
+        size_t size;
+        size_t pos;
+
+        for (size = 1; size < sizeof(text); ++size) {
+            for (pos = 0; pos < size; ++pos) {
+                dstr s;
+
+                memset(text, 'a', size);
+
+                // Sequence cut by the end, or by the start of the next block
+                text[pos] = (char)0xE2;
+                s = dstr_make_from_range(text, text + size);
+                all_equal &= !dstr_utf8_validate(&s);
+
+                // Complete sequence across blocks
+                if (pos + 3 <= size) {
+                    text[pos + 1] = (char)0x82;
+                    text[pos + 2] = (char)0xAC;
+                    dstr_assign_range(&s, text, text + size);
+                    all_equal &= dstr_utf8_validate(&s);
+                }
+
+                dstr_clear(&s);
+            }
+        }
+
+        RUNIT_ASSERT(all_equal, "invalid UTF-8 not detected at some position");
+    }
+}
+
+void dstr_utf8_validate_random_test() {
+
+    printf("dstr_utf8_validate_random_test\n");
+
+    {
+        const char* pieces[] = {
+            "a", "z", " ", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xF4\x8F\xBF\xBF", "\xED\x9F\xBF"
+        };
+        unsigned char text[300];
+        int all_equal = 1;
+        size_t round;
+
+        for (round = 0; round < 3000; ++round) {
+
+            size_t size = 0;
+            size_t target = test_random() % 280;
+            size_t mutations = test_random() % 3;
+
+            while (size < target) {
+                const char* piece = pieces[test_random() % 8];
+                memcpy(text + size, piece, strlen(piece));
+                size += strlen(piece);
+            }
+
+            // Random bytes make invalid (and sometimes still valid) sequences
+            while (size && mutations--) {
+                text[test_random() % size] = (unsigned char)(0x80 + test_random() % 0x80);
+            }
+
+            all_equal &= dstr_utf8_validate_bytes(text, size) == utf8_naive_validate(text, size);
+            all_equal &= _dstr_utf8_validate_scalar(text, size) == utf8_naive_validate(text, size);
+        }
+
+        RUNIT_ASSERT(all_equal, "dstr_utf8_validate differs from naive validation");
+    }
+}
+
+void dstr_utf8_length_test() {
+
+    printf("dstr_utf8_length_test\n");
+
+    {
+        // Code points of 1, 2, 3 and 4 bytes
+        dstr s = dstr_make_from_str("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80 and more text to use SIMD blocks \xE2\x82\xAC!");
+
+        RUNIT_ASSERT(dstr_utf8_length(&s) == 4 + 34 + 2);
+
+        RUNIT_ASSERT(dstr_utf8_truncated_size(dstr_data(&s), dstr_size(&s), 0) == 0);
+        RUNIT_ASSERT(dstr_utf8_truncated_size(dstr_data(&s), dstr_size(&s), 2) == 3);
+        RUNIT_ASSERT(dstr_utf8_truncated_size(dstr_data(&s), dstr_size(&s), 3) == 6);
+        RUNIT_ASSERT(dstr_utf8_truncated_size(dstr_data(&s), dstr_size(&s), 39) == dstr_size(&s) - 1);
+        RUNIT_ASSERT(dstr_utf8_truncated_size(dstr_data(&s), dstr_size(&s), 40) == dstr_size(&s));
+        RUNIT_ASSERT(dstr_utf8_truncated_size(dstr_data(&s), dstr_size(&s), 1000) == dstr_size(&s));
+
+        dstr_utf8_truncate(&s, 3);
+        RUNIT_ASSERT(dstr_compare_str(&s, "a\xC3\xA9\xE2\x82\xAC") == 0);
+
+        dstr_utf8_truncate(&s, 10);
+        RUNIT_ASSERT(dstr_size(&s) == 6);
+
+        dstr_clear(&s);
+    }
+
+    // Compare with a naive count at every prefix
+    {
+        const char* text = "\xE2\x82\xAC" "abc" "\xF0\x9F\x98\x80\xF0\x9F\x98\x80" "de" "\xC3\xA9\xC3\xA9\xC3\xA9" "fghijklmnopqrstuvwxyz" "\xE2\x82\xAC";
+        size_t size = strlen(text);
+        size_t total = 0;
+        int all_equal = 1;
+        size_t count;
+        size_t i;
+
+        for (i = 0; i < size; ++i) {
+            total += ((unsigned char)text[i] & 0xC0) != 0x80;
+        }
+
+        for (count = 0; count < 50; ++count) {
+            size_t seen = 0;
+            size_t expected = size;
+            for (i = 0; i < size; ++i) {
+                if (((unsigned char)text[i] & 0xC0) != 0x80) {
+                    if (seen == count) {
+                        expected = i;
+                        break;
+                    }
+                    ++seen;
+                }
+            }
+            all_equal &= dstr_utf8_truncated_size(text, size, count) == expected;
+            all_equal &= dstr_utf8_length_bytes(text, expected) == (count < total ? count : total);
+        }
+
+        RUNIT_ASSERT(all_equal, "dstr_utf8_truncated_size differs from naive count");
+    }
+}
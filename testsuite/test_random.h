@@ -0,0 +1,19 @@
+#ifndef RE_TEST_RANDOM_H
+#define RE_TEST_RANDOM_H
+
+// Deterministic pseudo random numbers (LCG) shared by the testsuites,
+// each testsuite sets its seed to not depend on the ones running before.
+
+static unsigned int test_random_state = 1;
+
+static void test_random_seed(unsigned int seed) {
+    test_random_state = seed;
+}
+
+// Returns a value in [0, 0x7FFF]
+static unsigned int test_random() {
+    test_random_state = test_random_state * 1103515245u + 12345u;
+    return (test_random_state >> 16) & 0x7FFF;
+}
+
+#endif // RE_TEST_RANDOM_H